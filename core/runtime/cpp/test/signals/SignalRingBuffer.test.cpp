@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <xrpa-runtime/signals/SignalRingBuffer.h>
+
+using namespace Xrpa;
+
+constexpr int NUM_CHANNELS = 2;
+
+static std::vector<uint32_t> makeInterleavedFrames(uint32_t startFrame, int frameCount) {
+  std::vector<uint32_t> samples(frameCount * NUM_CHANNELS);
+  for (int frameIdx = 0; frameIdx < frameCount; ++frameIdx) {
+    for (int channelIdx = 0; channelIdx < NUM_CHANNELS; ++channelIdx) {
+      samples[frameIdx * NUM_CHANNELS + channelIdx] = (startFrame + frameIdx) * 10 + channelIdx;
+    }
+  }
+  return samples;
+}
+
+TEST(SignalRingBuffer, WriteRead) {
+  SignalRingBuffer<uint32_t> ringBuffer;
+  ringBuffer.initialize(16, 0, NUM_CHANNELS);
+  EXPECT_EQ(ringBuffer.getReadFramesAvailable(), 0);
+  EXPECT_EQ(ringBuffer.getWriteFramesAvailable(), 16);
+
+  auto input = makeInterleavedFrames(0, 10);
+  EXPECT_EQ(ringBuffer.writeInterleavedData(input.data(), 10), 10);
+  EXPECT_EQ(ringBuffer.getReadFramesAvailable(), 10);
+  EXPECT_EQ(ringBuffer.getWriteFramesAvailable(), 6);
+
+  std::vector<uint32_t> output(6 * NUM_CHANNELS);
+  EXPECT_TRUE(ringBuffer.readInterleavedData(output.data(), 6));
+  EXPECT_EQ(output, makeInterleavedFrames(0, 6));
+  EXPECT_EQ(ringBuffer.getReadFramesAvailable(), 4);
+}
+
+TEST(SignalRingBuffer, FillCompletelyAndWrap) {
+  SignalRingBuffer<uint32_t> ringBuffer;
+  ringBuffer.initialize(8, 0, NUM_CHANNELS);
+
+  // a completely full ring buffer must not look empty
+  auto input = makeInterleavedFrames(0, 10);
+  EXPECT_EQ(ringBuffer.writeInterleavedData(input.data(), 10), 8);
+  EXPECT_EQ(ringBuffer.getReadFramesAvailable(), 8);
+  EXPECT_EQ(ringBuffer.getWriteFramesAvailable(), 0);
+
+  std::vector<uint32_t> output(5 * NUM_CHANNELS);
+  EXPECT_TRUE(ringBuffer.readInterleavedData(output.data(), 5));
+  EXPECT_EQ(output, makeInterleavedFrames(0, 5));
+
+  // this write straddles the end of the ring buffer
+  input = makeInterleavedFrames(8, 5);
+  EXPECT_EQ(ringBuffer.writeInterleavedData(input.data(), 5), 5);
+  EXPECT_EQ(ringBuffer.getReadFramesAvailable(), 8);
+
+  output.resize(8 * NUM_CHANNELS);
+  EXPECT_TRUE(ringBuffer.readInterleavedData(output.data(), 8));
+  EXPECT_EQ(output, makeInterleavedFrames(5, 8));
+}
+
+TEST(SignalRingBuffer, WarmupAndUnderflow) {
+  SignalRingBuffer<uint32_t> ringBuffer;
+  ringBuffer.initialize(16, 4, NUM_CHANNELS);
+
+  auto input = makeInterleavedFrames(0, 3);
+  ringBuffer.writeInterleavedData(input.data(), 3);
+
+  // below the warmup threshold, so nothing is returned
+  std::vector<uint32_t> output(2 * NUM_CHANNELS, 1);
+  ringBuffer.readInterleavedData(output.data(), 2);
+  EXPECT_EQ(output, std::vector<uint32_t>(2 * NUM_CHANNELS, 0));
+  EXPECT_EQ(ringBuffer.getReadFramesAvailable(), 3);
+
+  input = makeInterleavedFrames(3, 2);
+  ringBuffer.writeInterleavedData(input.data(), 2);
+  EXPECT_TRUE(ringBuffer.readInterleavedData(output.data(), 2));
+  EXPECT_EQ(output, makeInterleavedFrames(0, 2));
+
+  // underflow returns what is available, zero-fills the rest, and re-enters warmup
+  output.resize(4 * NUM_CHANNELS);
+  EXPECT_FALSE(ringBuffer.readInterleavedData(output.data(), 4));
+  auto expected = makeInterleavedFrames(2, 3);
+  expected.resize(4 * NUM_CHANNELS, 0);
+  EXPECT_EQ(output, expected);
+}
+
+TEST(SignalRingBuffer, ReadDeinterleaved) {
+  SignalRingBuffer<uint32_t> ringBuffer;
+  ringBuffer.initialize(16, 0, NUM_CHANNELS);
+
+  auto input = makeInterleavedFrames(0, 4);
+  ringBuffer.writeInterleavedData(input.data(), 4);
+
+  std::vector<uint32_t> output(NUM_CHANNELS * 4);
+  EXPECT_TRUE(ringBuffer.readDeinterleavedData(output.data(), 4, 4));
+  EXPECT_EQ(output, std::vector<uint32_t>({0, 10, 20, 30, 1, 11, 21, 31}));
+}
+
+TEST(SignalRingBuffer, ProducerConsumerStress) {
+  constexpr int RING_FRAMES = 97; // deliberately not a power of two
+  constexpr int TOTAL_FRAMES = 200000;
+
+  SignalRingBuffer<uint32_t> ringBuffer;
+  ringBuffer.initialize(RING_FRAMES, 0, NUM_CHANNELS);
+
+  std::thread producer([&]() {
+    uint32_t nextFrame = 0;
+    int chunkFrames = 1;
+    while (nextFrame < TOTAL_FRAMES) {
+      int framesToWrite = std::min(chunkFrames, TOTAL_FRAMES - static_cast<int>(nextFrame));
+      auto input = makeInterleavedFrames(nextFrame, framesToWrite);
+      int framesWritten = ringBuffer.writeInterleavedData(input.data(), framesToWrite);
+      nextFrame += framesWritten;
+      chunkFrames = chunkFrames % 31 + 1;
+      if (framesWritten == 0) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t nextFrame = 0;
+  int chunkFrames = 1;
+  bool isValid = true;
+  std::vector<uint32_t> output;
+  while (nextFrame < TOTAL_FRAMES && isValid) {
+    // only read what is available, so the consumer never underflows into zero-fill
+    int framesToRead = std::min(chunkFrames, ringBuffer.getReadFramesAvailable());
+    chunkFrames = chunkFrames % 29 + 1;
+    if (framesToRead == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    output.resize(framesToRead * NUM_CHANNELS);
+    ringBuffer.readInterleavedData(output.data(), framesToRead);
+    for (int frameIdx = 0; frameIdx < framesToRead && isValid; ++frameIdx, ++nextFrame) {
+      for (int channelIdx = 0; channelIdx < NUM_CHANNELS; ++channelIdx) {
+        isValid &= output[frameIdx * NUM_CHANNELS + channelIdx] == nextFrame * 10 + channelIdx;
+      }
+    }
+  }
+
+  producer.join();
+  EXPECT_TRUE(isValid);
+  EXPECT_EQ(nextFrame, TOTAL_FRAMES);
+  EXPECT_EQ(ringBuffer.getReadFramesAvailable(), 0);
+}
@@ -22,12 +22,17 @@
 #include <xrpa-runtime/reconciler/ObjectCollectionIndexedBinding.h>
 #include <xrpa-runtime/signals/InboundSignalData.h>
 #include <xrpa-runtime/signals/OutboundSignalData.h>
+#include <xrpa-runtime/transport/TransportLockDomain.h>
 #include <xrpa-runtime/transport/TransportStreamAccessor.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
+#include <atomic>
 #include <cmath>
 #include <string>
+#include <thread>
 #include <utility>
 
+#include "./DataStoreReconciler.test.h"
+
 using namespace Xrpa;
 using namespace std::chrono_literals;
 using id_vector = std::vector<ObjectUuid>;
@@ -248,6 +253,9 @@ class FooTypeLocal : public Xrpa::DataStoreObject {
   }
 
   void processDSUpdate(FooTypeReader& value, uint64_t fieldsChanged) {
+    value.checkRecordExtent(
+        (fieldsChanged & FooTypeReader::aChangedBit ? FooTypeReader::aByteCount : 0) +
+        (fieldsChanged & FooTypeReader::bChangedBit ? FooTypeReader::bByteCount : 0));
     if (fieldsChanged & FooTypeReader::aChangedBit) {
       a_ = value.getA();
     }
@@ -593,14 +601,16 @@ class OutboundFooType : public Xrpa::DataStoreObject {
   void writeDSChanges(TransportStreamAccessor* accessor) {
     FooTypeWriter objAccessor;
     if (!createWritten_) {
-      createWritten_ = true;
       objAccessor = FooTypeWriter::create(
           accessor, getCollectionId(), getXrpaId(), changeByteCount_, createTimestamp_);
-    }
-    if (objAccessor.isNull()) {
+    } else if (changeBits_ != 0) {
       objAccessor = FooTypeWriter::update(
           accessor, getCollectionId(), getXrpaId(), changeBits_, changeByteCount_);
     }
+    if (objAccessor.isNull()) {
+      return;
+    }
+    createWritten_ = true;
     if (changeBits_ & FooTypeReader::aChangedBit) {
       objAccessor.setA(localA);
     }
@@ -733,12 +743,14 @@ class OutboundBarType : public Xrpa::DataStoreObject {
       changeByteCount_ = BarTypeReader::cByteCount + 4 + MemoryAccessor::dynSizeOfValue(localStr);
       objAccessor = BarTypeWriter::create(
           accessor, getCollectionId(), getXrpaId(), changeByteCount_, createTimestamp_);
-      createWritten_ = true;
-    }
-    if (objAccessor.isNull()) {
+    } else if (changeBits_ != 0) {
       objAccessor = BarTypeWriter::update(
           accessor, getCollectionId(), getXrpaId(), changeBits_, changeByteCount_);
     }
+    if (objAccessor.isNull()) {
+      return;
+    }
+    createWritten_ = true;
     if (changeBits_ & BarTypeReader::cChangedBit) {
       objAccessor.setC(localC);
     }
@@ -812,6 +824,7 @@ class WriteTestDataStore : public DataStoreReconciler {
 static const ObjectUuid foo1ID = ObjectUuid(0, 100);
 static const ObjectUuid foo2ID = ObjectUuid(0, 200);
 static const ObjectUuid foo3ID = ObjectUuid(0, 300);
+static const ObjectUuid foo4ID = ObjectUuid(0, 400);
 static const ObjectUuid myFooID = ObjectUuid(0, 5000);
 
 static const ObjectUuid bar1ID = ObjectUuid(1, 100);
@@ -820,11 +833,16 @@ void RunReadReconcilerTests(
     std::shared_ptr<TransportStream> readerInboundTransport,
     std::shared_ptr<TransportStream> readerOutboundTransport,
     std::shared_ptr<TransportStream> writerInboundTransport,
-    std::shared_ptr<TransportStream> writerOutboundTransport) {
+    std::shared_ptr<TransportStream> writerOutboundTransport,
+    bool deferInboundDispatch,
+    bool stageOutboundChanges) {
   auto reader =
       std::make_shared<ReadTestDataStore>(readerInboundTransport, readerOutboundTransport);
   auto writer =
       std::make_shared<WriteTestDataStore>(writerInboundTransport, writerOutboundTransport);
+  reader->setDeferInboundDispatch(deferInboundDispatch);
+  reader->setStageOutboundChanges(stageOutboundChanges);
+  writer->setStageOutboundChanges(stageOutboundChanges);
 
   // create objects
   {
@@ -1096,6 +1114,35 @@ void RunReadReconcilerTests(
     EXPECT_EQ(reader->FooType->getObject(foo3ID)->myVal_, 0);
     reader->tickOutbound();
   }
+
+  // send some messages directly into the changelog
+  {
+    writer->tickInbound();
+
+    auto foo4 = std::make_shared<OutboundFooType>(foo4ID);
+    writer->FooType->addObject(foo4);
+
+    auto foo3 = writer->FooType->getObject(foo3ID);
+    foo3->sendAddMessage(5);
+
+    writer->transactOutboundMessages([&]() {
+      foo3->sendResetMessage();
+      foo3->sendAddMessage(6);
+      foo4->sendAddMessage(7);
+    });
+
+    writer->tickOutbound();
+  }
+
+  // tick reader, verify the direct messages were handled, in order with the staged one and after
+  // the foo4 create
+  {
+    reader->tickInbound();
+    EXPECT_NE(reader->FooType->getObject(foo4ID).get(), nullptr);
+    EXPECT_EQ(reader->FooType->getObject(foo3ID)->myVal_, 6);
+    EXPECT_EQ(reader->FooType->getObject(foo4ID)->myVal_, 7);
+    reader->tickOutbound();
+  }
 }
 
 void RunReadReconcilerInterruptTests(
@@ -1151,6 +1198,302 @@ void RunReadReconcilerInterruptTests(
   reader->tickOutbound();
 }
 
+void RunSnapshotResyncTests(
+    std::shared_ptr<TransportStream> readerInboundTransport,
+    std::shared_ptr<TransportStream> readerOutboundTransport,
+    std::shared_ptr<TransportStream> writerInboundTransport,
+    std::shared_ptr<TransportStream> writerOutboundTransport) {
+  auto reader =
+      std::make_shared<ReadTestDataStore>(readerInboundTransport, readerOutboundTransport);
+  auto writer =
+      std::make_shared<WriteTestDataStore>(writerInboundTransport, writerOutboundTransport);
+  writer->setSnapshotInterval(0ms);
+
+  // create objects
+  {
+    writer->tickInbound();
+
+    auto foo1 = std::make_shared<OutboundFooType>(foo1ID);
+    writer->FooType->addObject(foo1);
+    foo1->setA(10);
+
+    auto foo2 = std::make_shared<OutboundFooType>(foo2ID);
+    writer->FooType->addObject(foo2);
+
+    writer->tickOutbound();
+  }
+
+  {
+    reader->tickInbound();
+    EXPECT_EQ(reader->FooType->size(), 2);
+    reader->tickOutbound();
+  }
+
+  // overflow the changelog without ticking the reader, refreshing the snapshot on every tick
+  {
+    writer->tickInbound();
+    writer->FooType->removeObject(foo2ID);
+    writer->tickOutbound();
+
+    auto foo1 = writer->FooType->getObject(foo1ID);
+    for (int i = 0; i < 100; ++i) {
+      foo1->setB(i);
+      writer->tickOutbound();
+    }
+  }
+
+  // this change is only in the changelog, after the snapshot
+  {
+    writer->setSnapshotInterval(1h);
+
+    auto foo3 = std::make_shared<OutboundFooType>(foo3ID);
+    writer->FooType->addObject(foo3);
+    foo3->setA(15);
+
+    writer->tickOutbound();
+  }
+
+  // the reader catches up from the snapshot plus the changelog tail in a single tick, without
+  // waiting on a RequestFullUpdate round trip through the writer
+  {
+    reader->tickInbound();
+    EXPECT_EQ(reader->FooType->size(), 2);
+    EXPECT_NE(reader->FooType->getObject(foo1ID).get(), nullptr);
+    EXPECT_EQ(reader->FooType->getObject(foo1ID)->a_, 10);
+    EXPECT_EQ(reader->FooType->getObject(foo1ID)->b_, 99);
+    EXPECT_EQ(reader->FooType->getObject(foo2ID).get(), nullptr);
+    EXPECT_NE(reader->FooType->getObject(foo3ID).get(), nullptr);
+    EXPECT_EQ(reader->FooType->getObject(foo3ID)->a_, 15);
+    reader->tickOutbound();
+  }
+
+  // the reader keeps following the changelog afterwards
+  {
+    writer->tickInbound();
+    writer->FooType->getObject(foo3ID)->setB(7);
+    writer->tickOutbound();
+
+    reader->tickInbound();
+    EXPECT_EQ(reader->FooType->getObject(foo3ID)->b_, 7);
+    reader->tickOutbound();
+  }
+}
+
+void RunTransactRetryTests(
+    std::shared_ptr<TransportStream> readerInboundTransport,
+    std::shared_ptr<TransportStream> readerOutboundTransport,
+    std::shared_ptr<TransportStream> writerInboundTransport,
+    std::shared_ptr<TransportStream> writerOutboundTransport,
+    std::shared_ptr<TransportStream> writerOutboundLockHolder) {
+  auto reader =
+      std::make_shared<ReadTestDataStore>(readerInboundTransport, readerOutboundTransport);
+  auto writer =
+      std::make_shared<WriteTestDataStore>(writerInboundTransport, writerOutboundTransport);
+
+  DataStoreReconciler::TransactRetryPolicy policy;
+  policy.timeout = 1ms;
+  policy.escalatedTimeout = 2s;
+  policy.escalateAfterFailures = 2;
+  writer->setTransactRetryPolicy(policy);
+
+  writer->tickInbound();
+  writer->tickOutbound();
+  EXPECT_EQ(writer->hasPendingTransactions(), false);
+
+  // hold the writer's outbound transport lock from another thread
+  std::atomic<bool> isHoldingLock{false};
+  std::atomic<bool> releaseLock{false};
+  std::thread lockHolderThread([&]() {
+    writerOutboundLockHolder->transact(1s, [&](TransportStreamAccessor* /*accessor*/) {
+      isHoldingLock = true;
+      while (!releaseLock) {
+        std::this_thread::sleep_for(1ms);
+      }
+    });
+  });
+  while (!isHoldingLock) {
+    std::this_thread::yield();
+  }
+
+  // the tick and a direct message transaction time out, leaving the change and the message
+  // pending
+  {
+    writer->tickInbound();
+    auto foo1 = std::make_shared<OutboundFooType>(foo1ID);
+    writer->FooType->addObject(foo1);
+    foo1->setA(10);
+    writer->tickOutbound();
+    EXPECT_EQ(writer->hasPendingTransactions(), true);
+
+    writer->transactOutboundMessages([&]() { foo1->sendAddMessage(5); });
+    EXPECT_EQ(writer->hasPendingTransactions(), true);
+  }
+
+  // after two consecutive failures the escalated timeout outlasts the lock holder
+  {
+    std::thread releaseThread([&]() {
+      std::this_thread::sleep_for(20ms);
+      releaseLock = true;
+    });
+    writer->retryPendingTransactions();
+    EXPECT_EQ(writer->hasPendingTransactions(), false);
+    releaseThread.join();
+    lockHolderThread.join();
+  }
+
+  {
+    reader->tickInbound();
+    EXPECT_EQ(reader->FooType->size(), 1);
+    EXPECT_NE(reader->FooType->getObject(foo1ID).get(), nullptr);
+    EXPECT_EQ(reader->FooType->getObject(foo1ID)->a_, 10);
+    EXPECT_EQ(reader->FooType->getObject(foo1ID)->myVal_, 5);
+    reader->tickOutbound();
+  }
+}
+
+void RunLosslessBackpressureTests(
+    std::shared_ptr<TransportStream> readerInboundTransport,
+    std::shared_ptr<TransportStream> readerOutboundTransport,
+    std::shared_ptr<TransportStream> writerInboundTransport,
+    std::shared_ptr<TransportStream> writerOutboundTransport) {
+  auto reader =
+      std::make_shared<ReadTestDataStore>(readerInboundTransport, readerOutboundTransport);
+  auto writer =
+      std::make_shared<WriteTestDataStore>(writerInboundTransport, writerOutboundTransport);
+
+  // the reader registers its cursor on its first read
+  writer->tickInbound();
+  writer->tickOutbound();
+  reader->tickInbound();
+  reader->tickOutbound();
+
+  // more changes than the changelog holds, so most are refused until the reader catches up
+  constexpr int objectCount = 40;
+  writer->tickInbound();
+  for (int i = 0; i < objectCount; ++i) {
+    auto foo = std::make_shared<OutboundFooType>(ObjectUuid(0, 1000 + i));
+    writer->FooType->addObject(foo);
+    foo->setA(i);
+    foo->setB(i * 2);
+  }
+  writer->tickOutbound();
+  EXPECT_EQ(writer->hasPendingTransactions(), true);
+
+  for (int round = 0; round < objectCount && writer->hasPendingTransactions(); ++round) {
+    reader->tickInbound();
+    writer->retryPendingTransactions();
+  }
+  EXPECT_EQ(writer->hasPendingTransactions(), false);
+  reader->tickInbound();
+
+  // nothing was lost, and the reader never had to request a full update
+  EXPECT_EQ(reader->FooType->size(), objectCount);
+  for (int i = 0; i < objectCount; ++i) {
+    auto foo = reader->FooType->getObject(ObjectUuid(0, 1000 + i));
+    EXPECT_NE(foo.get(), nullptr);
+    if (foo != nullptr) {
+      EXPECT_EQ(foo->a_, i);
+      EXPECT_EQ(foo->b_, i * 2);
+    }
+  }
+  EXPECT_GT(writerOutboundTransport->getMetrics().blockedWrites, 0);
+  EXPECT_EQ(readerInboundTransport->getMetrics().missedEntries, 0);
+}
+
+void RunLockDomainTests(
+    std::shared_ptr<TransportLockDomain> lockDomain,
+    const DatasetTransports& datasetA,
+    const DatasetTransports& datasetB) {
+  auto readerA =
+      std::make_shared<ReadTestDataStore>(datasetA.readerInbound, datasetA.readerOutbound);
+  auto writerA =
+      std::make_shared<WriteTestDataStore>(datasetA.writerInbound, datasetA.writerOutbound);
+  auto readerB =
+      std::make_shared<ReadTestDataStore>(datasetB.readerInbound, datasetB.readerOutbound);
+  auto writerB =
+      std::make_shared<WriteTestDataStore>(datasetB.writerInbound, datasetB.writerOutbound);
+
+  // both data stores tick under a single acquisition; their transactions must not lock again
+  {
+    bool didCoalesce = lockDomain->transact([&]() {
+      writerA->tickInbound();
+      writerB->tickInbound();
+    });
+    EXPECT_EQ(didCoalesce, true);
+
+    auto fooA = std::make_shared<OutboundFooType>(foo1ID);
+    writerA->FooType->addObject(fooA);
+    fooA->setA(10);
+    auto fooB = std::make_shared<OutboundFooType>(foo2ID);
+    writerB->FooType->addObject(fooB);
+    fooB->setA(20);
+
+    didCoalesce = lockDomain->transact([&]() {
+      writerA->tickOutbound();
+      writerB->tickOutbound();
+    });
+    EXPECT_EQ(didCoalesce, true);
+    EXPECT_EQ(writerA->hasPendingTransactions(), false);
+    EXPECT_EQ(writerB->hasPendingTransactions(), false);
+  }
+
+  // hold the domain lock from another thread, which blocks the streams of both data stores
+  std::atomic<bool> isHoldingLock{false};
+  std::atomic<bool> releaseLock{false};
+  std::thread lockHolderThread([&]() {
+    lockDomain->transact(
+        [&]() {
+          isHoldingLock = true;
+          while (!releaseLock) {
+            std::this_thread::sleep_for(1ms);
+          }
+        },
+        1s);
+  });
+  while (!isHoldingLock) {
+    std::this_thread::yield();
+  }
+
+  {
+    writerA->FooType->getObject(foo1ID)->setA(11);
+    writerB->FooType->getObject(foo2ID)->setA(21);
+
+    // the ticks still run, each stream trying the lock on its own
+    bool didCoalesce = lockDomain->transact([&]() {
+      writerA->tickOutbound();
+      writerB->tickOutbound();
+    });
+    EXPECT_EQ(didCoalesce, false);
+    EXPECT_EQ(writerA->hasPendingTransactions(), true);
+    EXPECT_EQ(writerB->hasPendingTransactions(), true);
+
+    releaseLock = true;
+    lockHolderThread.join();
+
+    didCoalesce = lockDomain->transact([&]() {
+      writerA->retryPendingTransactions();
+      writerB->retryPendingTransactions();
+    });
+    EXPECT_EQ(didCoalesce, true);
+    EXPECT_EQ(writerA->hasPendingTransactions(), false);
+    EXPECT_EQ(writerB->hasPendingTransactions(), false);
+  }
+
+  {
+    bool didCoalesce = lockDomain->transact([&]() {
+      readerA->tickInbound();
+      readerB->tickInbound();
+    });
+    EXPECT_EQ(didCoalesce, true);
+    EXPECT_EQ(readerA->FooType->size(), 1);
+    EXPECT_EQ(readerB->FooType->size(), 1);
+    EXPECT_NE(readerA->FooType->getObject(foo1ID).get(), nullptr);
+    EXPECT_NE(readerB->FooType->getObject(foo2ID).get(), nullptr);
+    EXPECT_EQ(readerA->FooType->getObject(foo1ID)->a_, 11);
+    EXPECT_EQ(readerB->FooType->getObject(foo2ID)->a_, 21);
+  }
+}
+
 void RunWriteReconcilerTests(
     std::shared_ptr<TransportStream> readerInboundTransport,
     std::shared_ptr<TransportStream> readerOutboundTransport,
@@ -1279,11 +1622,13 @@ void RunSignalTransportTests(
     std::shared_ptr<TransportStream> readerOutboundTransport,
     std::shared_ptr<TransportStream> writerInboundTransport,
     std::shared_ptr<TransportStream> writerOutboundTransport,
-    bool fromRingBuffer) {
+    bool fromRingBuffer,
+    bool directOutboundMessages) {
   auto writer =
       std::make_shared<WriteTestDataStore>(writerInboundTransport, writerOutboundTransport);
   auto reader =
       std::make_shared<ReadTestDataStore>(readerInboundTransport, readerOutboundTransport);
+  writer->setDirectOutboundMessages(directOutboundMessages);
 
   auto foo1 = std::make_shared<OutboundFooType>(foo1ID);
   writer->FooType->addObject(foo1);
@@ -1299,6 +1644,16 @@ void RunSignalTransportTests(
   writer->tickOutbound();
   EXPECT_EQ(foo1->tickCount_, 1);
 
+  if (directOutboundMessages) {
+    // the next packet goes straight into the transport as the signal source ticks, without
+    // waiting for tickOutbound()
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(SAMPLES_PER_CALLBACK * 1000000 / SAMPLE_RATE + 1000));
+    writerOutboundTransport->resetMetrics();
+    foo1->tickXrpa();
+    EXPECT_EQ(writerOutboundTransport->getMetrics().transactCount, 1);
+  }
+
   reader->tickInbound();
   reader->tickOutbound();
   EXPECT_EQ(reader->FooType->size(), 1);
@@ -1393,4 +1748,37 @@ void RunIndexingTests(
   EXPECT_EQ(reader->FooType->FooIndexedByA.getIndexedObjects(2).size(), 2);
 }
 
+
+TEST(DataStoreReconciler, truncated_update_record) {
+  if constexpr (kBoundsCheckMode == BoundsCheckMode::Unchecked) {
+    GTEST_SKIP() << "bounds checks are compiled out";
+  }
+
+  // a complete record for the object's creation
+  alignas(8) uint8_t fullRecord[FooTypeReader::aByteCount + FooTypeReader::bByteCount] = {};
+  FooTypeWriter fullWriter(MemoryAccessor(fullRecord, 0, sizeof(fullRecord)));
+  fullWriter.setA(10);
+  fullWriter.setB(45.5);
+  FooTypeReader fullReader(MemoryAccessor(fullRecord, 0, sizeof(fullRecord)));
+  FooTypeLocal foo(foo1ID, nullptr, fullReader);
+  EXPECT_EQ(foo.a_, 10);
+  EXPECT_EQ(foo.b_, 45.5);
+
+  // an update that claims both fields changed but only carries the first one
+  alignas(8) uint8_t truncatedRecord[FooTypeReader::aByteCount] = {};
+  FooTypeWriter truncatedWriter(MemoryAccessor(truncatedRecord, 0, sizeof(truncatedRecord)));
+  truncatedWriter.setA(20);
+  FooTypeReader truncatedReader(MemoryAccessor(truncatedRecord, 0, sizeof(truncatedRecord)));
+  EXPECT_THROW(
+      foo.processDSUpdate(
+          truncatedReader, FooTypeReader::aChangedBit | FooTypeReader::bChangedBit),
+      std::runtime_error);
+
+  if constexpr (kBoundsCheckMode == BoundsCheckMode::CheckedOnce) {
+    // the extent check rejects the record before any field is applied
+    EXPECT_EQ(foo.a_, 10);
+  }
+  EXPECT_EQ(foo.b_, 45.5);
+}
+
 } // namespace DataStoreReconcilerTest
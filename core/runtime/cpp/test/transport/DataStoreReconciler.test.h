@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <xrpa-runtime/transport/TransportLockDomain.h>
 #include <xrpa-runtime/transport/TransportStream.h>
 #include <functional>
 #include <memory>
@@ -26,7 +27,9 @@ void RunReadReconcilerTests(
     std::shared_ptr<Xrpa::TransportStream> readerInboundDataset,
     std::shared_ptr<Xrpa::TransportStream> readerOutboundDataset,
     std::shared_ptr<Xrpa::TransportStream> writerInboundDataset,
-    std::shared_ptr<Xrpa::TransportStream> writerOutboundDataset);
+    std::shared_ptr<Xrpa::TransportStream> writerOutboundDataset,
+    bool deferInboundDispatch = false,
+    bool stageOutboundChanges = false);
 
 void RunReadReconcilerInterruptTests(
     std::shared_ptr<Xrpa::TransportStream> readerInboundDataset,
@@ -35,6 +38,39 @@ void RunReadReconcilerInterruptTests(
         std::shared_ptr<Xrpa::TransportStream>,
         std::shared_ptr<Xrpa::TransportStream>>()>& makeWriterDataset);
 
+void RunSnapshotResyncTests(
+    std::shared_ptr<Xrpa::TransportStream> readerInboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> readerOutboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> writerInboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> writerOutboundDataset);
+
+void RunTransactRetryTests(
+    std::shared_ptr<Xrpa::TransportStream> readerInboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> readerOutboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> writerInboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> writerOutboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> writerOutboundLockHolder);
+
+// the writer outbound stream must be configured with losslessReaderCount and a small changelog
+void RunLosslessBackpressureTests(
+    std::shared_ptr<Xrpa::TransportStream> readerInboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> readerOutboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> writerInboundDataset,
+    std::shared_ptr<Xrpa::TransportStream> writerOutboundDataset);
+
+struct DatasetTransports {
+  std::shared_ptr<Xrpa::TransportStream> readerInbound;
+  std::shared_ptr<Xrpa::TransportStream> readerOutbound;
+  std::shared_ptr<Xrpa::TransportStream> writerInbound;
+  std::shared_ptr<Xrpa::TransportStream> writerOutbound;
+};
+
+// all of the streams of both datasets must be configured with lockDomain
+void RunLockDomainTests(
+    std::shared_ptr<Xrpa::TransportLockDomain> lockDomain,
+    const DatasetTransports& datasetA,
+    const DatasetTransports& datasetB);
+
 void RunWriteReconcilerTests(
     std::shared_ptr<Xrpa::TransportStream> readerInboundDataset,
     std::shared_ptr<Xrpa::TransportStream> readerOutboundDataset,
@@ -52,7 +88,8 @@ void RunSignalTransportTests(
     std::shared_ptr<Xrpa::TransportStream> readerOutboundDataset,
     std::shared_ptr<Xrpa::TransportStream> writerInboundDataset,
     std::shared_ptr<Xrpa::TransportStream> writerOutboundDataset,
-    bool fromRingBuffer);
+    bool fromRingBuffer,
+    bool directOutboundMessages = false);
 
 void RunIndexingTests(
     std::shared_ptr<Xrpa::TransportStream> readerInboundDataset,
@@ -15,16 +15,25 @@
  */
 
 #include <folly/portability/GTest.h>
+#include <cstring>
 #include <random>
+#include <sstream>
 #include <string>
+#include <vector>
 
+#include <xrpa-runtime/reconciler/CollectionChangeTypes.h>
 #include <xrpa-runtime/transport/HeapMemoryTransportStream.h>
+#include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
+#include <xrpa-runtime/transport/TransportStreamAccessor.h>
+#include <xrpa-runtime/utils/MirroredMapping.h>
+#include <xrpa-runtime/utils/PlacedRingBuffer.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
 
 #include "./DataStoreReconciler.test.h"
 #include "./Transport.test.h"
 
 using namespace Xrpa;
+using namespace std::chrono_literals;
 
 TransportConfig genConfig(int changelogByteCount = 8192) {
   TransportConfig config;
@@ -60,6 +69,218 @@ TEST(HeapMemoryTransportStream, object_tests) {
   TransportTest::RunTransportObjectTests(readerTransport, writerTransport);
 }
 
+TEST(HeapMemoryTransportStream, wait_for_changes) {
+  auto config = genConfig();
+  auto name = randomName();
+
+  auto readerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto writerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, readerTransport->getRawMemory());
+  TransportTest::RunWaitForChangesTests(readerTransport, writerTransport);
+}
+
+// records what a platform flush would cover, as the Linux SharedMemoryTransportStream skips it
+class FlushRecordingTransportStream : public HeapMemoryTransportStream {
+ public:
+  FlushRecordingTransportStream(const std::string& name, const TransportConfig& config)
+      : HeapMemoryTransportStream(name, config) {}
+
+  int32_t lastFlushByteCount_ = 0;
+  int32_t lastFlushRangeCount_ = 0;
+
+  // whether the last flush covered all of [start, end), before page alignment
+  bool lastFlushCovered(int32_t start, int32_t end) const {
+    for (auto& range : lastRawRanges_) {
+      if (range.start_ <= start && range.end_ >= end) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ protected:
+  void flushWrites() override {
+    lastRawRanges_ = dirtyRanges_;
+    coalesceDirtyRanges(4096);
+    lastFlushByteCount_ = 0;
+    lastFlushRangeCount_ = static_cast<int32_t>(dirtyRanges_.size());
+    for (auto& range : dirtyRanges_) {
+      EXPECT_EQ(range.start_ % 4096, 0);
+      lastFlushByteCount_ += range.end_ - range.start_;
+    }
+    bytesFlushed_ += lastFlushByteCount_;
+  }
+
+ private:
+  std::vector<DirtyRange> lastRawRanges_;
+};
+
+TEST(HeapMemoryTransportStream, flush_dirty_ranges) {
+  auto config = genConfig(1024 * 1024);
+  auto transport = std::make_shared<FlushRecordingTransportStream>(randomName(), config);
+
+  // a small write only flushes the header page and the page holding the entry
+  for (int i = 0; i < 3; ++i) {
+    transport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      EXPECT_EQ(accessor->writeChangeEvent(0, 64).isNull(), false);
+    });
+    EXPECT_LE(transport->lastFlushByteCount_, 2 * 4096);
+  }
+
+  // entries far into the changelog flush separately from the header
+  transport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_EQ(accessor->writeChangeEvent(0, 256).isNull(), false);
+    }
+  });
+  transport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    EXPECT_EQ(accessor->writeChangeEvent(0, 64).isNull(), false);
+  });
+  EXPECT_EQ(transport->lastFlushRangeCount_, 2);
+  EXPECT_LE(transport->lastFlushByteCount_, 3 * 4096);
+
+  // a heartbeat-only transaction just flushes the header
+  transport->transact(1ms, [&](TransportStreamAccessor* /*accessor*/) {});
+  EXPECT_EQ(transport->lastFlushRangeCount_, 1);
+  EXPECT_EQ(transport->lastFlushByteCount_, 4096);
+  EXPECT_GT(transport->getBytesFlushed(), 0u);
+}
+
+TEST(HeapMemoryTransportStream, flush_mirrored_changelog_header) {
+  auto config = genConfig(5000);
+  config.mirroredChangelog = true;
+  auto transport = std::make_shared<FlushRecordingTransportStream>(randomName(), config);
+
+  // the changelog header is not adjacent to the transport header
+  auto changelogOffset = MemoryTransportStreamAccessor::getChangelogOffset(config);
+  EXPECT_GT(
+      changelogOffset,
+      MemoryTransportStreamAccessor::BYTE_COUNT + static_cast<int32_t>(sizeof(PlacedRingBuffer)));
+
+  transport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    EXPECT_EQ(accessor->writeChangeEvent(0, 64).isNull(), false);
+  });
+  EXPECT_TRUE(transport->lastFlushCovered(0, MemoryTransportStreamAccessor::BYTE_COUNT));
+  EXPECT_TRUE(transport->lastFlushCovered(
+      changelogOffset, changelogOffset + static_cast<int32_t>(sizeof(PlacedRingBuffer))));
+}
+
+TEST(HeapMemoryTransportStream, metrics) {
+  auto config = genConfig(512);
+  auto name = randomName();
+
+  auto writerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto readerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerTransport->getRawMemory());
+  auto readerIter = readerTransport->createIterator();
+  constexpr int32_t eventByteCount = ChangeEventAccessor::DS_SIZE + 24;
+
+  writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(accessor->writeChangeEvent(0, 24).isNull(), false);
+    }
+    // larger than the whole changelog
+    EXPECT_EQ(accessor->writeChangeEvent(0, 1024).isNull(), true);
+  });
+  readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    EXPECT_EQ(readerIter->hasMissedEntries(accessor), false);
+    while (!readerIter->getNextEntry(accessor).isNull()) {
+    }
+  });
+
+  auto writerMetrics = writerTransport->getMetrics();
+  EXPECT_EQ(writerMetrics.transactCount, 1u);
+  EXPECT_EQ(writerMetrics.transactFailures, 0u);
+  EXPECT_EQ(writerMetrics.lockWait.count, 1u);
+  EXPECT_EQ(writerMetrics.lockHold.count, 1u);
+  EXPECT_EQ(writerMetrics.eventsWritten, 4u);
+  EXPECT_EQ(writerMetrics.bytesWritten, 4u * eventByteCount);
+  EXPECT_EQ(writerMetrics.failedWrites, 1u);
+  EXPECT_EQ(
+      writerMetrics.changelogHighWaterMark,
+      4 * (PlacedRingBuffer::ELEMENT_HEADER_SIZE + eventByteCount));
+  EXPECT_EQ(writerMetrics.changelogByteCount, 512);
+
+  auto readerMetrics = readerTransport->getMetrics();
+  EXPECT_EQ(readerMetrics.eventsRead, 4u);
+  EXPECT_EQ(readerMetrics.bytesRead, 4u * eventByteCount);
+  EXPECT_EQ(readerMetrics.missedEntries, 0u);
+  EXPECT_EQ(readerMetrics.eventLatency.count, 4u);
+  EXPECT_EQ(writerMetrics.eventLatency.count, 0u);
+
+  // overflow the changelog before the reader gets to it
+  writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    for (int i = 0; i < 20; ++i) {
+      EXPECT_EQ(accessor->writeChangeEvent(0, 24).isNull(), false);
+    }
+  });
+  readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    EXPECT_EQ(readerIter->hasMissedEntries(accessor), true);
+  });
+  EXPECT_EQ(readerTransport->getMetrics().missedEntries, 1u);
+  EXPECT_GT(writerTransport->getMetrics().changelogHighWaterMark, 400);
+  EXPECT_LE(writerTransport->getMetrics().changelogHighWaterMark, 512);
+
+  std::stringstream dump;
+  writerTransport->getMetrics().dump(dump, name);
+  EXPECT_NE(dump.str().find(name), std::string::npos);
+
+  writerTransport->resetMetrics();
+  EXPECT_EQ(writerTransport->getMetrics().transactCount, 0u);
+}
+
+TEST(HeapMemoryTransportStream, event_timestamps) {
+  auto config = genConfig();
+  auto name = randomName();
+
+  auto writerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto readerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerTransport->getRawMemory());
+  auto readerIter = readerTransport->createIterator();
+
+  // microsecond precision, well past the range of a 32-bit millisecond offset, and before the base
+  std::vector<uint64_t> timestamps;
+  writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    auto baseTimestamp = accessor->getBaseTimestamp();
+    timestamps = {baseTimestamp + 1, baseTimestamp + 30ull * 24 * 3600 * 1000000 + 7,
+                  baseTimestamp - 5};
+    for (auto timestamp : timestamps) {
+      EXPECT_EQ(accessor->writeChangeEvent(0, 0, timestamp).isNull(), false);
+    }
+  });
+
+  std::vector<uint64_t> readTimestamps;
+  readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    for (auto entry = readerIter->getNextEntry(accessor); !entry.isNull();
+         entry = readerIter->getNextEntry(accessor)) {
+      readTimestamps.push_back(
+          ChangeEventAccessor(entry).getTimestamp(accessor->getBaseTimestamp()));
+    }
+  });
+  EXPECT_EQ(readTimestamps, timestamps);
+}
+
+TEST(HeapMemoryTransportStream, mapping_flags) {
+  auto config = genConfig();
+  config.mappingFlags = MappingHugePages | MappingPrefault | MappingLockInMemory;
+  auto name = randomName();
+
+  auto readerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto writerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, readerTransport->getRawMemory());
+
+  // hugepage and mlock support depends on the host, but prefaulting is always possible
+  auto metrics = readerTransport->getMetrics();
+  EXPECT_EQ(metrics.mappingFlagsRequested, config.mappingFlags);
+  EXPECT_EQ(metrics.mappingFlagsApplied & ~config.mappingFlags, 0u);
+  EXPECT_NE(metrics.mappingFlagsApplied & MappingPrefault, 0u);
+
+  readerTransport->resetMetrics();
+  EXPECT_EQ(readerTransport->getMetrics().mappingFlagsApplied, metrics.mappingFlagsApplied);
+
+  TransportTest::RunTransportObjectTests(readerTransport, writerTransport);
+}
+
 TEST(HeapMemoryTransportStream, reader_tests) {
   // intentionally small changelog
   auto config = genConfig(512);
@@ -82,6 +303,425 @@ TEST(HeapMemoryTransportStream, reader_tests) {
       writerOutboundTransport);
 }
 
+TEST(HeapMemoryTransportStream, deferred_dispatch_reader_tests) {
+  // intentionally small changelog
+  auto config = genConfig(512);
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunReadReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport,
+      true);
+}
+
+TEST(HeapMemoryTransportStream, staged_outbound_reader_tests) {
+  // intentionally small changelog
+  auto config = genConfig(512);
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunReadReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport,
+      false,
+      true);
+}
+
+TEST(HeapMemoryTransportStream, snapshot_resync_tests) {
+  // intentionally small changelog
+  auto config = genConfig(512);
+  config.snapshotByteCount = 4096;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunSnapshotResyncTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+}
+
+TEST(HeapMemoryTransportStream, indexed_snapshot_resync_tests) {
+  auto config = genConfig(512);
+  config.snapshotByteCount = 4096;
+  config.changelogIndexCapacity = 16;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunSnapshotResyncTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+}
+
+TEST(HeapMemoryTransportStream, shared_writer_snapshot) {
+  auto config = genConfig(512);
+  config.snapshotByteCount = 4096;
+  auto name = randomName();
+
+  auto writerA = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto writerB =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerA->getRawMemory());
+  auto readerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerA->getRawMemory());
+  auto readerIter = readerTransport->createIterator();
+
+  auto writeWithSnapshot = [&](HeapMemoryTransportStream* writer) {
+    bool didWriteSnapshot = false;
+    writer->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      EXPECT_EQ(accessor->writeChangeEvent(0, 24).isNull(), false);
+      didWriteSnapshot = accessor->writeSnapshot([](TransportStreamAccessor* snapshotAccessor) {
+        EXPECT_EQ(snapshotAccessor->writeChangeEvent(0, 24).isNull(), false);
+      });
+    });
+    return didWriteSnapshot;
+  };
+  // the snapshot is refreshed after the changes, so it is current when the reader catches up
+  auto overflowAndResync = [&]() {
+    writerA->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(accessor->writeChangeEvent(0, 24).isNull(), false);
+      }
+      accessor->writeSnapshot([](TransportStreamAccessor* snapshotAccessor) {
+        EXPECT_EQ(snapshotAccessor->writeChangeEvent(0, 24).isNull(), false);
+      });
+    });
+    bool didResync = false;
+    readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      EXPECT_EQ(readerIter->hasMissedEntries(accessor), true);
+      didResync = readerIter->resyncFromSnapshot(accessor);
+      while (!readerIter->getNextEntry(accessor).isNull()) {
+      }
+    });
+    return didResync;
+  };
+
+  // a single writer keeps a snapshot
+  EXPECT_TRUE(writeWithSnapshot(writerA.get()));
+  EXPECT_TRUE(writeWithSnapshot(writerA.get()));
+  EXPECT_TRUE(overflowAndResync());
+
+  // once a second writer writes to the stream, the snapshot is dropped for good, as it would only
+  // hold one writer's objects
+  writerB->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    EXPECT_EQ(accessor->writeChangeEvent(0, 24).isNull(), false);
+  });
+  EXPECT_FALSE(overflowAndResync());
+  EXPECT_FALSE(writeWithSnapshot(writerA.get()));
+  EXPECT_FALSE(writeWithSnapshot(writerB.get()));
+  EXPECT_FALSE(overflowAndResync());
+}
+
+TEST(HeapMemoryTransportStream, layout_mismatch) {
+  auto config = genConfig(512);
+  config.snapshotByteCount = 4096;
+  auto otherConfig = config;
+  otherConfig.snapshotByteCount = 2048;
+  auto name = randomName();
+  auto noop = [](TransportStreamAccessor*) {};
+
+  auto writerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto readerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerTransport->getRawMemory());
+  EXPECT_EQ(readerTransport->transact(1ms, noop), true);
+
+  auto otherTransport = std::make_shared<HeapMemoryTransportStream>(
+      name, otherConfig, writerTransport->getRawMemory());
+  EXPECT_EQ(otherTransport->transact(1ms, noop), false);
+
+  // same size, but the index takes the place of part of the snapshot
+  auto indexConfig = config;
+  indexConfig.changelogIndexCapacity = 16;
+  // the snapshot is double-buffered
+  indexConfig.snapshotByteCount -= PlacedRingBufferIndex::getMemSize(16) / 2;
+  EXPECT_EQ(
+      MemoryTransportStreamAccessor::getMemSize(indexConfig),
+      MemoryTransportStreamAccessor::getMemSize(config));
+  auto indexTransport = std::make_shared<HeapMemoryTransportStream>(
+      name, indexConfig, writerTransport->getRawMemory());
+  EXPECT_EQ(indexTransport->transact(1ms, noop), false);
+}
+
+TEST(HeapMemoryTransportStream, growable_changelog) {
+  auto config = genConfig(512);
+  config.maxChangelogByteCount = 4096;
+  auto name = randomName();
+
+  auto writerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto readerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerTransport->getRawMemory());
+  auto readerIter = readerTransport->createIterator();
+
+  // each transaction writes more than the initial changelog holds
+  auto runRound = [&](int eventCount) {
+    writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      for (int i = 0; i < eventCount; ++i) {
+        EXPECT_EQ(accessor->writeChangeEvent(i, 16).isNull(), false);
+      }
+    });
+    bool didMiss = false;
+    int readCount = 0;
+    readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      didMiss = readerIter->hasMissedEntries(accessor);
+      while (!readerIter->getNextEntry(accessor).isNull()) {
+        readCount++;
+      }
+    });
+    EXPECT_EQ(readCount, didMiss ? 0 : eventCount);
+    return didMiss;
+  };
+
+  // the reader misses entries until the changelog has grown to fit a whole transaction
+  int missedRounds = 0;
+  for (int round = 0; round < 6; ++round) {
+    missedRounds += runRound(40) ? 1 : 0;
+  }
+  EXPECT_GT(missedRounds, 0);
+  EXPECT_LT(missedRounds, 6);
+  EXPECT_EQ(runRound(40), false);
+  EXPECT_GT(readerTransport->getMetrics().changelogByteCount, 512);
+
+  // growth stops at maxChangelogByteCount
+  for (int round = 0; round < 4; ++round) {
+    EXPECT_EQ(runRound(200), true);
+  }
+  EXPECT_EQ(readerTransport->getMetrics().changelogByteCount, 4096);
+
+  // a process configured with a different maximum does not attach
+  auto otherConfig = config;
+  otherConfig.maxChangelogByteCount = 8192;
+  auto otherTransport = std::make_shared<HeapMemoryTransportStream>(
+      name, otherConfig, writerTransport->getRawMemory());
+  EXPECT_EQ(otherTransport->transact(1ms, [](TransportStreamAccessor*) {}), false);
+}
+
+TEST(HeapMemoryTransportStream, lossless_readers) {
+  // intentionally small changelog
+  auto config = genConfig(512);
+  config.losslessReaderCount = 1;
+  auto name = randomName();
+
+  auto writerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto readerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerTransport->getRawMemory());
+  auto readerIter = readerTransport->createIterator();
+  // the table only has one slot, so this reader is not protected
+  auto lateReaderIter = readerTransport->createIterator();
+
+  int writtenCount = 0;
+  auto writeEvents = [&](int eventCount) {
+    writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      for (int i = 0; i < eventCount; ++i) {
+        writtenCount += accessor->writeChangeEvent(i, 16).isNull() ? 0 : 1;
+      }
+    });
+  };
+  auto readEvents = [&](TransportStreamIterator* iter, bool* didMiss) {
+    int readCount = 0;
+    readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      *didMiss = iter->hasMissedEntries(accessor);
+      while (!iter->getNextEntry(accessor).isNull()) {
+        readCount++;
+      }
+    });
+    return readCount;
+  };
+
+  bool didMiss = false;
+  readEvents(readerIter.get(), &didMiss);
+  readEvents(lateReaderIter.get(), &didMiss);
+
+  // the writer stops short of evicting entries the registered reader has not read
+  writeEvents(100);
+  EXPECT_GT(writtenCount, 0);
+  EXPECT_LT(writtenCount, 100);
+  EXPECT_EQ(writerTransport->getMetrics().blockedWrites, 100 - writtenCount);
+  EXPECT_EQ(writerTransport->getMetrics().failedWrites, 0);
+  EXPECT_EQ(readEvents(readerIter.get(), &didMiss), writtenCount);
+  EXPECT_EQ(didMiss, false);
+
+  // and resumes once the reader has caught up
+  writerTransport->resetMetrics();
+  writtenCount = 0;
+  writeEvents(10);
+  EXPECT_EQ(writtenCount, 10);
+  EXPECT_EQ(writerTransport->getMetrics().blockedWrites, 0);
+  EXPECT_EQ(readEvents(readerIter.get(), &didMiss), 10);
+  EXPECT_EQ(didMiss, false);
+
+  // the unprotected reader fell behind
+  readEvents(lateReaderIter.get(), &didMiss);
+  EXPECT_EQ(didMiss, true);
+
+  // releasing the slot hands it to the other reader
+  readerIter.reset();
+  readEvents(lateReaderIter.get(), &didMiss);
+  writtenCount = 0;
+  writeEvents(100);
+  EXPECT_LT(writtenCount, 100);
+  EXPECT_EQ(readEvents(lateReaderIter.get(), &didMiss), writtenCount);
+  EXPECT_EQ(didMiss, false);
+}
+
+TEST(HeapMemoryTransportStream, lossless_reader_expiry) {
+  auto config = genConfig(512);
+  config.losslessReaderCount = 1;
+  auto name = randomName();
+
+  auto writerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto readerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, writerTransport->getRawMemory());
+  auto readerIter = readerTransport->createIterator();
+
+  int writtenCount = 0;
+  auto writeEvents = [&](int eventCount) {
+    writtenCount = 0;
+    writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      for (int i = 0; i < eventCount; ++i) {
+        writtenCount += accessor->writeChangeEvent(i, 16).isNull() ? 0 : 1;
+      }
+    });
+  };
+
+  bool didMiss = false;
+  readerTransport->transact(
+      1ms, [&](TransportStreamAccessor* accessor) { readerIter->hasMissedEntries(accessor); });
+  writeEvents(100);
+  EXPECT_LT(writtenCount, 100);
+
+  // a reader that stops ticking no longer holds the writer back
+  MemoryTransportStreamAccessor streamAccessor{MemoryAccessor(
+      writerTransport->getRawMemory(), 0, MemoryTransportStreamAccessor::getMemSize(config))};
+  auto& cursor = streamAccessor.getReaderCursors(config)[0];
+  cursor.lastActiveMs = streamAccessor.getElapsedMilliseconds() - 30000;
+  writeEvents(100);
+  EXPECT_EQ(writtenCount, 100);
+  EXPECT_EQ(cursor.readerToken, 0);
+
+  // and learns that it missed entries when it comes back
+  readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    didMiss = readerIter->hasMissedEntries(accessor);
+  });
+  EXPECT_EQ(didMiss, true);
+  EXPECT_NE(cursor.readerToken, 0);
+}
+
+TEST(HeapMemoryTransportStream, transact_retry_tests) {
+  auto config = genConfig();
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  // shares the writer outbound lock
+  auto lockHolderTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunTransactRetryTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport,
+      lockHolderTransport);
+}
+
+TEST(HeapMemoryTransportStream, lossless_backpressure_tests) {
+  auto config = genConfig();
+  // intentionally small changelog
+  auto outboundConfig = genConfig(512);
+  outboundConfig.losslessReaderCount = 1;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", outboundConfig);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", outboundConfig, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunLosslessBackpressureTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+}
+
+TEST(HeapMemoryTransportStream, lock_domain_tests) {
+  auto config = genConfig();
+  config.lockDomain = randomName();
+  auto lockDomain = TransportLockDomain::get(config.lockDomain);
+
+  auto makeDataset = [&]() {
+    auto name = randomName();
+    DataStoreReconcilerTest::DatasetTransports dataset;
+    auto writerInboundTransport =
+        std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+    auto writerOutboundTransport =
+        std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+    dataset.writerInbound = writerInboundTransport;
+    dataset.writerOutbound = writerOutboundTransport;
+    dataset.readerInbound = std::make_shared<HeapMemoryTransportStream>(
+        name + "Outbound", config, writerOutboundTransport->getRawMemory());
+    dataset.readerOutbound = std::make_shared<HeapMemoryTransportStream>(
+        name + "Inbound", config, writerInboundTransport->getRawMemory());
+    return dataset;
+  };
+
+  DataStoreReconcilerTest::RunLockDomainTests(lockDomain, makeDataset(), makeDataset());
+}
+
 TEST(HeapMemoryTransportStream, writer_tests) {
   auto config = genConfig();
   auto name = randomName();
@@ -168,6 +808,29 @@ TEST(HeapMemoryTransportStream, signal_ring_buffer_transport_tests) {
       true);
 }
 
+TEST(HeapMemoryTransportStream, signal_direct_transport_tests) {
+  auto config = genConfig();
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunSignalTransportTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport,
+      false,
+      true);
+}
+
 TEST(HeapMemoryTransportStream, indexing_tests) {
   auto config = genConfig();
   auto name = randomName();
@@ -188,3 +851,142 @@ TEST(HeapMemoryTransportStream, indexing_tests) {
       writerInboundTransport,
       writerOutboundTransport);
 }
+
+TEST(HeapMemoryTransportStream, lock_free_object_tests) {
+  auto config = genConfig();
+  config.lockFree = true;
+  auto name = randomName();
+
+  auto readerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto writerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, readerTransport->getRawMemory());
+  TransportTest::RunTransportObjectTests(readerTransport, writerTransport);
+}
+
+TEST(HeapMemoryTransportStream, lock_free_wait_for_changes) {
+  auto config = genConfig();
+  config.lockFree = true;
+  auto name = randomName();
+
+  auto readerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto writerTransport =
+      std::make_shared<HeapMemoryTransportStream>(name, config, readerTransport->getRawMemory());
+  TransportTest::RunWaitForChangesTests(readerTransport, writerTransport);
+}
+
+TEST(HeapMemoryTransportStream, lock_free_reader_tests) {
+  // intentionally small changelog
+  auto config = genConfig(512);
+  config.lockFree = true;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunReadReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+}
+
+TEST(HeapMemoryTransportStream, lock_free_writer_tests) {
+  auto config = genConfig();
+  config.lockFree = true;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunWriteReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+}
+
+TEST(HeapMemoryTransportStream, lock_free_single_writer) {
+  auto config = genConfig();
+  config.lockFree = true;
+  auto name = randomName();
+
+  auto readerTransport = std::make_shared<HeapMemoryTransportStream>(name, config);
+  auto* rawMemory = static_cast<unsigned char*>(readerTransport->getRawMemory());
+  auto writerTransport = std::make_shared<HeapMemoryTransportStream>(name, config, rawMemory);
+  auto otherTransport = std::make_shared<HeapMemoryTransportStream>(name, config, rawMemory);
+
+  bool didWrite = false;
+  auto writeEvent = [&](TransportStreamAccessor* accessor) {
+    auto changeEvent = accessor->writeChangeEvent<CollectionChangeEventAccessor>(
+        CollectionChangeType::CreateObject);
+    didWrite = !changeEvent.isNull();
+  };
+
+  EXPECT_EQ(writerTransport->transact(1ms, writeEvent), true);
+  EXPECT_EQ(didWrite, true);
+
+  // a second writer is refused rather than corrupting the changelog
+  EXPECT_EQ(otherTransport->transact(1ms, writeEvent), true);
+  EXPECT_EQ(didWrite, false);
+  EXPECT_EQ(otherTransport->getMetrics().failedWrites, 1);
+
+  // reader transactions leave the headers to the writer
+  constexpr int32_t headerByteCount =
+      MemoryTransportStreamAccessor::BYTE_COUNT + SpmcRingBuffer::HEADER_SIZE;
+  std::vector<unsigned char> headers(rawMemory, rawMemory + headerByteCount);
+  auto readerIter = readerTransport->createIterator();
+  bool didTransact = readerTransport->transact(1ms, [&](TransportStreamAccessor* reader) {
+    EXPECT_EQ(readerIter->getNextEntry(reader).isNull(), false);
+  });
+  EXPECT_EQ(didTransact, true);
+  EXPECT_EQ(std::memcmp(headers.data(), rawMemory, headerByteCount), 0);
+
+  // the claim is released along with the writer
+  writerTransport = nullptr;
+  EXPECT_EQ(otherTransport->transact(1ms, writeEvent), true);
+  EXPECT_EQ(didWrite, true);
+}
+
+TEST(HeapMemoryTransportStream, mirrored_changelog_writer_tests) {
+  // not a whole number of pages
+  auto config = genConfig(5000);
+  config.mirroredChangelog = true;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<HeapMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Outbound", config, writerOutboundTransport->getRawMemory());
+  auto readerOutboundTransport = std::make_shared<HeapMemoryTransportStream>(
+      name + "Inbound", config, writerInboundTransport->getRawMemory());
+
+  DataStoreReconcilerTest::RunWriteReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+
+  // rounded up to whole pages
+  EXPECT_EQ(
+      writerOutboundTransport->getMetrics().changelogByteCount,
+      MemoryTransportStreamAccessor::getChangelogCapacity(config));
+  EXPECT_EQ(
+      MemoryTransportStreamAccessor::getChangelogCapacity(config) % getMemoryPageSize(), 0);
+}
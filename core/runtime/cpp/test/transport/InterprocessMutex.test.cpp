@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <xrpa-runtime/transport/InterprocessMutex.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Xrpa;
+
+#ifdef __linux__
+
+TEST(RobustInterprocessMutex, basic_lock) {
+  alignas(8) uint8_t lockSlot[ROBUST_MUTEX_SLOT_SIZE] = {};
+  RobustInterprocessMutex mutex("basic_lock", lockSlot);
+
+  bool didRun = false;
+  EXPECT_TRUE(mutex.lockAndExecute(1, [&]() {
+    EXPECT_FALSE(mutex.didOwnerDie());
+    didRun = true;
+  }));
+  EXPECT_TRUE(didRun);
+}
+
+TEST(RobustInterprocessMutex, timeout_while_held) {
+  alignas(8) uint8_t lockSlot[ROBUST_MUTEX_SLOT_SIZE] = {};
+  RobustInterprocessMutex mutexA("timeout_while_held", lockSlot);
+  RobustInterprocessMutex mutexB("timeout_while_held", lockSlot);
+
+  EXPECT_TRUE(mutexA.lockAndExecute(1, [&]() {
+    bool didRun = false;
+    EXPECT_FALSE(mutexB.lockAndExecute(5, [&]() { didRun = true; }));
+    EXPECT_FALSE(didRun);
+  }));
+
+  EXPECT_TRUE(mutexB.lockAndExecute(1, []() {}));
+}
+
+TEST(RobustInterprocessMutex, contended_threads) {
+  constexpr int kThreadCount = 4;
+  constexpr int kIterations = 5000;
+
+  alignas(8) uint8_t lockSlot[ROBUST_MUTEX_SLOT_SIZE] = {};
+  int counter = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&]() {
+      RobustInterprocessMutex mutex("contended_threads", lockSlot);
+      for (int i = 0; i < kIterations; ++i) {
+        while (!mutex.lockAndExecute(100, [&]() { counter++; })) {
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(counter, kThreadCount * kIterations);
+}
+
+TEST(RobustInterprocessMutex, recover_from_dead_owner) {
+  // the mutex must be shared with the child process
+  void* lockSlot = mmap(
+      nullptr, ROBUST_MUTEX_SLOT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(lockSlot, MAP_FAILED);
+
+  pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    // exit while holding the lock
+    RobustInterprocessMutex mutex("recover_from_dead_owner", lockSlot);
+    mutex.lockAndExecute(1, []() { _exit(0); });
+    _exit(1);
+  }
+
+  int status = 0;
+  waitpid(child, &status, 0);
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+
+  RobustInterprocessMutex mutex("recover_from_dead_owner", lockSlot);
+  bool didRun = false;
+  EXPECT_TRUE(mutex.lockAndExecute(100, [&]() {
+    EXPECT_TRUE(mutex.didOwnerDie());
+    didRun = true;
+  }));
+  EXPECT_TRUE(didRun);
+
+  // the mutex was made consistent again, so the next owner is not told
+  EXPECT_TRUE(mutex.lockAndExecute(1, [&]() { EXPECT_FALSE(mutex.didOwnerDie()); }));
+
+  mutex.dispose();
+  munmap(lockSlot, ROBUST_MUTEX_SLOT_SIZE);
+}
+
+TEST(RobustInterprocessMutex, reclaim_stale_initialization) {
+  alignas(8) uint8_t lockSlot[ROBUST_MUTEX_SLOT_SIZE] = {};
+  // as left by a process that died after claiming the slot but before initializing the mutex
+  *reinterpret_cast<uint32_t*>(lockSlot) = 1;
+  RobustInterprocessMutex mutex("reclaim_stale_initialization", lockSlot);
+
+  // short lock attempts fail until the slot is stale, then the mutex is reinitialized
+  auto startTime = std::chrono::steady_clock::now();
+  bool didRun = false;
+  while (!didRun && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(2)) {
+    mutex.lockAndExecute(1, [&]() { didRun = true; });
+  }
+  EXPECT_TRUE(didRun);
+  EXPECT_GE(std::chrono::steady_clock::now() - startTime, std::chrono::milliseconds(100));
+
+  EXPECT_TRUE(mutex.lockAndExecute(1, [&]() { EXPECT_FALSE(mutex.didOwnerDie()); }));
+  mutex.dispose();
+}
+
+#endif // __linux__
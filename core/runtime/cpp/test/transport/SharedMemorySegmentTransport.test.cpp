@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <random>
+#include <string>
+
+#include <xrpa-runtime/transport/SharedMemorySegment.h>
+#include <xrpa-runtime/transport/SharedMemorySegmentTransportStream.h>
+
+#include "./DataStoreReconciler.test.h"
+#include "./Transport.test.h"
+
+using namespace Xrpa;
+using namespace std::chrono_literals;
+
+static constexpr int32_t SEGMENT_BYTE_COUNT = 256 * 1024;
+
+static TransportConfig genConfig(int changelogByteCount = 8192) {
+  TransportConfig config;
+  config.schemaHash =
+      HashValue(0x1111111111111111, 0x2222222222222222, 0x3333333333333333, 0x4444444444444444);
+  config.changelogByteCount = changelogByteCount;
+  return config;
+}
+
+static std::string randomName(int length = 16) {
+  const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  std::random_device rd;
+  std::mt19937 engine(rd());
+  std::uniform_int_distribution<> dist(0, chars.size() - 1);
+
+  std::string result;
+  result.reserve(length);
+
+  for (int i = 0; i < length; ++i) {
+    result += chars[dist(engine)];
+  }
+
+  return result;
+}
+
+// each process maps the segment separately, so the tests open it once for the "writer process"
+// and once for the "reader process"
+TEST(SharedMemorySegmentTransportStream, object_tests) {
+  auto config = genConfig();
+  auto segmentName = randomName();
+  auto name = randomName();
+
+  auto writerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT);
+  auto readerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT);
+
+  auto writerTransport =
+      std::make_shared<SharedMemorySegmentTransportStream>(writerSegment, name, config);
+  auto readerTransport =
+      std::make_shared<SharedMemorySegmentTransportStream>(readerSegment, name, config);
+
+  TransportTest::RunTransportObjectTests(readerTransport, writerTransport);
+}
+
+TEST(SharedMemorySegmentTransportStream, reader_tests) {
+  auto config = genConfig(512); // intentionally small changelog
+  auto segmentName = randomName();
+  auto name = randomName();
+
+  auto writerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT);
+  auto readerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT);
+
+  auto writerInboundTransport = std::make_shared<SharedMemorySegmentTransportStream>(
+      writerSegment, name + "Inbound", config);
+  auto writerOutboundTransport = std::make_shared<SharedMemorySegmentTransportStream>(
+      writerSegment, name + "Outbound", config);
+
+  auto readerInboundTransport = std::make_shared<SharedMemorySegmentTransportStream>(
+      readerSegment, name + "Outbound", config);
+  auto readerOutboundTransport = std::make_shared<SharedMemorySegmentTransportStream>(
+      readerSegment, name + "Inbound", config);
+
+  DataStoreReconcilerTest::RunReadReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+}
+
+TEST(SharedMemorySegmentTransportStream, directory) {
+  auto config = genConfig();
+  auto segmentName = randomName();
+
+  auto writerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT, 2);
+  auto readerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT, 2);
+  EXPECT_TRUE(writerSegment->isValid());
+  EXPECT_TRUE(readerSegment->isValid());
+
+  // a segment must be opened with the size it was created with
+  SharedMemorySegment mismatchedSegment(segmentName, SEGMENT_BYTE_COUNT / 2, 2);
+  EXPECT_FALSE(mismatchedSegment.isValid());
+
+  auto noop = [](TransportStreamAccessor* /*accessor*/) {};
+
+  auto streamA = std::make_shared<SharedMemorySegmentTransportStream>(writerSegment, "A", config);
+  auto streamB = std::make_shared<SharedMemorySegmentTransportStream>(writerSegment, "B", config);
+  EXPECT_TRUE(streamA->transact(1s, noop));
+  EXPECT_TRUE(streamB->transact(1s, noop));
+  EXPECT_EQ(writerSegment->getStreamCount(), 2);
+  auto freeByteCount = writerSegment->getFreeByteCount();
+  EXPECT_LT(freeByteCount, SEGMENT_BYTE_COUNT);
+
+  // the directory is shared: another mapping finds the existing region instead of allocating
+  auto readerA = std::make_shared<SharedMemorySegmentTransportStream>(readerSegment, "A", config);
+  EXPECT_TRUE(readerA->transact(1s, noop));
+  EXPECT_EQ(readerSegment->getStreamCount(), 2);
+  EXPECT_EQ(readerSegment->getFreeByteCount(), freeByteCount);
+
+  // the directory is full
+  auto streamC = std::make_shared<SharedMemorySegmentTransportStream>(writerSegment, "C", config);
+  EXPECT_FALSE(streamC->transact(1s, noop));
+
+  // a stream can only be reopened with the same size
+  auto mismatchedA = std::make_shared<SharedMemorySegmentTransportStream>(
+      readerSegment, "A", genConfig(4096));
+  EXPECT_FALSE(mismatchedA->transact(1s, noop));
+}
+
+TEST(SharedMemorySegmentTransportStream, long_stream_names) {
+  auto config = genConfig();
+  auto segmentName = randomName();
+
+  auto writerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT, 4);
+  auto readerSegment = std::make_shared<SharedMemorySegment>(segmentName, SEGMENT_BYTE_COUNT, 4);
+  auto noop = [](TransportStreamAccessor* /*accessor*/) {};
+
+  // names past the directory limit, which differ only after it
+  auto longName = std::string(SharedMemorySegment::MAX_STREAM_NAME_LENGTH + 20, 'x');
+  auto streamA = std::make_shared<SharedMemorySegmentTransportStream>(
+      writerSegment, longName + "A", config);
+  auto streamB = std::make_shared<SharedMemorySegmentTransportStream>(
+      writerSegment, longName + "B", config);
+  EXPECT_TRUE(streamA->transact(1s, noop));
+  EXPECT_TRUE(streamB->transact(1s, noop));
+  EXPECT_EQ(writerSegment->getStreamCount(), 2);
+
+  auto readerA = std::make_shared<SharedMemorySegmentTransportStream>(
+      readerSegment, longName + "A", config);
+  EXPECT_TRUE(readerA->transact(1s, noop));
+  EXPECT_EQ(readerSegment->getStreamCount(), 2);
+}
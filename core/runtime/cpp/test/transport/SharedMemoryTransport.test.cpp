@@ -18,12 +18,21 @@
 #include <random>
 #include <string>
 
+#include <xrpa-runtime/reconciler/CollectionChangeTypes.h>
+#include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
 #include <xrpa-runtime/transport/SharedMemoryTransportStream.h>
+#include <xrpa-runtime/utils/MirroredMapping.h>
 
 #include "./DataStoreReconciler.test.h"
 #include "./Transport.test.h"
 
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace Xrpa;
+using namespace std::chrono_literals;
 
 static TransportConfig genConfig(int changelogByteCount = 8192) {
   TransportConfig config;
@@ -59,6 +68,40 @@ TEST(SharedMemoryTransportStream, object_tests) {
   TransportTest::RunTransportObjectTests(readerTransport, writerTransport);
 }
 
+TEST(SharedMemoryTransportStream, wait_for_changes) {
+  auto config = genConfig();
+  auto name = randomName();
+
+  auto writerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+  auto readerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+
+  TransportTest::RunWaitForChangesTests(readerTransport, writerTransport);
+}
+
+TEST(SharedMemoryTransportStream, change_wakes) {
+  auto config = genConfig();
+  auto name = randomName();
+
+  auto writerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+  auto readerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+  auto writeEvent = [](TransportStreamAccessor* accessor) {
+    accessor->writeChangeEvent<CollectionChangeEventAccessor>(CollectionChangeType::CreateObject);
+  };
+
+  // the write that wakes the waiting reader
+  TransportTest::RunWaitForChangesTests(readerTransport, writerTransport);
+#ifdef __linux__
+  EXPECT_EQ(writerTransport->getMetrics().changeWakes, 1);
+#endif
+
+  // nobody is waiting now, so the write skips the wake
+  EXPECT_EQ(writerTransport->transact(1ms, writeEvent), true);
+  EXPECT_EQ(writerTransport->getMetrics().eventsWritten, 2);
+#ifdef __linux__
+  EXPECT_EQ(writerTransport->getMetrics().changeWakes, 1);
+#endif
+}
+
 TEST(SharedMemoryTransportStream, reader_tests) {
   auto config = genConfig(512); // intentionally small changelog
   auto name = randomName();
@@ -152,6 +195,114 @@ TEST(SharedMemoryTransportStream, changed_writer) {
       });
 }
 
+TEST(SharedMemoryTransportStream, layout_mismatch) {
+  auto name = randomName();
+  auto noop = [](TransportStreamAccessor*) {};
+
+  auto writerTransport = std::make_shared<SharedMemoryTransportStream>(name, genConfig(8192));
+  EXPECT_EQ(writerTransport->transact(1ms, noop), true);
+
+  // a differently sized changelog neither attaches nor resizes the memory in use
+  auto otherTransport = std::make_shared<SharedMemoryTransportStream>(name, genConfig(512));
+  EXPECT_EQ(otherTransport->transact(1ms, noop), false);
+  EXPECT_EQ(writerTransport->transact(1ms, noop), true);
+}
+
+#ifdef __linux__
+TEST(SharedMemoryTransportStream, dead_lock_owner) {
+  auto config = genConfig();
+  auto name = randomName();
+  auto writeEvent = [](TransportStreamAccessor* accessor) {
+    accessor->writeChangeEvent<CollectionChangeEventAccessor>(CollectionChangeType::CreateObject);
+  };
+
+  auto readerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+  auto readerIter = readerTransport->createIterator();
+  auto writerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+  EXPECT_EQ(writerTransport->transact(1ms, writeEvent), true);
+
+  pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    // exit while holding the lock, part way through a transaction
+    SharedMemoryTransportStream childTransport(name, config);
+    childTransport.transact(1ms, [&](TransportStreamAccessor* accessor) {
+      writeEvent(accessor);
+      _exit(0);
+    });
+    _exit(1);
+  }
+
+  int status = 0;
+  waitpid(child, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+
+  // the changelog is dropped, so the reader that had not caught up resyncs
+  bool didTransact = readerTransport->transact(100ms, [&](TransportStreamAccessor* reader) {
+    EXPECT_EQ(readerIter->hasMissedEntries(reader), true);
+  });
+  EXPECT_EQ(didTransact, true);
+  EXPECT_EQ(writerTransport->transact(1ms, writeEvent), true);
+}
+
+TEST(SharedMemoryTransportStream, dead_lock_domain_owner) {
+  auto config = genConfig();
+  config.lockDomain = randomName();
+  auto name = randomName();
+  auto writeEvent = [](TransportStreamAccessor* accessor) {
+    accessor->writeChangeEvent<CollectionChangeEventAccessor>(CollectionChangeType::CreateObject);
+  };
+
+  auto readerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+  auto readerIter = readerTransport->createIterator();
+  auto writerTransport = std::make_shared<SharedMemoryTransportStream>(name, config);
+  auto otherTransport = std::make_shared<SharedMemoryTransportStream>(name + "Other", config);
+  EXPECT_EQ(writerTransport->transact(1ms, writeEvent), true);
+
+  pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    // exit while holding the domain lock, part way through a transaction
+    SharedMemoryTransportStream childTransport(name, config);
+    childTransport.transact(1ms, [&](TransportStreamAccessor* accessor) {
+      writeEvent(accessor);
+      _exit(0);
+    });
+    _exit(1);
+  }
+
+  int status = 0;
+  waitpid(child, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+
+  // the next lock is taken by another member of the domain, and the stream the dead owner was
+  // writing still drops its changelog, so the reader that had not caught up resyncs
+  EXPECT_EQ(otherTransport->transact(100ms, writeEvent), true);
+  bool didTransact = readerTransport->transact(100ms, [&](TransportStreamAccessor* reader) {
+    EXPECT_EQ(readerIter->hasMissedEntries(reader), true);
+  });
+  EXPECT_EQ(didTransact, true);
+  EXPECT_EQ(writerTransport->transact(1ms, writeEvent), true);
+
+  // a stream that joins the domain afterwards leaves the healthy changelog alone
+  auto caughtUpIter = readerTransport->createIterator();
+  didTransact = readerTransport->transact(100ms, [&](TransportStreamAccessor* reader) {
+    while (!caughtUpIter->getNextEntry(reader).isNull()) {
+    }
+  });
+  EXPECT_EQ(didTransact, true);
+  EXPECT_EQ(writerTransport->transact(1ms, writeEvent), true);
+  SharedMemoryTransportStream lateTransport(name, config);
+  EXPECT_EQ(lateTransport.transact(1ms, writeEvent), true);
+  didTransact = readerTransport->transact(100ms, [&](TransportStreamAccessor* reader) {
+    EXPECT_EQ(caughtUpIter->hasMissedEntries(reader), false);
+  });
+  EXPECT_EQ(didTransact, true);
+}
+#endif
+
 TEST(SharedMemoryTransportStream, reverse_field_tests) {
   auto config = genConfig();
   auto name = randomName();
@@ -237,3 +388,55 @@ TEST(SharedMemoryTransportStream, indexing_tests) {
       writerInboundTransport,
       writerOutboundTransport);
 }
+
+TEST(SharedMemoryTransportStream, lock_free_reader_tests) {
+  auto config = genConfig(512); // intentionally small changelog
+  config.lockFree = true;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Outbound", config);
+  auto readerOutboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Inbound", config);
+
+  DataStoreReconcilerTest::RunReadReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+}
+
+TEST(SharedMemoryTransportStream, mirrored_changelog_writer_tests) {
+  // not a whole number of pages
+  auto config = genConfig(5000);
+  config.mirroredChangelog = true;
+  auto name = randomName();
+
+  auto writerInboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Inbound", config);
+  auto writerOutboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Outbound", config);
+
+  auto readerInboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Outbound", config);
+  auto readerOutboundTransport =
+      std::make_shared<SharedMemoryTransportStream>(name + "Inbound", config);
+
+  DataStoreReconcilerTest::RunWriteReconcilerTests(
+      readerInboundTransport,
+      readerOutboundTransport,
+      writerInboundTransport,
+      writerOutboundTransport);
+
+  // rounded up to whole pages
+  EXPECT_EQ(
+      writerOutboundTransport->getMetrics().changelogByteCount,
+      MemoryTransportStreamAccessor::getChangelogCapacity(config));
+  EXPECT_EQ(
+      MemoryTransportStreamAccessor::getChangelogCapacity(config) % getMemoryPageSize(), 0);
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <xrpa-runtime/transport/SocketTransportStream.h>
+#include <xrpa-runtime/transport/TransportStreamAccessor.h>
+
+#include "./DataStoreReconciler.test.h"
+#include "./Transport.test.h"
+
+using namespace Xrpa;
+using namespace std::chrono_literals;
+
+static TransportConfig genConfig(int changelogByteCount = 8192) {
+  TransportConfig config;
+  config.schemaHash =
+      HashValue(0x1111111111111111, 0x2222222222222222, 0x3333333333333333, 0x4444444444444444);
+  config.changelogByteCount = changelogByteCount;
+  return config;
+}
+
+static std::string randomName(int length = 16) {
+  const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  std::random_device rd;
+  std::mt19937 engine(rd());
+  std::uniform_int_distribution<> dist(0, chars.size() - 1);
+
+  std::string result;
+  result.reserve(length);
+
+  for (int i = 0; i < length; ++i) {
+    result += chars[dist(engine)];
+  }
+
+  return result;
+}
+
+static std::string unixAddress() {
+  return "unix:/tmp/xrpa-" + randomName(12) + ".sock";
+}
+
+// there is no background thread, so both ends have to be serviced for the handshake to complete
+static bool connectStreams(const std::vector<std::shared_ptr<SocketTransportStream>>& streams) {
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (std::chrono::steady_clock::now() < deadline) {
+    bool allConnected = true;
+    for (auto& stream : streams) {
+      allConnected = stream->waitForConnection(1ms) && allConnected;
+    }
+    if (allConnected) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// pairs a Listen stream (the reader) with a Connect stream (the writer)
+static std::pair<std::shared_ptr<SocketTransportStream>, std::shared_ptr<SocketTransportStream>>
+makeStreamPair(const std::string& address, const TransportConfig& config = genConfig()) {
+  auto name = randomName();
+  auto reader =
+      std::make_shared<SocketTransportStream>(name, config, address, SocketRole::Listen);
+  auto writer = std::make_shared<SocketTransportStream>(
+      name, config, reader->getAddress(), SocketRole::Connect);
+  return {reader, writer};
+}
+
+#if defined(__APPLE__) || defined(__linux__)
+
+TEST(SocketTransportStream, object_tests) {
+  auto [readerTransport, writerTransport] = makeStreamPair(unixAddress());
+  ASSERT_TRUE(connectStreams({readerTransport, writerTransport}));
+  TransportTest::RunTransportObjectTests(readerTransport, writerTransport);
+}
+
+TEST(SocketTransportStream, tcp_object_tests) {
+  auto [readerTransport, writerTransport] = makeStreamPair("tcp:127.0.0.1:0");
+  EXPECT_NE(readerTransport->getAddress(), "tcp:127.0.0.1:0");
+  ASSERT_TRUE(connectStreams({readerTransport, writerTransport}));
+  TransportTest::RunTransportObjectTests(readerTransport, writerTransport);
+}
+
+TEST(SocketTransportStream, wait_for_changes) {
+  auto [readerTransport, writerTransport] = makeStreamPair(unixAddress());
+  ASSERT_TRUE(connectStreams({readerTransport, writerTransport}));
+  TransportTest::RunWaitForChangesTests(readerTransport, writerTransport);
+}
+
+TEST(SocketTransportStream, event_timestamps) {
+  auto [readerTransport, writerTransport] = makeStreamPair(unixAddress());
+  ASSERT_TRUE(connectStreams({readerTransport, writerTransport}));
+  auto readerIter = readerTransport->createIterator();
+
+  // each end has its own base timestamp, so the events are re-based on arrival
+  std::vector<uint64_t> timestamps;
+  writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    auto baseTimestamp = accessor->getBaseTimestamp();
+    timestamps = {baseTimestamp + 1, baseTimestamp + 30ull * 24 * 3600 * 1000000 + 7,
+                  baseTimestamp - 5};
+    for (auto timestamp : timestamps) {
+      EXPECT_EQ(accessor->writeChangeEvent(0, 0, timestamp).isNull(), false);
+    }
+  });
+
+  std::vector<uint64_t> readTimestamps;
+  readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    for (auto entry = readerIter->getNextEntry(accessor); !entry.isNull();
+         entry = readerIter->getNextEntry(accessor)) {
+      readTimestamps.push_back(
+          ChangeEventAccessor(entry).getTimestamp(accessor->getBaseTimestamp()));
+    }
+  });
+  EXPECT_EQ(readTimestamps, timestamps);
+}
+
+TEST(SocketTransportStream, reconnect_reports_missed_entries) {
+  auto [readerTransport, writerTransport] = makeStreamPair(unixAddress());
+  auto readerIter = readerTransport->createIterator();
+  ASSERT_TRUE(connectStreams({readerTransport, writerTransport}));
+
+  auto readChangeTypes = [&, readerTransport = readerTransport](bool expectMissed) {
+    std::vector<int32_t> changeTypes;
+    readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      EXPECT_EQ(readerIter->hasMissedEntries(accessor), expectMissed);
+      EXPECT_EQ(readerIter->hasMissedEntries(accessor), false);
+      for (auto entry = readerIter->getNextEntry(accessor); !entry.isNull();
+           entry = readerIter->getNextEntry(accessor)) {
+        changeTypes.push_back(ChangeEventAccessor(entry).getChangeType());
+      }
+    });
+    return changeTypes;
+  };
+  auto writeChangeType = [writerTransport = writerTransport](int32_t changeType) {
+    writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      accessor->writeChangeEvent(changeType);
+    });
+  };
+
+  // the first connection counts as a reconnect for an iterator created before it
+  writeChangeType(1);
+  EXPECT_EQ(readChangeTypes(true), std::vector<int32_t>{1});
+
+  // writes made while disconnected never reach the reader
+  writerTransport->disconnect();
+  writeChangeType(2);
+  ASSERT_TRUE(connectStreams({readerTransport, writerTransport}));
+  writeChangeType(3);
+  EXPECT_EQ(readChangeTypes(true), std::vector<int32_t>{3});
+
+  writeChangeType(4);
+  EXPECT_EQ(readChangeTypes(false), std::vector<int32_t>{4});
+}
+
+TEST(SocketTransportStream, changelog_overflow_resyncs) {
+  auto [readerTransport, writerTransport] = makeStreamPair(unixAddress(), genConfig(512));
+  ASSERT_TRUE(connectStreams({readerTransport, writerTransport}));
+  auto readerIter = readerTransport->createIterator();
+
+  // the start of the transaction is evicted before it can be sent
+  writerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(accessor->writeChangeEvent(1).isNull(), false);
+    }
+  });
+
+  EXPECT_EQ(readerIter->waitForChanges(1s), true);
+  readerTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    EXPECT_EQ(readerIter->hasMissedEntries(accessor), true);
+    EXPECT_EQ(readerIter->getNextEntry(accessor).isNull(), true);
+  });
+}
+
+TEST(SocketTransportStream, schema_mismatch) {
+  auto name = randomName();
+  auto otherConfig = genConfig();
+  otherConfig.schemaHash = HashValue(1, 2, 3, 4);
+
+  auto readerTransport = std::make_shared<SocketTransportStream>(
+      name, genConfig(), unixAddress(), SocketRole::Listen);
+  auto writerTransport = std::make_shared<SocketTransportStream>(
+      name, otherConfig, readerTransport->getAddress(), SocketRole::Connect);
+
+  auto deadline = std::chrono::steady_clock::now() + 200ms;
+  while (std::chrono::steady_clock::now() < deadline) {
+    EXPECT_EQ(readerTransport->waitForConnection(1ms), false);
+    EXPECT_EQ(writerTransport->waitForConnection(1ms), false);
+  }
+}
+
+TEST(SocketTransportStream, read_reconciler) {
+  // intentionally small changelog, so that a transaction overflows it and forces a resync
+  auto config = genConfig(512);
+  auto [readerInbound, writerOutbound] = makeStreamPair(unixAddress(), config);
+  auto [writerInbound, readerOutbound] = makeStreamPair(unixAddress(), config);
+  ASSERT_TRUE(connectStreams({readerInbound, writerOutbound, writerInbound, readerOutbound}));
+  DataStoreReconcilerTest::RunReadReconcilerTests(
+      readerInbound, readerOutbound, writerInbound, writerOutbound);
+}
+
+TEST(SocketTransportStream, write_reconciler) {
+  auto [readerInbound, writerOutbound] = makeStreamPair(unixAddress());
+  auto [writerInbound, readerOutbound] = makeStreamPair(unixAddress());
+  ASSERT_TRUE(connectStreams({readerInbound, writerOutbound, writerInbound, readerOutbound}));
+  DataStoreReconcilerTest::RunWriteReconcilerTests(
+      readerInbound, readerOutbound, writerInbound, writerOutbound);
+}
+
+#endif
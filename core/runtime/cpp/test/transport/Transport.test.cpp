@@ -20,6 +20,8 @@
 #include <xrpa-runtime/transport/TransportStreamAccessor.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
 
+#include <chrono>
+#include <thread>
 #include <utility>
 
 using namespace Xrpa;
@@ -226,4 +228,37 @@ void RunTransportObjectTests(
   });
 }
 
+void RunWaitForChangesTests(
+    std::shared_ptr<TransportStream> inboundTransport,
+    std::shared_ptr<TransportStream> outboundTransport) {
+  auto readerIter = inboundTransport->createIterator();
+
+  // nothing written yet, so the wait times out
+  auto waitStart = std::chrono::steady_clock::now();
+  EXPECT_EQ(readerIter->waitForChanges(10ms), false);
+  EXPECT_GE(std::chrono::steady_clock::now() - waitStart, 10ms);
+
+  // a write from another thread wakes the reader well before the timeout
+  std::thread writerThread([&]() {
+    std::this_thread::sleep_for(20ms);
+    outboundTransport->transact(1ms, [&](TransportStreamAccessor* writer) {
+      auto foo1 = FooTypeWriter::create(writer, 0, foo1ID);
+      EXPECT_EQ(foo1.isNull(), false);
+    });
+  });
+  waitStart = std::chrono::steady_clock::now();
+  EXPECT_EQ(readerIter->waitForChanges(5s), true);
+  EXPECT_LT(std::chrono::steady_clock::now() - waitStart, 2s);
+  writerThread.join();
+
+  // unread changes are reported without waiting
+  EXPECT_EQ(readerIter->waitForChanges(0ms), true);
+
+  inboundTransport->transact(1ms, [&](TransportStreamAccessor* reader) {
+    auto entry = CollectionChangeEventAccessor(readerIter->getNextEntry(reader));
+    EXPECT_EQ(entry.getObjectId(), foo1ID);
+  });
+  EXPECT_EQ(readerIter->waitForChanges(0ms), false);
+}
+
 } // namespace TransportTest
@@ -25,4 +25,8 @@ void RunTransportObjectTests(
     std::shared_ptr<Xrpa::TransportStream> readerTransport,
     std::shared_ptr<Xrpa::TransportStream> writerTransport);
 
+void RunWaitForChangesTests(
+    std::shared_ptr<Xrpa::TransportStream> readerTransport,
+    std::shared_ptr<Xrpa::TransportStream> writerTransport);
+
 } // namespace TransportTest
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <xrpa-runtime/transport/HeapMemoryTransportStream.h>
+#include <xrpa-runtime/transport/TransportStreamAccessor.h>
+#include <xrpa-runtime/transport/TransportStreamCapture.h>
+
+using namespace Xrpa;
+using namespace std::chrono_literals;
+
+static TransportConfig genConfig(int changelogByteCount = 8192) {
+  TransportConfig config;
+  config.schemaHash =
+      HashValue(0x1111111111111111, 0x2222222222222222, 0x3333333333333333, 0x4444444444444444);
+  config.changelogByteCount = changelogByteCount;
+  return config;
+}
+
+static std::string randomName(int length = 16) {
+  const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  std::random_device rd;
+  std::mt19937 engine(rd());
+  std::uniform_int_distribution<> dist(0, chars.size() - 1);
+
+  std::string result;
+  result.reserve(length);
+
+  for (int i = 0; i < length; ++i) {
+    result += chars[dist(engine)];
+  }
+
+  return result;
+}
+
+static std::string capturePath() {
+  return "/tmp/xrpa-capture-" + randomName(12) + ".bin";
+}
+
+struct CapturedEvent {
+  int32_t changeType;
+  std::vector<uint8_t> payload;
+
+  bool operator==(const CapturedEvent& other) const {
+    return changeType == other.changeType && payload == other.payload;
+  }
+};
+
+// a change event followed by an opaque payload
+class PayloadEventAccessor : public ChangeEventAccessor {
+ public:
+  explicit PayloadEventAccessor(MemoryAccessor memAccessor)
+      : ChangeEventAccessor(std::move(memAccessor)) {}
+
+  uint8_t* getPayload(int32_t byteCount) {
+    return static_cast<uint8_t*>(memAccessor_.getRawPointer(DS_SIZE, byteCount));
+  }
+};
+
+static void writeEvent(
+    TransportStreamAccessor* accessor,
+    int32_t changeType,
+    uint8_t fill,
+    uint64_t timestampUs) {
+  auto event = accessor->writeChangeEvent<PayloadEventAccessor>(changeType, 16, timestampUs);
+  ASSERT_EQ(event.isNull(), false);
+  std::memset(event.getPayload(16), fill, 16);
+}
+
+static std::vector<CapturedEvent> readEvents(
+    TransportStream* transport,
+    TransportStreamIterator* iter) {
+  std::vector<CapturedEvent> events;
+  transport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    for (auto entry = iter->getNextEntry(accessor); !entry.isNull();
+         entry = iter->getNextEntry(accessor)) {
+      auto event = PayloadEventAccessor(entry);
+      auto* payload = event.getPayload(16);
+      events.push_back({event.getChangeType(), std::vector<uint8_t>(payload, payload + 16)});
+    }
+  });
+  return events;
+}
+
+TEST(TransportStreamCapture, record_and_replay) {
+  auto config = genConfig();
+  auto path = capturePath();
+  auto sourceTransport = std::make_shared<HeapMemoryTransportStream>(randomName(), config);
+
+  {
+    TransportStreamRecorder recorder(sourceTransport, path, config.schemaHash);
+    ASSERT_TRUE(recorder.isOpen());
+
+    // explicit timestamps, as back to back transactions can share a clock sample
+    auto timestampUs = getCurrentClockTimeMicroseconds();
+    sourceTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      writeEvent(accessor, 1, 0x11, timestampUs);
+      writeEvent(accessor, 2, 0x22, timestampUs);
+    });
+    sourceTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      writeEvent(accessor, 3, 0x33, timestampUs + 10);
+    });
+    EXPECT_EQ(recorder.recordPending(), 3);
+    EXPECT_EQ(recorder.recordPending(), 0);
+    EXPECT_EQ(recorder.getEventCount(), 3);
+  }
+
+  TransportStreamReplayer replayer(path);
+  ASSERT_TRUE(replayer.isOpen());
+  EXPECT_EQ(replayer.getSchemaHash(), config.schemaHash);
+  EXPECT_EQ(replayer.getEventCount(), 3);
+  EXPECT_EQ(replayer.getMissedEntryCount(), 0);
+
+  auto replayTransport = std::make_shared<HeapMemoryTransportStream>(randomName(), config);
+  auto replayIter = replayTransport->createIterator();
+  auto transactCount = replayTransport->getMetrics().transactCount;
+  EXPECT_EQ(replayer.replay(replayTransport.get(), TransportStreamReplayer::MAX_SPEED), 3);
+
+  // the events of each recorded transaction are replayed in one transaction
+  EXPECT_EQ(replayTransport->getMetrics().transactCount - transactCount, 2);
+
+  std::vector<CapturedEvent> expected = {
+      {1, std::vector<uint8_t>(16, 0x11)},
+      {2, std::vector<uint8_t>(16, 0x22)},
+      {3, std::vector<uint8_t>(16, 0x33)}};
+  EXPECT_EQ(readEvents(replayTransport.get(), replayIter.get()), expected);
+
+  std::remove(path.c_str());
+}
+
+TEST(TransportStreamCapture, capture_file_grows) {
+  auto config = genConfig(256 * 1024);
+  auto path = capturePath();
+  auto sourceTransport = std::make_shared<HeapMemoryTransportStream>(randomName(), config);
+
+  // well past the initial size of the capture file
+  constexpr int BATCH_COUNT = 40;
+  constexpr int BATCH_SIZE = 100;
+  constexpr int32_t EVENT_BYTE_COUNT = 1000;
+  {
+    TransportStreamRecorder recorder(sourceTransport, path, config.schemaHash);
+    for (int batch = 0; batch < BATCH_COUNT; ++batch) {
+      sourceTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+        for (int i = 0; i < BATCH_SIZE; ++i) {
+          auto event =
+              accessor->writeChangeEvent<PayloadEventAccessor>(batch, EVENT_BYTE_COUNT);
+          ASSERT_EQ(event.isNull(), false);
+          std::memset(event.getPayload(EVENT_BYTE_COUNT), batch, EVENT_BYTE_COUNT);
+        }
+      });
+      EXPECT_EQ(recorder.recordPending(), BATCH_SIZE);
+    }
+    EXPECT_EQ(recorder.getMissedEntryCount(), 0);
+  }
+
+  TransportStreamReplayer replayer(path);
+  ASSERT_TRUE(replayer.isOpen());
+  EXPECT_EQ(replayer.getEventCount(), BATCH_COUNT * BATCH_SIZE);
+
+  // the replayed stream only needs to hold the last batch for it to be checked
+  auto replayTransport = std::make_shared<HeapMemoryTransportStream>(randomName(), config);
+  auto replayIter = replayTransport->createIterator();
+  EXPECT_EQ(
+      replayer.replay(replayTransport.get(), TransportStreamReplayer::MAX_SPEED),
+      BATCH_COUNT * BATCH_SIZE);
+
+  replayTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+    replayIter->hasMissedEntries(accessor);
+    for (auto entry = replayIter->getNextEntry(accessor); !entry.isNull();
+         entry = replayIter->getNextEntry(accessor)) {
+      auto event = PayloadEventAccessor(entry);
+      EXPECT_EQ(event.getChangeType(), BATCH_COUNT - 1);
+      EXPECT_EQ(event.getPayload(EVENT_BYTE_COUNT)[EVENT_BYTE_COUNT - 1], BATCH_COUNT - 1);
+    }
+  });
+
+  std::remove(path.c_str());
+}
+
+TEST(TransportStreamCapture, replay_pacing) {
+  auto config = genConfig();
+  auto path = capturePath();
+  auto sourceTransport = std::make_shared<HeapMemoryTransportStream>(randomName(), config);
+
+  {
+    TransportStreamRecorder recorder(sourceTransport, path, config.schemaHash);
+    sourceTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
+      auto baseTimestamp = getCurrentClockTimeMicroseconds();
+      for (int i = 0; i < 3; ++i) {
+        accessor->writeChangeEvent(i, 0, baseTimestamp + i * 40000);
+      }
+    });
+    EXPECT_EQ(recorder.recordPending(), 3);
+  }
+
+  TransportStreamReplayer replayer(path);
+  auto replayTransport = std::make_shared<HeapMemoryTransportStream>(randomName(), config);
+
+  // the last event was captured 80ms after the first
+  auto replayStart = std::chrono::steady_clock::now();
+  EXPECT_EQ(replayer.replay(replayTransport.get(), 1), 3);
+  EXPECT_GE(std::chrono::steady_clock::now() - replayStart, 80ms);
+
+  replayStart = std::chrono::steady_clock::now();
+  EXPECT_EQ(replayer.replay(replayTransport.get(), 2), 3);
+  auto elapsed = std::chrono::steady_clock::now() - replayStart;
+  EXPECT_GE(elapsed, 40ms);
+  EXPECT_LT(elapsed, 80ms);
+
+  replayStart = std::chrono::steady_clock::now();
+  EXPECT_EQ(replayer.replay(replayTransport.get(), TransportStreamReplayer::MAX_SPEED), 3);
+  EXPECT_LT(std::chrono::steady_clock::now() - replayStart, 40ms);
+
+  std::remove(path.c_str());
+}
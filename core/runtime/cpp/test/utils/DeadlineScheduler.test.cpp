@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include <xrpa-runtime/utils/DeadlineScheduler.h>
+
+using namespace Xrpa;
+using namespace std::chrono_literals;
+
+TEST(DeadlineScheduler, MultiRate) {
+  DeadlineScheduler scheduler;
+  int fastCount = 0;
+  int slowCount = 0;
+  scheduler.addTask("fast", 2ms, [&]() { fastCount++; });
+  scheduler.addTask("slow", 10ms, [&]() { slowCount++; });
+
+  // stop after the slow task has run 10 times, which takes 90ms from the first release
+  scheduler.run([&]() { return slowCount < 10; });
+
+  // the fast task runs five times for every slow task run, give or take scheduling noise
+  EXPECT_GE(fastCount, 40);
+  EXPECT_LE(fastCount, 50);
+
+  auto& stats = scheduler.getTaskStats();
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats[0].name, "fast");
+  EXPECT_EQ(stats[0].runCount, static_cast<uint64_t>(fastCount));
+  EXPECT_EQ(stats[1].name, "slow");
+  EXPECT_EQ(stats[1].runCount, 10u);
+  EXPECT_EQ(stats[1].period, 10ms);
+  EXPECT_EQ(stats[1].deadline, 10ms);
+}
+
+TEST(DeadlineScheduler, OverrunAndSkip) {
+  DeadlineScheduler scheduler;
+  int runCount = 0;
+  scheduler.addTask(
+      "slow",
+      2ms,
+      [&]() {
+        runCount++;
+        if (runCount == 2) {
+          // misses its 1ms deadline and several of the following releases
+          std::this_thread::sleep_for(9ms);
+        }
+      },
+      1ms);
+
+  scheduler.run([&]() { return runCount < 4; });
+
+  auto& stats = scheduler.getTaskStats()[0];
+  EXPECT_EQ(stats.runCount, 4u);
+  EXPECT_GE(stats.overrunCount, 1u);
+  EXPECT_GE(stats.skippedCount, 3u);
+  EXPECT_GE(stats.maxRunTime, 9ms);
+
+  std::stringstream ss;
+  scheduler.dumpTaskStats(ss);
+  EXPECT_NE(ss.str().find("slow: period=2000us runs=4"), std::string::npos);
+
+  scheduler.resetTaskStats();
+  EXPECT_EQ(scheduler.getTaskStats()[0].runCount, 0u);
+}
+
+TEST(DeadlineScheduler, RemoveTask) {
+  DeadlineScheduler scheduler;
+  int runCount = 0;
+  scheduler.addTask("a", 1ms, [&]() { runCount++; });
+  scheduler.addTask("b", 1ms, [&]() { runCount++; });
+  scheduler.removeTask("a");
+  ASSERT_EQ(scheduler.getTaskStats().size(), 1u);
+  EXPECT_EQ(scheduler.getTaskStats()[0].name, "b");
+
+  scheduler.removeTask("b");
+  scheduler.run([&]() { return true; });
+  EXPECT_EQ(runCount, 0);
+}
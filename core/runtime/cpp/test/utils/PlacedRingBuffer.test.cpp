@@ -15,8 +15,12 @@
  */
 
 #include <folly/portability/GTest.h>
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <vector>
 
+#include <xrpa-runtime/utils/MirroredMapping.h>
 #include <xrpa-runtime/utils/PlacedRingBuffer.h>
 
 using namespace Xrpa;
@@ -245,3 +249,139 @@ TEST(PlacedRingBuffer, iterator) {
   EXPECT_EQ(iter.hasMissedEntries(testRingBuffer), false);
   EXPECT_EQ(iter.hasNext(testRingBuffer), false);
 }
+
+TEST(PlacedRingBuffer, grow) {
+  constexpr int32_t ELEMENT_SIZE = 96;
+  constexpr int32_t ELEMENT_STRIDE = PlacedRingBuffer::ELEMENT_HEADER_SIZE + ELEMENT_SIZE;
+  std::array<unsigned char, sizeof(PlacedRingBuffer) + 8 * ELEMENT_STRIDE> buffer{};
+  auto* ringBuffer = reinterpret_cast<PlacedRingBuffer*>(buffer.data());
+
+  auto pushValue = [&](int32_t value) {
+    MemoryOffset offset;
+    ringBuffer->push(ELEMENT_SIZE, nullptr).writeValue<int32_t>(value, offset);
+  };
+  auto expectValues = [&](int32_t first, int32_t last) {
+    EXPECT_EQ(ringBuffer->count, last - first + 1);
+    PlacedRingBufferIterator iter;
+    for (int32_t value = first; value <= last; ++value) {
+      MemoryOffset offset;
+      EXPECT_EQ(iter.next(ringBuffer).readValue<int32_t>(offset), value);
+    }
+  };
+
+  // unwrapped, the new space is used right away
+  ringBuffer->init(4 * ELEMENT_STRIDE);
+  pushValue(0);
+  pushValue(1);
+  ringBuffer->grow(8 * ELEMENT_STRIDE);
+  EXPECT_EQ(ringBuffer->prewrapOffset, 8 * ELEMENT_STRIDE);
+  for (int32_t i = 2; i < 8; ++i) {
+    pushValue(i);
+  }
+  EXPECT_EQ(ringBuffer->startID, 0);
+  expectValues(0, 7);
+
+  // wrapped, elements keep being shifted out until the start wraps around
+  ringBuffer->init(4 * ELEMENT_STRIDE);
+  for (int32_t i = 0; i < 5; ++i) {
+    pushValue(i);
+  }
+  ringBuffer->grow(8 * ELEMENT_STRIDE);
+  EXPECT_EQ(ringBuffer->prewrapOffset, 4 * ELEMENT_STRIDE);
+  expectValues(1, 4);
+  for (int32_t i = 5; i < 8; ++i) {
+    pushValue(i);
+  }
+  expectValues(4, 7);
+  for (int32_t i = 8; i < 12; ++i) {
+    pushValue(i);
+  }
+  EXPECT_EQ(ringBuffer->prewrapOffset, 8 * ELEMENT_STRIDE);
+  expectValues(4, 11);
+
+  // never shrinks
+  ringBuffer->grow(4 * ELEMENT_STRIDE);
+  EXPECT_EQ(ringBuffer->poolSize, 8 * ELEMENT_STRIDE);
+}
+
+TEST(PlacedRingBuffer, indexed_lookup) {
+  constexpr int32_t INDEX_CAPACITY = 8;
+  std::array<unsigned char, sizeof(PlacedRingBuffer) + 512> buffer{};
+  std::array<unsigned char, sizeof(PlacedRingBufferIndex) + INDEX_CAPACITY * sizeof(int32_t)>
+      indexBuffer{};
+  auto* ringBuffer = reinterpret_cast<PlacedRingBuffer*>(buffer.data());
+  auto* index = reinterpret_cast<PlacedRingBufferIndex*>(indexBuffer.data());
+  EXPECT_EQ(PlacedRingBufferIndex::getMemSize(INDEX_CAPACITY), sizeof(indexBuffer));
+  ringBuffer->init(512);
+  index->init(INDEX_CAPACITY);
+
+  // mixed sizes, so that the ring wraps at varying offsets and holds more elements than the index
+  for (int32_t value = 0; value < 200; ++value) {
+    int32_t id = 0;
+    MemoryOffset writeOffset;
+    ringBuffer->push(4 + (value % 7) * 8, &id, index).writeValue<int32_t>(value, writeOffset);
+    EXPECT_EQ(id, value);
+    if (value % 13 == 0) {
+      ringBuffer->shift();
+    }
+
+    for (int32_t readId = ringBuffer->getMinID(); readId <= ringBuffer->getMaxID(); ++readId) {
+      MemoryOffset readOffset;
+      EXPECT_EQ(ringBuffer->getByID(readId, index).readValue<int32_t>(readOffset), readId);
+
+      PlacedRingBufferIterator iter;
+      EXPECT_EQ(iter.setToId(ringBuffer, readId - 1, index), true);
+      MemoryOffset nextOffset;
+      EXPECT_EQ(iter.next(ringBuffer).readValue<int32_t>(nextOffset), readId);
+      if (readId < ringBuffer->getMaxID()) {
+        EXPECT_EQ(iter.setToId(ringBuffer, readId, index), true);
+        MemoryOffset afterOffset;
+        EXPECT_EQ(iter.next(ringBuffer).readValue<int32_t>(afterOffset), readId + 1);
+      }
+    }
+  }
+}
+
+TEST(PlacedRingBuffer, mirrored) {
+  auto pageSize = static_cast<size_t>(getMemoryPageSize());
+  // the ring buffer header sits at the end of the first page, so the pool is the second page
+  auto* mem = mapMemoryWithMirror(2 * pageSize, pageSize, pageSize, false);
+  bool isMapped = mem != nullptr;
+  std::vector<uint8_t> plainMem;
+  if (!isMapped) {
+    // elements are still contiguous, the mirror is just not backed by the pool
+    plainMem.resize(3 * pageSize);
+    mem = plainMem.data();
+  }
+  auto* ringBuffer = reinterpret_cast<PlacedRingBuffer*>(mem + pageSize - sizeof(PlacedRingBuffer));
+  auto poolSize = static_cast<int32_t>(pageSize);
+  ringBuffer->initMirrored(poolSize);
+  EXPECT_EQ(ringBuffer->isMirrored(), true);
+
+  // an element size that does not divide the pool, so elements straddle its end
+  constexpr int32_t ELEMENT_SIZE = 300;
+  constexpr int32_t ELEMENT_STRIDE = PlacedRingBuffer::ELEMENT_HEADER_SIZE + ELEMENT_SIZE;
+  PlacedRingBufferIterator iter;
+  int straddleCount = 0;
+  for (int32_t value = 0; value < 3 * poolSize / ELEMENT_STRIDE; ++value) {
+    auto elem = ringBuffer->push(ELEMENT_SIZE, nullptr);
+    ASSERT_EQ(elem.isNull(), false);
+    std::fill_n(static_cast<uint8_t*>(elem.getRawPointer(0, ELEMENT_SIZE)), ELEMENT_SIZE, value);
+    straddleCount += elem.getOffset() + ELEMENT_SIZE > poolSize ? 1 : 0;
+
+    // no space is skipped at the end of the pool, so it always holds as many as fit
+    EXPECT_EQ(ringBuffer->count, std::min(value + 1, poolSize / ELEMENT_STRIDE));
+
+    auto readElem = iter.next(ringBuffer);
+    auto* readPtr = static_cast<uint8_t*>(readElem.getRawPointer(0, ELEMENT_SIZE));
+    EXPECT_EQ(
+        std::count(readPtr, readPtr + ELEMENT_SIZE, static_cast<uint8_t>(value)), ELEMENT_SIZE);
+  }
+  EXPECT_GT(straddleCount, 0);
+
+  if (isMapped) {
+    // writes that ran on into the mirror landed at the start of the pool
+    EXPECT_EQ(std::memcmp(mem + pageSize, mem + 2 * pageSize, pageSize), 0);
+    unmapWithMirror(mem, 3 * pageSize);
+  }
+}
@@ -145,8 +145,10 @@ TEST(SpmcRingBuffer, MultiBlockEntry) {
     writeData[i] = static_cast<uint8_t>(i & 0xFF);
   }
 
-  bool writeResult = ringBuffer.write(
-      largeDataSize, [&](MemoryAccessor accessor) { accessor.copyFrom(writeData.data()); });
+  // the accessor spans whole blocks, so only copy the entry's own bytes into it
+  bool writeResult = ringBuffer.write(largeDataSize, [&](MemoryAccessor accessor) {
+    accessor.slice(0, largeDataSize).copyFrom(writeData.data());
+  });
   EXPECT_TRUE(writeResult);
 
   // Read the data back
@@ -426,8 +428,9 @@ TEST(SpmcRingBuffer, WraparoundWithMultiBlock) {
   constexpr int32_t multiBlockDataSize = 50;
   std::vector<uint8_t> writeData(multiBlockDataSize, 0xAB);
 
-  bool writeResult = ringBuffer.write(
-      multiBlockDataSize, [&](MemoryAccessor accessor) { accessor.copyFrom(writeData.data()); });
+  bool writeResult = ringBuffer.write(multiBlockDataSize, [&](MemoryAccessor accessor) {
+    accessor.slice(0, multiBlockDataSize).copyFrom(writeData.data());
+  });
   EXPECT_TRUE(writeResult);
 
   // Skip to the last entry (the multi-block one)
@@ -445,3 +448,68 @@ TEST(SpmcRingBuffer, WraparoundWithMultiBlock) {
     }
   }
 }
+
+TEST(SpmcRingBuffer, ReserveCommit) {
+  initTestBuffer();
+
+  MemoryAccessor mem = getTestMemoryAccessor();
+  SpmcRingBuffer ringBuffer(mem, 0);
+  SpmcRingBufferIterator iter;
+
+  // Reserve a batch of entries
+  for (int32_t i = 0; i < 3; ++i) {
+    auto accessor = ringBuffer.reserve(sizeof(int32_t));
+    EXPECT_FALSE(accessor.isNull());
+    EXPECT_EQ(accessor.getSize(), static_cast<int32_t>(sizeof(int32_t)));
+    MemoryOffset pos;
+    accessor.writeValue<int32_t>(i, pos);
+  }
+
+  // Nothing is visible until the batch is committed
+  EXPECT_FALSE(iter.hasNext(&ringBuffer));
+
+  ringBuffer.commitWrites();
+
+  std::vector<int32_t> readValues;
+  while (iter.hasNext(&ringBuffer)) {
+    EXPECT_TRUE(iter.readNext(&ringBuffer, [&](MemoryAccessor accessor) {
+      EXPECT_EQ(accessor.getSize(), static_cast<int32_t>(sizeof(int32_t)));
+      MemoryOffset pos;
+      readValues.push_back(accessor.readValue<int32_t>(pos));
+    }));
+  }
+  EXPECT_EQ(readValues, std::vector<int32_t>({0, 1, 2}));
+
+  // Committing again with nothing reserved is a no-op
+  ringBuffer.commitWrites();
+  EXPECT_FALSE(iter.hasNext(&ringBuffer));
+}
+
+TEST(SpmcRingBuffer, ReserveOverflowEvictsUncommitted) {
+  initTestBuffer();
+
+  MemoryAccessor mem = getTestMemoryAccessor();
+  SpmcRingBuffer ringBuffer(mem, 0);
+  SpmcRingBufferIterator iter;
+
+  // A batch larger than the whole pool evicts its own oldest entries
+  for (int32_t i = 0; i < BLOCK_COUNT * 2; ++i) {
+    auto accessor = ringBuffer.reserve(sizeof(int32_t));
+    EXPECT_FALSE(accessor.isNull());
+    MemoryOffset pos;
+    accessor.writeValue<int32_t>(i, pos);
+  }
+  ringBuffer.commitWrites();
+
+  EXPECT_TRUE(iter.hasMissedEntries(&ringBuffer));
+
+  std::vector<int32_t> readValues;
+  while (iter.hasNext(&ringBuffer)) {
+    iter.readNext(&ringBuffer, [&](MemoryAccessor accessor) {
+      MemoryOffset pos;
+      readValues.push_back(accessor.readValue<int32_t>(pos));
+    });
+  }
+  EXPECT_EQ(readValues.size(), static_cast<size_t>(BLOCK_COUNT));
+  EXPECT_EQ(readValues.back(), BLOCK_COUNT * 2 - 1);
+}
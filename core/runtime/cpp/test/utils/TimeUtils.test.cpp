@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <chrono>
+#include <thread>
+
+#include <xrpa-runtime/utils/TimeUtils.h>
+
+using namespace Xrpa;
+using namespace std::chrono_literals;
+
+TEST(TimeUtils, ClockTickScope) {
+  auto beforeUs = getCurrentClockTimeMicroseconds();
+  {
+    ClockTickScope outerTick;
+    auto tickUs = getCurrentClockTimeMicroseconds();
+    auto tickSteadyTime = getCurrentSteadyTime();
+    EXPECT_GE(tickUs, beforeUs);
+
+    std::this_thread::sleep_for(2ms);
+    EXPECT_EQ(getCurrentClockTimeMicroseconds(), tickUs);
+    EXPECT_EQ(getCurrentSteadyTime(), tickSteadyTime);
+
+    {
+      // nested scopes keep the outer sample
+      ClockTickScope innerTick;
+      EXPECT_EQ(getCurrentClockTimeMicroseconds(), tickUs);
+    }
+    EXPECT_EQ(getCurrentClockTimeMicroseconds(), tickUs);
+
+    // the sample is per thread
+    uint64_t otherThreadUs = 0;
+    std::thread([&]() { otherThreadUs = getCurrentClockTimeMicroseconds(); }).join();
+    EXPECT_GT(otherThreadUs, tickUs);
+  }
+
+  EXPECT_GT(getCurrentClockTimeMicroseconds(), beforeUs);
+}
+
+TEST(TimeUtils, MonotonicClockTime) {
+  auto prevUs = getCurrentClockTimeMicroseconds();
+  for (int i = 0; i < 1000; ++i) {
+    auto nowUs = getCurrentClockTimeMicroseconds();
+    EXPECT_GE(nowUs, prevUs);
+    prevUs = nowUs;
+  }
+}
@@ -35,6 +35,8 @@ class CollectionChangeEventAccessor : public ChangeEventAccessor {
  public:
   static constexpr int32_t DS_SIZE = ChangeEventAccessor::DS_SIZE + 20;
 
+  // A null accessor, left by a change event the transport could not write, ignores the setters
+  // and has null change data.
   explicit CollectionChangeEventAccessor(MemoryAccessor memAccessor)
       : ChangeEventAccessor(std::move(memAccessor)) {}
 
@@ -44,6 +46,9 @@ class CollectionChangeEventAccessor : public ChangeEventAccessor {
   }
 
   void setObjectId(const ObjectUuid& id) {
+    if (memAccessor_.isNull()) {
+      return;
+    }
     auto offset = MemoryOffset(ChangeEventAccessor::DS_SIZE);
     ObjectUuid::writeValue(id, memAccessor_, offset);
   }
@@ -54,11 +59,17 @@ class CollectionChangeEventAccessor : public ChangeEventAccessor {
   }
 
   void setCollectionId(int32_t collectionId) {
+    if (memAccessor_.isNull()) {
+      return;
+    }
     auto offset = MemoryOffset(ChangeEventAccessor::DS_SIZE + 16);
     memAccessor_.writeValue<int32_t>(collectionId, offset);
   }
 
   virtual MemoryAccessor accessChangeData() {
+    if (memAccessor_.isNull()) {
+      return {};
+    }
     return memAccessor_.slice(DS_SIZE);
   }
 };
@@ -76,11 +87,17 @@ class CollectionUpdateChangeEventAccessor : public CollectionChangeEventAccessor
   }
 
   void setFieldsChanged(uint64_t fieldsChanged) {
+    if (memAccessor_.isNull()) {
+      return;
+    }
     auto offset = MemoryOffset(CollectionChangeEventAccessor::DS_SIZE);
     memAccessor_.writeValue<uint64_t>(fieldsChanged, offset);
   }
 
   MemoryAccessor accessChangeData() override {
+    if (memAccessor_.isNull()) {
+      return {};
+    }
     return memAccessor_.slice(DS_SIZE);
   }
 };
@@ -99,11 +116,17 @@ class CollectionMessageChangeEventAccessor : public CollectionChangeEventAccesso
   }
 
   void setFieldId(int32_t fieldId) {
+    if (memAccessor_.isNull()) {
+      return;
+    }
     auto offset = MemoryOffset(CollectionChangeEventAccessor::DS_SIZE);
     memAccessor_.writeValue<int32_t>(fieldId, offset);
   }
 
   MemoryAccessor accessChangeData() override {
+    if (memAccessor_.isNull()) {
+      return {};
+    }
     return memAccessor_.slice(DS_SIZE);
   }
 };
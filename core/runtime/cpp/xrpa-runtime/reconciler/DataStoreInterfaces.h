@@ -18,6 +18,7 @@
 
 #include <xrpa-runtime/reconciler/DataStoreReconciler.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
+#include <functional>
 #include <memory>
 #include <type_traits>
 #include <unordered_set>
@@ -43,6 +44,16 @@ class IObjectCollection {
     return reconciler_->sendMessage(id, collectionId_, messageType, numBytes);
   }
 
+  // runs func, which sends messages; they are serialized directly into the transport if the data
+  // store has DataStoreReconciler::setDirectOutboundMessages() enabled
+  void sendDirectMessages(const std::function<void()>& func) {
+    if (reconciler_->getDirectOutboundMessages()) {
+      reconciler_->transactOutboundMessages(func);
+    } else {
+      func();
+    }
+  }
+
   void notifyObjectNeedsWrite(const ObjectUuid& objectId) {
     reconciler_->notifyObjectNeedsWrite(objectId, collectionId_);
   }
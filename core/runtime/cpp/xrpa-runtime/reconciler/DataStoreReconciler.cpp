@@ -18,6 +18,7 @@
 
 #include <xrpa-runtime/reconciler/CollectionChangeTypes.h>
 #include <xrpa-runtime/reconciler/DataStoreInterfaces.h>
+#include <xrpa-runtime/utils/TimeUtils.h>
 #include <algorithm>
 #include <unordered_set>
 
@@ -31,6 +32,7 @@ DataStoreReconciler::DataStoreReconciler(
     int messageDataPoolSize)
     : inboundTransport_(inboundTransport), outboundTransport_(outboundTransport) {
   setMessageLifetime(5s);
+  setSnapshotInterval(100ms);
 
   if (messageDataPoolSize > 0) {
     outboundMessages_ =
@@ -47,6 +49,18 @@ MemoryAccessor DataStoreReconciler::sendMessage(
     int32_t collectionId,
     int32_t fieldId,
     int32_t numBytes) {
+  if (directMessageAccessor_ != nullptr) {
+    auto message = directMessageAccessor_->writeChangeEvent<CollectionMessageChangeEventAccessor>(
+        CollectionChangeType::Message, numBytes);
+    if (!message.isNull()) {
+      message.setObjectId(objectId);
+      message.setCollectionId(collectionId);
+      message.setFieldId(fieldId);
+      return message.accessChangeData();
+    }
+    // the message does not fit in the changelog, so fall back to staging it
+  }
+
   auto message = CollectionMessageChangeEventAccessor(
       outboundMessages_->push(CollectionMessageChangeEventAccessor::DS_SIZE + numBytes, nullptr));
   message.setChangeType(CollectionChangeType::Message);
@@ -56,6 +70,34 @@ MemoryAccessor DataStoreReconciler::sendMessage(
   return message.accessChangeData();
 }
 
+void DataStoreReconciler::transactOutboundMessages(const std::function<void()>& func) {
+  auto outboundTransport = outboundTransport_.lock();
+  if (!outboundTransport || directMessageAccessor_ != nullptr) {
+    func();
+    return;
+  }
+
+  // acquire lock
+  bool isWriteBlocked = false;
+  auto timeout = getTransactTimeout(outboundTransactState_);
+  auto didLock = outboundTransport->transact(timeout, [&](TransportStreamAccessor* accessor) {
+    // write out everything already pending first, so that the direct messages stay ordered
+    // after any object changes and staged messages that preceded them
+    reconcileOutboundChanges(accessor);
+
+    directMessageAccessor_ = accessor;
+    func();
+    directMessageAccessor_ = nullptr;
+    isWriteBlocked = accessor->isWriteBlocked();
+  });
+  recordTransactResult(outboundTransactState_, didLock);
+  outboundTransactState_.retryPending |= isWriteBlocked;
+
+  if (!didLock) {
+    func();
+  }
+}
+
 void DataStoreReconciler::registerCollection(std::shared_ptr<IObjectCollection> collection) {
   auto collectionId = collection->getId();
   collections_.try_emplace(collectionId, std::move(collection));
@@ -72,14 +114,8 @@ void DataStoreReconciler::tickInbound() {
     return;
   }
 
-  // acquire lock
-  auto didLock = inboundTransport->transact(
-      1ms, [&](TransportStreamAccessor* accessor) { reconcileInboundChanges(accessor); });
-
-  if (!didLock) {
-    // TODO raise a warning about this, the expiry time for the transact call may need adjusting
-    return;
-  }
+  ClockTickScope clockTick;
+  transactInbound(inboundTransport.get());
 }
 
 void DataStoreReconciler::tickOutbound() {
@@ -88,27 +124,101 @@ void DataStoreReconciler::tickOutbound() {
     return;
   }
 
+  ClockTickScope clockTick;
   for (auto& iter : collections_) {
     iter.second->tick();
   }
 
+  if (stageOutboundChanges_) {
+    // serialize the changes before taking the lock, so the lock is only held for the copy
+    stageOutboundChanges();
+  }
+
   bool bHasOutboundMessages =
       outboundMessages_ != nullptr && outboundMessagesIterator_.hasNext(outboundMessages_);
-  bool bHasOutboundChanges =
-      requestInboundFullUpdate_ || pendingOutboundFullUpdate_ || !pendingWrites_.empty();
+  bool bHasOutboundChanges = requestInboundFullUpdate_ || pendingOutboundFullUpdate_ ||
+      !pendingWrites_.empty() || !outboundStagingEntries_.empty() || isOutboundSnapshotDue();
 
   if (!bHasOutboundChanges && !bHasOutboundMessages && !outboundTransport->needsHeartbeat()) {
     return;
   }
 
-  // acquire lock
-  auto didLock = outboundTransport->transact(
-      1ms, [&](TransportStreamAccessor* accessor) { reconcileOutboundChanges(accessor); });
+  transactOutbound(outboundTransport.get());
+}
 
-  if (!didLock) {
-    // TODO raise a warning about this, the expiry time for the transact call may need adjusting
+void DataStoreReconciler::retryPendingTransactions() {
+  if (inboundTransactState_.retryPending) {
+    if (auto inboundTransport = inboundTransport_.lock()) {
+      transactInbound(inboundTransport.get());
+    }
+  }
+
+  if (outboundTransactState_.retryPending) {
+    // the changes stay queued across a failed transact, so there is nothing to re-tick
+    if (auto outboundTransport = outboundTransport_.lock()) {
+      transactOutbound(outboundTransport.get());
+    }
+  }
+}
+
+std::chrono::milliseconds DataStoreReconciler::getTransactTimeout(
+    const TransactState& state) const {
+  if (state.consecutiveFailures >= transactRetryPolicy_.escalateAfterFailures) {
+    return transactRetryPolicy_.escalatedTimeout;
+  }
+  return transactRetryPolicy_.timeout;
+}
+
+void DataStoreReconciler::recordTransactResult(TransactState& state, bool didLock) {
+  // failures are also counted in the transport's TransportStreamMetrics::transactFailures
+  state.retryPending = !didLock;
+  state.consecutiveFailures = didLock ? 0 : state.consecutiveFailures + 1;
+}
+
+void DataStoreReconciler::transactInbound(TransportStream* inboundTransport) {
+  auto timeout = getTransactTimeout(inboundTransactState_);
+
+  if (deferInboundDispatch_) {
+    // acquire lock just long enough to copy out the pending changes
+    uint64_t baseTimestamp = 0;
+    bool hasChanges = false;
+    auto didLock = inboundTransport->transact(timeout, [&](TransportStreamAccessor* accessor) {
+      hasChanges = copyInboundChanges(accessor, baseTimestamp);
+    });
+    recordTransactResult(inboundTransactState_, didLock);
+
+    if (didLock && hasChanges) {
+      size_t entryIndex = 0;
+      dispatchInboundChanges(baseTimestamp, [&]() {
+        if (entryIndex >= inboundScratchEntries_.size()) {
+          return MemoryAccessor();
+        }
+        auto& entry = inboundScratchEntries_[entryIndex++];
+        return MemoryAccessor(inboundScratch_.data(), entry.offset_, entry.size_);
+      });
+    }
     return;
   }
+
+  // acquire lock
+  auto didLock = inboundTransport->transact(
+      timeout, [&](TransportStreamAccessor* accessor) { reconcileInboundChanges(accessor); });
+  recordTransactResult(inboundTransactState_, didLock);
+}
+
+void DataStoreReconciler::transactOutbound(TransportStream* outboundTransport) {
+  // acquire lock
+  bool isWriteBlocked = false;
+  auto didLock = outboundTransport->transact(
+      getTransactTimeout(outboundTransactState_), [&](TransportStreamAccessor* accessor) {
+        reconcileOutboundChanges(accessor);
+        isWriteBlocked = accessor->isWriteBlocked();
+      });
+  recordTransactResult(outboundTransactState_, didLock);
+
+  // the changes refused by a lagging lossless reader are still queued, so retry them the same way
+  // as a missed lock, without escalating the timeout
+  outboundTransactState_.retryPending |= isWriteBlocked;
 }
 
 void DataStoreReconciler::shutdown() {
@@ -118,52 +228,185 @@ void DataStoreReconciler::shutdown() {
   }
 
   // acquire lock
-  outboundTransport->transact(1ms, [&](TransportStreamAccessor* accessor) {
-    accessor->writeChangeEvent(CollectionChangeType::Shutdown);
-  });
+  outboundTransport->transact(
+      transactRetryPolicy_.escalatedTimeout, [&](TransportStreamAccessor* accessor) {
+        accessor->writeChangeEvent(CollectionChangeType::Shutdown);
+      });
 
   inboundTransport_.reset();
   outboundTransport_.reset();
 }
 
 void DataStoreReconciler::reconcileOutboundChanges(TransportStreamAccessor* accessor) {
+  // staged changes are older than anything still pending
+  flushStagedOutboundChanges(accessor);
+
+  outboundSupportsSnapshot_ = accessor->canWriteSnapshot();
+  outboundStagingBaseTimestamp_ = accessor->getBaseTimestamp();
+
+  writeOutboundObjectChanges(accessor);
+
+  // write messages
+  if (outboundMessages_ != nullptr) {
+    while (outboundMessagesIterator_.hasNext(outboundMessages_)) {
+      auto prevIterator = outboundMessagesIterator_;
+      auto message = outboundMessagesIterator_.next(outboundMessages_);
+      accessor->writePrefilledChangeEvent(message);
+      if (accessor->isWriteBlocked()) {
+        // keep the refused message and those after it for the next transaction
+        outboundMessagesIterator_ = prevIterator;
+        break;
+      }
+    }
+  }
+
+  // the full update prep would clobber the change bits of refused objects
+  if (!accessor->isWriteBlocked() && isOutboundSnapshotDue()) {
+    writeOutboundSnapshot(accessor);
+  }
+}
+
+void DataStoreReconciler::writeOutboundObjectChanges(TransportStreamAccessor* accessor) {
+  if ((pendingOutboundFullUpdate_ || !pendingWrites_.empty()) && outboundSupportsSnapshot_) {
+    outboundSnapshotDirty_ = true;
+  }
+
   if (requestInboundFullUpdate_) {
     accessor->writeChangeEvent(CollectionChangeType::RequestFullUpdate);
-    requestInboundFullUpdate_ = false;
+    requestInboundFullUpdate_ = accessor->isWriteBlocked();
   }
 
   if (pendingOutboundFullUpdate_) {
     accessor->writeChangeEvent(CollectionChangeType::FullUpdate);
-    pendingOutboundFullUpdate_ = false;
+    pendingOutboundFullUpdate_ = accessor->isWriteBlocked();
   }
 
-  // write changes
+  // write changes; a refused object keeps its change bits, so it stays queued along with every
+  // object after it
+  size_t writtenCount = 0;
   for (auto& pendingWrite : pendingWrites_) {
+    if (accessor->isWriteBlocked()) {
+      break;
+    }
     if (auto iter = collections_.find(pendingWrite.collectionId_); iter != collections_.end()) {
       iter->second->writeChanges(accessor, pendingWrite.objectId_);
     }
+    if (accessor->isWriteBlocked()) {
+      break;
+    }
+    writtenCount++;
   }
-  pendingWrites_.clear();
+  pendingWrites_.erase(pendingWrites_.begin(), pendingWrites_.begin() + writtenCount);
+}
 
-  // write messages
-  if (outboundMessages_ != nullptr) {
-    while (outboundMessagesIterator_.hasNext(outboundMessages_)) {
-      auto message = outboundMessagesIterator_.next(outboundMessages_);
-      accessor->writePrefilledChangeEvent(message);
+void DataStoreReconciler::stageOutboundChanges() {
+  if (outboundStagingBaseTimestamp_ == 0) {
+    // event timestamps are relative to the transport base timestamp, which is only known once
+    // the first transact has gone through
+    return;
+  }
+
+  TransportStreamAccessor stagingAccessor{
+      outboundStagingBaseTimestamp_, nullptr, [&](int32_t byteCount) -> MemoryAccessor {
+        return allocateStagedOutboundChange(byteCount);
+      }};
+  writeOutboundObjectChanges(&stagingAccessor);
+}
+
+MemoryAccessor DataStoreReconciler::allocateStagedOutboundChange(int32_t byteCount) {
+  // the arena is made of fixed-capacity blocks so that accessors handed out earlier stay valid;
+  // keep entries 8-byte aligned, as they are written in place
+  auto alignedSize = static_cast<size_t>((byteCount + 7) & ~7);
+  if (outboundStagingBlockCount_ == 0 ||
+      outboundStagingBlocks_[outboundStagingBlockCount_ - 1].capacity() -
+              outboundStagingBlocks_[outboundStagingBlockCount_ - 1].size() <
+          alignedSize) {
+    if (outboundStagingBlockCount_ == outboundStagingBlocks_.size()) {
+      outboundStagingBlocks_.emplace_back();
     }
+    auto& newBlock = outboundStagingBlocks_[outboundStagingBlockCount_++];
+    newBlock.clear();
+    newBlock.reserve(std::max(alignedSize, OUTBOUND_STAGING_BLOCK_SIZE));
   }
+
+  auto& block = outboundStagingBlocks_[outboundStagingBlockCount_ - 1];
+  auto offset = static_cast<int32_t>(block.size());
+  block.resize(block.size() + alignedSize);
+
+  MemoryAccessor entryMem{block.data(), offset, byteCount};
+  outboundStagingEntries_.push_back(entryMem);
+  return entryMem;
 }
 
-void DataStoreReconciler::sendFullUpdate() {
-  pendingOutboundFullUpdate_ = true;
+void DataStoreReconciler::flushStagedOutboundChanges(TransportStreamAccessor* accessor) {
+  if (outboundStagingEntries_.empty()) {
+    return;
+  }
 
-  // sort by timestamp so that we can send the full update in creation order
+  size_t writtenCount = 0;
+  for (auto& entryMem : outboundStagingEntries_) {
+    // keep the timestamp taken when the change was staged
+    auto timestamp = ChangeEventAccessor(entryMem).getTimestamp(outboundStagingBaseTimestamp_);
+    accessor->writePrefilledChangeEvent(entryMem, timestamp);
+    if (accessor->isWriteBlocked()) {
+      break;
+    }
+    writtenCount++;
+  }
+
+  if (writtenCount < outboundStagingEntries_.size()) {
+    // the rest were refused; they stay staged, in order, ahead of anything staged later
+    outboundStagingEntries_.erase(
+        outboundStagingEntries_.begin(), outboundStagingEntries_.begin() + writtenCount);
+    return;
+  }
+
+  // the blocks keep their capacity, so steady state does not allocate
+  outboundStagingEntries_.clear();
+  outboundStagingBlockCount_ = 0;
+}
+
+bool DataStoreReconciler::isOutboundSnapshotDue() const {
+  return outboundSnapshotDirty_ &&
+      getCurrentClockTimeMicroseconds() - lastOutboundSnapshotUs_ >= snapshotIntervalUs_;
+}
+
+void DataStoreReconciler::writeOutboundSnapshot(TransportStreamAccessor* accessor) {
+  // all pending writes have just been flushed, so the objects have no outstanding change bits
+  // for the full update prep to clobber
   std::vector<FullUpdateEntry> entries;
+  prepFullUpdate(entries);
+
+  accessor->writeSnapshot([&](TransportStreamAccessor* snapshotAccessor) {
+    snapshotAccessor->writeChangeEvent(CollectionChangeType::FullUpdate);
+    for (auto& entry : entries) {
+      if (auto iter = collections_.find(entry.collectionId_); iter != collections_.end()) {
+        iter->second->writeChanges(snapshotAccessor, entry.objectId_);
+      }
+    }
+  });
+
+  // if the snapshot did not fit then the previous one stays in place, and readers fall back to
+  // requesting a full update once the changelog has moved past it; a stream with other writers
+  // keeps no snapshot at all
+  outboundSnapshotDirty_ = false;
+  lastOutboundSnapshotUs_ = getCurrentClockTimeMicroseconds();
+}
+
+void DataStoreReconciler::prepFullUpdate(std::vector<FullUpdateEntry>& entries) {
+  // sort by timestamp so that we can send the full update in creation order
   for (auto& iter : collections_) {
     iter.second->prepFullUpdate(entries);
   }
   std::sort(
       entries.begin(), entries.end(), [](auto& a, auto& b) { return a.timestamp_ < b.timestamp_; });
+}
+
+void DataStoreReconciler::sendFullUpdate() {
+  pendingOutboundFullUpdate_ = true;
+
+  std::vector<FullUpdateEntry> entries;
+  prepFullUpdate(entries);
 
   pendingWrites_.clear();
   for (auto& entry : entries) {
@@ -171,23 +414,73 @@ void DataStoreReconciler::sendFullUpdate() {
   }
 }
 
+bool DataStoreReconciler::handleMissedInboundEntries(TransportStreamAccessor* accessor) {
+  if (!inboundTransportIterator_->hasMissedEntries(accessor)) {
+    return false;
+  }
+
+  // More changes came in between tick() calls than the changelog can hold.
+  if (inboundTransportIterator_->resyncFromSnapshot(accessor)) {
+    // the iterator replays the writer's snapshot, which starts with a FullUpdate marker
+    return false;
+  }
+
+  // Send message to outbound dataset to reconcile the entire dataset, then make sure to
+  // wait for the FullUpdate message.
+  requestInboundFullUpdate_ = true;
+  waitingForInboundFullUpdate_ = true;
+  return true;
+}
+
 void DataStoreReconciler::reconcileInboundChanges(TransportStreamAccessor* accessor) {
-  if (inboundTransportIterator_->hasMissedEntries(accessor)) {
-    // More changes came in between tick() calls than the changelog can hold.
-    // Send message to outbound dataset to reconcile the entire dataset, then make sure to
-    // wait for the FullUpdate message.
-    requestInboundFullUpdate_ = true;
-    waitingForInboundFullUpdate_ = true;
+  if (handleMissedInboundEntries(accessor)) {
     return;
   }
 
+  dispatchInboundChanges(accessor->getBaseTimestamp(), [&]() {
+    return inboundTransportIterator_->getNextEntry(accessor);
+  });
+}
+
+bool DataStoreReconciler::copyInboundChanges(
+    TransportStreamAccessor* accessor,
+    uint64_t& baseTimestamp) {
+  if (handleMissedInboundEntries(accessor)) {
+    return false;
+  }
+
+  baseTimestamp = accessor->getBaseTimestamp();
+
+  // the scratch buffer keeps its capacity across ticks, so steady state does not allocate
+  inboundScratch_.clear();
+  inboundScratchEntries_.clear();
+
+  while (true) {
+    auto entryMem = inboundTransportIterator_->getNextEntry(accessor);
+    if (entryMem.isNull()) {
+      break;
+    }
+
+    // keep entries 8-byte aligned, as they are read in place
+    auto offset = static_cast<int32_t>((inboundScratch_.size() + 7) & ~static_cast<size_t>(7));
+    auto size = entryMem.getSize();
+    inboundScratch_.resize(offset + size);
+    MemoryAccessor(inboundScratch_.data(), offset, size).copyFrom(entryMem);
+    inboundScratchEntries_.emplace_back(offset, size);
+  }
+
+  return !inboundScratchEntries_.empty();
+}
+
+void DataStoreReconciler::dispatchInboundChanges(
+    uint64_t baseTimestamp,
+    const std::function<MemoryAccessor()>& getNextEntry) {
   uint64_t oldestMessageTimestamp = getCurrentClockTimeMicroseconds() - messageLifetimeUs_;
-  uint64_t baseTimestamp = accessor->getBaseTimestamp();
   bool inFullUpdate = false;
   std::unordered_set<ObjectUuid> reconciledIds;
 
   while (true) {
-    auto entryMem = inboundTransportIterator_->getNextEntry(accessor);
+    auto entryMem = getNextEntry();
     if (entryMem.isNull()) {
       break;
     }
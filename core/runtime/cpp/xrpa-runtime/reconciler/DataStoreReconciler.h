@@ -20,12 +20,14 @@
 #include <xrpa-runtime/transport/TransportStreamAccessor.h>
 #include <xrpa-runtime/utils/PlacedRingBuffer.h>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <vector>
 
 namespace Xrpa {
 
 class IObjectCollection;
+struct FullUpdateEntry;
 
 class DataStoreReconciler {
  public:
@@ -38,19 +40,93 @@ class DataStoreReconciler {
     free(outboundMessages_);
   }
 
+  // Blocks until the inbound transport has unprocessed changes or the timeout elapses, returning
+  // true in the former case. Lets event-driven modules call tickInbound() as soon as data arrives
+  // rather than polling on a fixed tick.
+  template <typename R>
+  bool waitForInboundChanges(std::chrono::duration<int64_t, R> timeout) {
+    return inboundTransportIterator_->waitForChanges(
+        std::chrono::duration_cast<std::chrono::microseconds>(timeout));
+  }
+
   void tickInbound();
   void tickOutbound();
   void shutdown();
 
+  // How tickInbound() and tickOutbound() wait on the transport lock. A tick that times out stays
+  // pending until retryPendingTransactions() or the next tick gets the lock. After
+  // escalateAfterFailures consecutive failures on a transport, escalatedTimeout is used instead,
+  // which bounds how long changes can stall under contention.
+  struct TransactRetryPolicy {
+    std::chrono::milliseconds timeout{1};
+    std::chrono::milliseconds escalatedTimeout{5};
+    int32_t escalateAfterFailures = 3;
+  };
+
+  void setTransactRetryPolicy(const TransactRetryPolicy& policy) {
+    transactRetryPolicy_ = policy;
+  }
+
+  [[nodiscard]] bool hasPendingTransactions() const {
+    return inboundTransactState_.retryPending || outboundTransactState_.retryPending;
+  }
+
+  // retries the transact of any tick that failed to get the transport lock, or that had changes
+  // refused by a lagging lossless reader (TransportConfig::losslessReaderCount); meant to be
+  // called later in the same frame, e.g. before the module sleeps
+  void retryPendingTransactions();
+
   template <typename R>
   void setMessageLifetime(std::chrono::duration<int64_t, R> messageLifetime) {
     messageLifetimeUs_ =
         std::chrono::duration_cast<std::chrono::microseconds>(messageLifetime).count();
   }
 
+  // How often the writer refreshes the outbound transport's snapshot while it has changes, for
+  // transports configured with a snapshot region (see TransportConfig::snapshotByteCount).
+  template <typename R>
+  void setSnapshotInterval(std::chrono::duration<int64_t, R> snapshotInterval) {
+    snapshotIntervalUs_ =
+        std::chrono::duration_cast<std::chrono::microseconds>(snapshotInterval).count();
+  }
+
+  // When enabled, tickInbound() only copies the pending changelog entries into a scratch buffer
+  // while holding the transport lock, then releases the lock before dispatching them to the
+  // collections. Lock hold time is then bounded by the copy rather than by change handlers.
+  void setDeferInboundDispatch(bool deferInboundDispatch) {
+    deferInboundDispatch_ = deferInboundDispatch;
+  }
+
+  // When enabled, tickOutbound() serializes the pending object changes into a local staging
+  // arena before taking the transport lock, and the locked section only copies the staged events
+  // into the changelog. Lock hold time is then bounded by the copy rather than by the number of
+  // dirty fields. Staged changes that miss the lock are kept for the next attempt.
+  void setStageOutboundChanges(bool stageOutboundChanges) {
+    stageOutboundChanges_ = stageOutboundChanges;
+  }
+
+  // When enabled, the generated senders of messages with variable-size payloads, and outbound
+  // signals, send through transactOutboundMessages() on their own, so that the payload is written
+  // once rather than staged and copied. Off by default: each such send then takes the transport
+  // lock on the caller's thread, and writes out any pending object changes ahead of it.
+  void setDirectOutboundMessages(bool directOutboundMessages) {
+    directOutboundMessages_ = directOutboundMessages;
+  }
+
+  [[nodiscard]] bool getDirectOutboundMessages() const {
+    return directOutboundMessages_;
+  }
+
   MemoryAccessor
   sendMessage(const ObjectUuid& objectId, int32_t collectionId, int32_t fieldId, int32_t numBytes);
 
+  // Runs func while holding the outbound transport lock. Messages sent from within func are
+  // serialized directly into the transport changelog, skipping the local staging buffer and the
+  // copy out of it in tickOutbound(). If the lock is unavailable then func still runs, and its
+  // messages are staged as usual; the miss counts toward the transact retry policy like a missed
+  // tickOutbound().
+  void transactOutboundMessages(const std::function<void()>& func);
+
   void notifyObjectNeedsWrite(const ObjectUuid& objectId, int32_t collectionId) {
     auto curSize = pendingWrites_.size();
     if (curSize > 0) {
@@ -80,6 +156,7 @@ class DataStoreReconciler {
   // message stuff
   PlacedRingBuffer* outboundMessages_ = nullptr;
   PlacedRingBufferIterator outboundMessagesIterator_;
+  TransportStreamAccessor* directMessageAccessor_ = nullptr;
   uint64_t messageLifetimeUs_{};
 
   // collections
@@ -90,8 +167,63 @@ class DataStoreReconciler {
   bool waitingForInboundFullUpdate_ = false;
   std::unique_ptr<TransportStreamIterator> inboundTransportIterator_;
 
+  // lock retry state, per transport
+  struct TransactState {
+    int32_t consecutiveFailures = 0;
+    bool retryPending = false;
+  };
+
+  TransactRetryPolicy transactRetryPolicy_;
+  TransactState inboundTransactState_;
+  TransactState outboundTransactState_;
+
+  std::chrono::milliseconds getTransactTimeout(const TransactState& state) const;
+  void recordTransactResult(TransactState& state, bool didLock);
+
+  // outbound staging
+  static constexpr size_t OUTBOUND_STAGING_BLOCK_SIZE = 64 * 1024;
+
+  bool stageOutboundChanges_ = false;
+  bool directOutboundMessages_ = false;
+  uint64_t outboundStagingBaseTimestamp_ = 0;
+  std::vector<std::vector<uint8_t>> outboundStagingBlocks_;
+  size_t outboundStagingBlockCount_ = 0;
+  std::vector<MemoryAccessor> outboundStagingEntries_;
+
+  // outbound snapshot
+  bool outboundSupportsSnapshot_ = false;
+  bool outboundSnapshotDirty_ = false;
+  uint64_t lastOutboundSnapshotUs_ = 0;
+  uint64_t snapshotIntervalUs_{};
+
+  // deferred inbound dispatch
+  struct ScratchEntry {
+    ScratchEntry(int32_t offset, int32_t size) : offset_(offset), size_(size) {}
+
+    int32_t offset_;
+    int32_t size_;
+  };
+
+  bool deferInboundDispatch_ = false;
+  std::vector<uint8_t> inboundScratch_;
+  std::vector<ScratchEntry> inboundScratchEntries_;
+
+  bool handleMissedInboundEntries(TransportStreamAccessor* accessor);
   void reconcileInboundChanges(TransportStreamAccessor* accessor);
+  bool copyInboundChanges(TransportStreamAccessor* accessor, uint64_t& baseTimestamp);
+  void dispatchInboundChanges(
+      uint64_t baseTimestamp,
+      const std::function<MemoryAccessor()>& getNextEntry);
   void reconcileOutboundChanges(TransportStreamAccessor* accessor);
+  void writeOutboundObjectChanges(TransportStreamAccessor* accessor);
+  void stageOutboundChanges();
+  MemoryAccessor allocateStagedOutboundChange(int32_t byteCount);
+  void flushStagedOutboundChanges(TransportStreamAccessor* accessor);
+  void transactInbound(TransportStream* inboundTransport);
+  void transactOutbound(TransportStream* outboundTransport);
+  bool isOutboundSnapshotDue() const;
+  void writeOutboundSnapshot(TransportStreamAccessor* accessor);
+  void prepFullUpdate(std::vector<FullUpdateEntry>& entries);
   void sendFullUpdate();
 };
 
@@ -56,9 +56,11 @@ class InboundSignalForwarder : public InboundSignalDataInterface {
     }
 
     for (auto* recipient : recipients_) {
-      auto outboundPacket =
-          recipient->sendSignalPacket(sampleSize, frameCount, sampleType, numChannels, frameRate);
-      outboundPacket.copyChannelDataFrom(inboundPacket);
+      recipient->sendSignalPackets([&]() {
+        auto outboundPacket =
+            recipient->sendSignalPacket(sampleSize, frameCount, sampleType, numChannels, frameRate);
+        outboundPacket.copyChannelDataFrom(inboundPacket);
+      });
     }
   }
 
@@ -18,6 +18,7 @@
 
 #include <xrpa-runtime/reconciler/DataStoreInterfaces.h>
 #include <xrpa-runtime/signals/SignalShared.h>
+#include <xrpa-runtime/utils/TimeUtils.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
 #include <chrono>
 #include <functional>
@@ -74,16 +75,35 @@ class OutboundSignalData {
   }
 
   void tick() {
-    auto endTime = std::chrono::high_resolution_clock::now();
-    for (auto frameCount = getNextFrameCount(endTime); frameCount > 0;
-         frameCount = getNextFrameCount(endTime)) {
-      if (signalSource_ && collection_) {
-        auto packet =
-            sendSignalPacket(sampleSize_, frameCount, sampleType_, numChannels_, framesPerSecond_);
-        signalSource_(packet);
+    auto endTime = getCurrentSteadyTime();
+    auto sendPackets = [&]() {
+      for (auto frameCount = getNextFrameCount(endTime); frameCount > 0;
+           frameCount = getNextFrameCount(endTime)) {
+        if (signalSource_ && collection_) {
+          auto packet = sendSignalPacket(
+              sampleSize_, frameCount, sampleType_, numChannels_, framesPerSecond_);
+          signalSource_(packet);
+        }
+
+        curReadPos_ += frameCount;
       }
+    };
+
+    if (signalSource_ && framesPerSecond_ && endTime >= prevFrameStartTime_) {
+      // packets are due, and the source fills each in place, so they can share one transaction
+      sendSignalPackets(sendPackets);
+    } else {
+      sendPackets();
+    }
+  }
 
-      curReadPos_ += frameCount;
+  // runs func, which sends packets with sendSignalPacket() and fills them in before returning; see
+  // IObjectCollection::sendDirectMessages()
+  void sendSignalPackets(const std::function<void()>& func) {
+    if (collection_) {
+      collection_->sendDirectMessages(func);
+    } else {
+      func();
     }
   }
 
@@ -117,7 +137,7 @@ class OutboundSignalData {
 
   // internal state management
   uint64_t curReadPos_ = 0;
-  std::chrono::high_resolution_clock::time_point prevFrameStartTime_;
+  std::chrono::steady_clock::time_point prevFrameStartTime_;
 
   template <typename T>
   void
@@ -128,10 +148,10 @@ class OutboundSignalData {
     framesPerSecond_ = framesPerSecond;
     framesPerPacket_ = framesPerPacket;
 
-    prevFrameStartTime_ = std::chrono::high_resolution_clock::now();
+    prevFrameStartTime_ = getCurrentSteadyTime();
   }
 
-  int getNextFrameCount(std::chrono::high_resolution_clock::time_point endTime) {
+  int getNextFrameCount(std::chrono::steady_clock::time_point endTime) {
     if (!framesPerSecond_) {
       return 0;
     }
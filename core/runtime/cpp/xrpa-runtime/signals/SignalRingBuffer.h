@@ -16,12 +16,21 @@
 
 #pragma once
 
+#include <xrpa-runtime/utils/AtomicUtils.h>
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
-#include <mutex>
 #include <vector>
 
 namespace Xrpa {
 
+// Wait-free single-producer/single-consumer ring buffer of interleaved samples. One thread may
+// call writeInterleavedData() (typically an audio callback) while another thread calls the read
+// functions; neither ever blocks. initialize() must not run concurrently with either side.
+//
+// The read and write positions are sample counts in [0, 2 * ringBufferSize), so that a full ring
+// buffer is distinguishable from an empty one. Each side owns its position and publishes it with
+// a release store, after the sample data it covers has been copied.
 template <typename SampleType>
 class SignalRingBuffer {
  public:
@@ -29,8 +38,9 @@ class SignalRingBuffer {
     ringBuffer_.resize(frameCount * numChannels);
     warmupFrameCount_ = warmupFrameCount;
     numChannels_ = numChannels;
-    ringBufferReadPos_ = 0;
-    ringBufferWritePos_ = 0;
+    isWarmingUp_ = true;
+    atomicStoreRelease(&ringBufferReadPos_, 0);
+    atomicStoreRelease(&ringBufferWritePos_, 0);
   }
 
   [[nodiscard]] int getReadFramesAvailable() const {
@@ -41,10 +51,8 @@ class SignalRingBuffer {
     return getRingBufferAvailableForWrite() / numChannels_;
   }
 
-  // returns false if it underflowed the ring buffer
+  // consumer side; returns false if it underflowed the ring buffer
   bool readInterleavedData(SampleType* outputBuffer, int framesNeeded) {
-    std::unique_lock lock(mutex_);
-
     const int ringBufferSize = ringBuffer_.size();
     int readFramesAvailable = getReadFramesAvailable();
     bool didUnderflow = false;
@@ -66,25 +74,29 @@ class SignalRingBuffer {
     const int ringSamples = numChannels_ * framesFromRingBuffer;
     const int totalSamples = numChannels_ * framesNeeded;
 
-    const int endRingPos = ringBufferReadPos_ + ringSamples;
+    // only the consumer writes the read position, so a relaxed read of it is sufficient
+    const uint32_t readPos = ringBufferReadPos_;
+    const int ringReadPos = toRingIndex(readPos);
+    const int endRingPos = ringReadPos + ringSamples;
 
     if (endRingPos > ringBufferSize) {
       // the range straddles the end of the ring buffer, so we need to copy in two batches
       std::memcpy(
           outputBuffer,
-          &ringBuffer_[ringBufferReadPos_],
-          (ringBufferSize - ringBufferReadPos_) * sizeof(SampleType));
+          &ringBuffer_[ringReadPos],
+          (ringBufferSize - ringReadPos) * sizeof(SampleType));
       std::memcpy(
-          outputBuffer + (ringBufferSize - ringBufferReadPos_),
+          outputBuffer + (ringBufferSize - ringReadPos),
           &ringBuffer_[0],
           (endRingPos - ringBufferSize) * sizeof(SampleType));
-      ringBufferReadPos_ = (endRingPos - ringBufferSize) % ringBufferSize;
-    } else {
+    } else if (ringSamples > 0) {
       // the range is entirely within the ring buffer, so we can copy it in one go
-      std::memcpy(outputBuffer, &ringBuffer_[ringBufferReadPos_], ringSamples * sizeof(SampleType));
-      ringBufferReadPos_ = endRingPos % ringBufferSize;
+      std::memcpy(outputBuffer, &ringBuffer_[ringReadPos], ringSamples * sizeof(SampleType));
     }
 
+    // release the consumed samples back to the producer, only after they have been copied out
+    atomicStoreRelease(&ringBufferReadPos_, advancePos(readPos, ringSamples));
+
     if (ringSamples < totalSamples) {
       // fill in the remaining samples with 0s
       std::memset(outputBuffer + ringSamples, 0, (totalSamples - ringSamples) * sizeof(SampleType));
@@ -93,6 +105,7 @@ class SignalRingBuffer {
     return !didUnderflow;
   }
 
+  // consumer side
   bool readDeinterleavedData(SampleType* outputBuffer, int framesNeeded, int outputStride) {
     tempBuffer_.resize(framesNeeded * numChannels_);
     auto filled = readInterleavedData(tempBuffer_.data(), framesNeeded);
@@ -108,62 +121,74 @@ class SignalRingBuffer {
     return filled;
   }
 
-  // returns the number of frames actually written to the ring buffer (<= framesToWrite)
+  // producer side; returns the number of frames actually written to the ring buffer
+  // (<= framesToWrite)
   int writeInterleavedData(const SampleType* inputBuffer, int framesToWrite) {
-    std::unique_lock lock(mutex_);
-
     const int ringBufferSize = ringBuffer_.size();
     const int writeFramesAvailable = getWriteFramesAvailable();
 
     const int framesToRingBuffer = std::min(framesToWrite, writeFramesAvailable);
     const int ringSamples = numChannels_ * framesToRingBuffer;
 
-    const int endRingPos = ringBufferWritePos_ + ringSamples;
+    // only the producer writes the write position, so a relaxed read of it is sufficient
+    const uint32_t writePos = ringBufferWritePos_;
+    const int ringWritePos = toRingIndex(writePos);
+    const int endRingPos = ringWritePos + ringSamples;
 
     if (endRingPos > ringBufferSize) {
       // the range straddles the end of the ring buffer, so we need to copy in two batches
-      const int firstBatchSamples = ringBufferSize - ringBufferWritePos_;
+      const int firstBatchSamples = ringBufferSize - ringWritePos;
       const int secondBatchSamples = endRingPos - ringBufferSize;
-      std::memcpy(
-          &ringBuffer_[ringBufferWritePos_], inputBuffer, firstBatchSamples * sizeof(SampleType));
+      std::memcpy(&ringBuffer_[ringWritePos], inputBuffer, firstBatchSamples * sizeof(SampleType));
       std::memcpy(
           &ringBuffer_[0],
           inputBuffer + firstBatchSamples,
           secondBatchSamples * sizeof(SampleType));
-      ringBufferWritePos_ = secondBatchSamples;
-    } else {
+    } else if (ringSamples > 0) {
       // the range is entirely within the ring buffer, so we can copy it in one go
-      std::memcpy(&ringBuffer_[ringBufferWritePos_], inputBuffer, ringSamples * sizeof(SampleType));
-      ringBufferWritePos_ = endRingPos % ringBufferSize;
+      std::memcpy(&ringBuffer_[ringWritePos], inputBuffer, ringSamples * sizeof(SampleType));
     }
 
+    // publish the new samples to the consumer, only after they have been copied in
+    atomicStoreRelease(&ringBufferWritePos_, advancePos(writePos, ringSamples));
+
     return framesToRingBuffer;
   }
 
  private:
-  std::mutex mutex_;
   std::vector<SampleType> ringBuffer_;
   std::vector<SampleType> tempBuffer_;
-  int ringBufferReadPos_ = 0;
-  int ringBufferWritePos_ = 0;
+  volatile uint32_t ringBufferReadPos_ = 0;
+  volatile uint32_t ringBufferWritePos_ = 0;
   int numChannels_ = 1;
   int warmupFrameCount_ = 0;
   bool isWarmingUp_ = true;
 
+  [[nodiscard]] int toRingIndex(uint32_t pos) const {
+    const auto ringBufferSize = static_cast<uint32_t>(ringBuffer_.size());
+    return static_cast<int>(pos >= ringBufferSize ? pos - ringBufferSize : pos);
+  }
+
+  [[nodiscard]] uint32_t advancePos(uint32_t pos, int sampleCount) const {
+    const auto wrapSize = static_cast<uint32_t>(ringBuffer_.size() * 2);
+    pos += sampleCount;
+    return pos >= wrapSize ? pos - wrapSize : pos;
+  }
+
+  [[nodiscard]] int getRingBufferUsed() const {
+    const auto readPos = atomicLoadAcquire(&ringBufferReadPos_);
+    const auto writePos = atomicLoadAcquire(&ringBufferWritePos_);
+    const auto wrapSize = static_cast<uint32_t>(ringBuffer_.size() * 2);
+    return static_cast<int>(
+        writePos >= readPos ? writePos - readPos : writePos + wrapSize - readPos);
+  }
+
   [[nodiscard]] int getRingBufferAvailableForRead() const {
-    if (ringBufferWritePos_ >= ringBufferReadPos_) {
-      return ringBufferWritePos_ - ringBufferReadPos_;
-    } else {
-      return ringBufferWritePos_ + ringBuffer_.size() - ringBufferReadPos_;
-    }
+    return getRingBufferUsed();
   }
 
   [[nodiscard]] int getRingBufferAvailableForWrite() const {
-    if (ringBufferWritePos_ >= ringBufferReadPos_) {
-      return ringBuffer_.size() - (ringBufferWritePos_ - ringBufferReadPos_);
-    } else {
-      return ringBufferReadPos_ - ringBufferWritePos_;
-    }
+    return static_cast<int>(ringBuffer_.size()) - getRingBufferUsed();
   }
 };
 
@@ -17,6 +17,9 @@
 #pragma once
 
 #include <xrpa-runtime/transport/MemoryTransportStream.h>
+#include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
+#include <xrpa-runtime/utils/MirroredMapping.h>
+#include <cstring>
 
 namespace Xrpa {
 
@@ -25,10 +28,29 @@ class HeapMemoryTransportStream : public MemoryTransportStream {
   HeapMemoryTransportStream(const std::string& name, const TransportConfig& config)
       : MemoryTransportStream(name, config) {
     memoryIsOwned_ = true;
-    memBuffer_ = static_cast<unsigned char*>(malloc(memSize_));
+    if (MemoryTransportStreamAccessor::hasMirroredChangelog(config)) {
+      // falls back to plain memory, where the mirror is just extra space, if it cannot be mapped
+      auto mirrorByteCount = MemoryTransportStreamAccessor::getChangelogCapacity(config);
+      memBuffer_ = mapMemoryWithMirror(
+          memSize_ - mirrorByteCount,
+          MemoryTransportStreamAccessor::getChangelogPoolOffset(config),
+          mirrorByteCount,
+          false);
+      isMirrorMapped_ = memBuffer_ != nullptr;
+    }
+    if (memBuffer_ == nullptr) {
+      memBuffer_ = static_cast<unsigned char*>(malloc(memSize_));
+    }
+    uint32_t alreadyApplied = 0;
+    if (memBuffer_ != nullptr && (config.mappingFlags & MappingPrefault) != 0) {
+      // fresh heap pages are only backed once written, so touching them is not enough
+      std::memset(memBuffer_, 0, memSize_);
+      alreadyApplied |= MappingPrefault;
+    }
+    applyMappingFlags(memBuffer_, memSize_, alreadyApplied);
     if (!initializeMemory(true)) {
-      free(memBuffer_);
-      memBuffer_ = nullptr;
+      releaseMappingFlags(memBuffer_, memSize_);
+      freeMemory();
     }
   }
 
@@ -36,14 +58,18 @@ class HeapMemoryTransportStream : public MemoryTransportStream {
       : MemoryTransportStream(name, config) {
     memoryIsOwned_ = false;
     memBuffer_ = static_cast<unsigned char*>(memBuffer);
+    applyMappingFlags(memBuffer_, memSize_);
     if (!initializeMemory(false)) {
+      releaseMappingFlags(memBuffer_, memSize_);
       memBuffer_ = nullptr;
     }
   }
 
   ~HeapMemoryTransportStream() override {
+    releaseLockFreeWriter();
+    releaseMappingFlags(memBuffer_, memSize_);
     if (memoryIsOwned_) {
-      free(memBuffer_);
+      freeMemory();
     }
   }
 
@@ -52,7 +78,18 @@ class HeapMemoryTransportStream : public MemoryTransportStream {
   }
 
  private:
+  void freeMemory() {
+    if (isMirrorMapped_) {
+      unmapWithMirror(memBuffer_, memSize_);
+    } else {
+      free(memBuffer_);
+    }
+    memBuffer_ = nullptr;
+  }
+
   bool memoryIsOwned_;
+  // set when the memory of a TransportConfig::mirroredChangelog stream is actually mirrored
+  bool isMirrorMapped_ = false;
 };
 
 } // namespace Xrpa
@@ -15,6 +15,7 @@
  */
 
 #include <xrpa-runtime/transport/InterprocessMutex.h>
+#include <xrpa-runtime/utils/AtomicUtils.h>
 #include <chrono>
 #include <filesystem>
 #include <iostream>
@@ -28,14 +29,31 @@
 #include <Windows.h>
 #endif
 
-#ifdef __APPLE__
+#if defined(__APPLE__) || defined(__linux__)
 #include <fcntl.h>
 #include <sys/file.h>
 #include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <ctime>
 #endif
 
 namespace Xrpa {
 
+std::unique_ptr<InterprocessMutex> createNamedInterprocessMutex(const std::string& name) {
+#ifdef WIN32
+  return std::make_unique<WindowsInterprocessMutex>(name);
+#elif defined(__APPLE__) || defined(__linux__)
+  return std::make_unique<MacInterprocessMutex>(name);
+#else
+#error "Unsupported platform"
+#endif
+}
+
 #ifdef WIN32
 
 int filterException(int code, PEXCEPTION_POINTERS ex) {
@@ -109,7 +127,7 @@ void WindowsInterprocessMutex::dispose() {
   }
 }
 
-#elif defined(__APPLE__)
+#elif defined(__APPLE__) || defined(__linux__)
 
 MacInterprocessMutex::MacInterprocessMutex(const std::string& name) : fileDescriptor_(-1) {
   const std::string tempPath = "/tmp/xrpa";
@@ -225,4 +243,193 @@ void MacInterprocessMutex::dispose() {
 }
 #endif
 
+#ifdef __linux__
+
+// number of trylock attempts before falling back to sleeping in the kernel; an uncontended
+// transact holds the lock for a few microseconds, so this covers the common contended case
+static constexpr int kMutexSpinCount = 200;
+
+static constexpr uint32_t kSlotUninitialized = 0;
+static constexpr uint32_t kSlotInitializing = 1;
+static constexpr uint32_t kSlotReady = 2;
+static constexpr uint32_t kSlotStateMask = 3;
+// added to a kSlotInitializing state each time it is reclaimed
+static constexpr uint32_t kSlotGenerationStep = 4;
+
+// initializing the mutex takes microseconds, so a slot left initializing this long belongs to a
+// process that died part way through
+static constexpr auto kSlotInitStaleTime = std::chrono::milliseconds(100);
+
+struct RobustMutexSlot {
+  // kSlotUninitialized in zero-filled memory; the process that moves it to kSlotInitializing
+  // initializes the mutex and then publishes kSlotReady. The bits above kSlotStateMask count
+  // reclaims of a stale kSlotInitializing, so that an initializer that was reclaimed from cannot
+  // publish kSlotReady.
+  volatile uint32_t initState;
+  uint32_t reserved;
+  pthread_mutex_t mutex;
+};
+
+static_assert(sizeof(RobustMutexSlot) <= ROBUST_MUTEX_SLOT_SIZE);
+
+// initializes the mutex, having claimed the slot by moving it to initState
+static bool initializeClaimedSlot(RobustMutexSlot* slot, uint32_t initState) {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+  int result = pthread_mutex_init(&slot->mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+  uint32_t expected = initState;
+  if (result != 0) {
+    atomicCompareExchange(&slot->initState, &expected, kSlotUninitialized);
+    return false;
+  }
+  return atomicCompareExchange(&slot->initState, &expected, kSlotReady);
+}
+
+bool RobustInterprocessMutex::initializeSlot(std::chrono::steady_clock::time_point endTime) {
+  auto* slot = static_cast<RobustMutexSlot*>(lockSlot_);
+  while (true) {
+    uint32_t state = atomicLoadAcquire(&slot->initState);
+    if (state == kSlotReady) {
+      return true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (state == kSlotUninitialized) {
+      if (atomicCompareExchange(&slot->initState, &state, kSlotInitializing) &&
+          initializeClaimedSlot(slot, kSlotInitializing)) {
+        return true;
+      }
+    } else if ((state & kSlotStateMask) == kSlotInitializing) {
+      // the stale timer carries across lock() calls, as their timeouts are shorter than it
+      if (state != observedInitState_) {
+        observedInitState_ = state;
+        observedInitTime_ = now;
+      } else if (now - observedInitTime_ >= kSlotInitStaleTime) {
+        std::cerr << "RobustInterprocessMutex(" << name_
+                  << "): reclaiming a mutex left part way through initialization\n"
+                  << std::flush;
+        uint32_t reclaimedState = state + kSlotGenerationStep;
+        if (atomicCompareExchange(&slot->initState, &state, reclaimedState) &&
+            initializeClaimedSlot(slot, reclaimedState)) {
+          return true;
+        }
+      }
+    }
+
+    if (now >= endTime) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+}
+
+RobustInterprocessMutex::RobustInterprocessMutex(const std::string& name, void* lockSlot)
+    : name_(name), lockSlot_(lockSlot) {}
+
+RobustInterprocessMutex::~RobustInterprocessMutex() {
+  dispose();
+}
+
+bool RobustInterprocessMutex::onLocked(int result) {
+  auto* slot = static_cast<RobustMutexSlot*>(lockSlot_);
+  if (result == 0) {
+    didOwnerDie_ = false;
+    return true;
+  }
+
+  if (result == EOWNERDEAD) {
+    // the kernel released the lock for an owner that died holding it; the caller is told so it can
+    // repair the guarded memory, and the mutex is marked usable again
+    std::cerr << "RobustInterprocessMutex(" << name_ << "): previous owner died holding the lock\n"
+              << std::flush;
+    pthread_mutex_consistent(&slot->mutex);
+    didOwnerDie_ = true;
+    return true;
+  }
+
+  if (result == ENOTRECOVERABLE) {
+    std::cerr << "RobustInterprocessMutex(" << name_ << "): lock is not recoverable\n"
+              << std::flush;
+  }
+  return false;
+}
+
+bool RobustInterprocessMutex::lock(int timeoutMS) {
+  auto* slot = static_cast<RobustMutexSlot*>(lockSlot_);
+  if (slot == nullptr) {
+    return false;
+  }
+
+  auto endTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMS);
+  if (atomicLoadAcquire(&slot->initState) != kSlotReady && !initializeSlot(endTime)) {
+    return false;
+  }
+
+  // adaptive spin: the lock is usually released within microseconds
+  for (int i = 0; i < kMutexSpinCount; ++i) {
+    int result = pthread_mutex_trylock(&slot->mutex);
+    if (result != EBUSY) {
+      return onLocked(result);
+    }
+    cpuRelax();
+  }
+
+  // pthread_mutex_timedlock only takes a CLOCK_REALTIME deadline
+  auto remaining = endTime - std::chrono::steady_clock::now();
+  if (remaining <= std::chrono::nanoseconds::zero()) {
+    return false;
+  }
+  struct timespec ts{};
+  clock_gettime(CLOCK_REALTIME, &ts);
+  int64_t deadlineNs = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec +
+      std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+  ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000);
+  ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000);
+
+  int result = pthread_mutex_timedlock(&slot->mutex, &ts);
+  return result != ETIMEDOUT && onLocked(result);
+}
+
+bool RobustInterprocessMutex::lockAndExecute(int timeoutMS, std::function<void()> lockCallback) {
+  if (isLocked_) {
+    // Already locked by this instance
+    lockCallback();
+    return true;
+  }
+
+  if (!lock(timeoutMS)) {
+    return false;
+  }
+  isLocked_ = true;
+
+  try {
+    lockCallback();
+    unlock();
+    return true;
+  } catch (...) {
+    unlock();
+    throw;
+  }
+}
+
+void RobustInterprocessMutex::unlock() {
+  if (!isLocked_) {
+    return;
+  }
+  isLocked_ = false;
+  didOwnerDie_ = false;
+
+  pthread_mutex_unlock(&static_cast<RobustMutexSlot*>(lockSlot_)->mutex);
+}
+
+void RobustInterprocessMutex::dispose() {
+  unlock();
+  lockSlot_ = nullptr;
+}
+
+#endif // __linux__
+
 } // namespace Xrpa
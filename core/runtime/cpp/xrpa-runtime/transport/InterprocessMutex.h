@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace Xrpa {
@@ -35,8 +38,21 @@ class InterprocessMutex {
 
   // Execute a callback while holding the mutex lock, with appropriate exception handling
   virtual bool lockAndExecute(int timeoutMS, std::function<void()> lockCallback) = 0;
+
+  // true inside a lockAndExecute callback if the previous owner died while holding the lock, so
+  // that the callback must assume the guarded memory was left half-written
+  [[nodiscard]] bool didOwnerDie() const {
+    return didOwnerDie_;
+  }
+
+ protected:
+  bool didOwnerDie_ = false;
 };
 
+// bytes of shared memory reserved for a RobustInterprocessMutex; a full cache line, so that lock
+// traffic does not contend with the memory it guards
+static constexpr int32_t ROBUST_MUTEX_SLOT_SIZE = 64;
+
 #ifdef WIN32
 
 class WindowsInterprocessMutex : public InterprocessMutex {
@@ -57,8 +73,9 @@ class WindowsInterprocessMutex : public InterprocessMutex {
 };
 #endif // _WIN32
 
-#ifdef __APPLE__
+#if defined(__APPLE__) || defined(__linux__)
 
+// flock()-based lock file in /tmp/xrpa; also used on Linux
 class MacInterprocessMutex : public InterprocessMutex {
  public:
   explicit MacInterprocessMutex(const std::string& name);
@@ -76,6 +93,42 @@ class MacInterprocessMutex : public InterprocessMutex {
   std::string lockFilePath_;
   int fileDescriptor_ = -1; // Only != -1 while locked
 };
-#endif // __APPLE__
+#endif // __APPLE__ || __linux__
+
+#ifdef __linux__
+
+// Process-shared, robust pthread mutex that lives inside a shared memory mapping, in a slot of
+// ROBUST_MUTEX_SLOT_SIZE bytes. The kernel releases it when its owner dies, in any PID namespace,
+// and the next locker is told via didOwnerDie(). A zero-filled slot is a valid unlocked state;
+// the first process to lock it initializes the mutex in place, and a slot left part way through
+// initialization by a process that died is reclaimed by the next locker.
+class RobustInterprocessMutex : public InterprocessMutex {
+ public:
+  RobustInterprocessMutex(const std::string& name, void* lockSlot);
+  ~RobustInterprocessMutex() override;
+
+  void unlock() override;
+  void dispose() override;
+
+  // Execute a callback while holding the mutex lock, with standard exception handling
+  bool lockAndExecute(int timeoutMS, std::function<void()> lockCallback) override;
+
+ private:
+  bool lock(int timeoutMS);
+  bool onLocked(int result);
+  bool initializeSlot(std::chrono::steady_clock::time_point endTime);
+
+  std::string name_;
+  void* lockSlot_ = nullptr;
+  bool isLocked_ = false;
+
+  // the last kSlotInitializing state seen in the slot, and when it was first seen
+  uint32_t observedInitState_ = 0;
+  std::chrono::steady_clock::time_point observedInitTime_;
+};
+#endif // __linux__
+
+// the platform's named mutex: a kernel mutex object on Windows, a lock file elsewhere
+std::unique_ptr<InterprocessMutex> createNamedInterprocessMutex(const std::string& name);
 
 } // namespace Xrpa
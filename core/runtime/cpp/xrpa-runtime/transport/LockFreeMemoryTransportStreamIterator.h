@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/transport/MemoryTransportStream.h>
+#include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
+#include <xrpa-runtime/transport/TransportStreamAccessor.h>
+#include <xrpa-runtime/utils/AtomicUtils.h>
+#include <xrpa-runtime/utils/MemoryAccessor.h>
+#include <xrpa-runtime/utils/SpmcRingBuffer.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Xrpa {
+
+// Reader for TransportConfig::lockFree streams. Entries are read without holding any lock, so each
+// one is copied out of the changelog and validated before it is handed to the caller; an entry that
+// the writer overwrote mid-copy is reported through hasMissedEntries().
+class LockFreeMemoryTransportStreamIterator : public TransportStreamIterator {
+ public:
+  class LockFreeMemoryTransportStreamIteratorData : public TransportStreamIteratorData {
+   public:
+    static constexpr int32_t TYPE_ID = 82002;
+    explicit LockFreeMemoryTransportStreamIteratorData(SpmcRingBuffer* changelog)
+        : TransportStreamIteratorData(TYPE_ID), changelog_(changelog) {}
+
+    SpmcRingBuffer* changelog_ = nullptr;
+  };
+
+  explicit LockFreeMemoryTransportStreamIterator(MemoryTransportStream* transportStream)
+      : transportStream_(transportStream) {}
+
+  ~LockFreeMemoryTransportStreamIterator() override = default;
+
+  bool needsProcessing() override {
+    if (transportStream_->memBuffer_ == nullptr) {
+      return false;
+    }
+
+    MemoryTransportStreamAccessor streamAccessor{transportStream_->accessMemory()};
+    auto changelog = streamAccessor.getLockFreeChangelog();
+    return iter_.hasNext(&changelog);
+  }
+
+  bool waitForChanges(std::chrono::microseconds timeout) override {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (transportStream_->memBuffer_ != nullptr) {
+      // sample the notify counter before checking, so a commit in between is not slept through
+      MemoryTransportStreamAccessor streamAccessor{transportStream_->accessMemory()};
+      auto notifyValue = atomicLoadAcquire(streamAccessor.getChangeNotifyWord());
+      if (needsProcessing()) {
+        return true;
+      }
+      if (!transportStream_->waitForChangeNotify(notifyValue, deadline)) {
+        break;
+      }
+    }
+    return false;
+  }
+
+  bool hasMissedEntries(TransportStreamAccessor* accessor) override {
+    auto* iterData = accessor->getIteratorData<LockFreeMemoryTransportStreamIteratorData>();
+    if (iterData == nullptr) {
+      return false;
+    }
+    auto* changelog = iterData->changelog_;
+    if (didMissEntries_ || iter_.hasMissedEntries(changelog)) {
+      didMissEntries_ = false;
+      iter_.setToEnd(changelog);
+      iterData->missedEntries_++;
+      return true;
+    }
+    return false;
+  }
+
+  MemoryAccessor getNextEntry(TransportStreamAccessor* accessor) override {
+    auto* iterData = accessor->getIteratorData<LockFreeMemoryTransportStreamIteratorData>();
+    if (iterData == nullptr || didMissEntries_) {
+      return {};
+    }
+    auto* changelog = iterData->changelog_;
+
+    if (iter_.hasMissedEntries(changelog)) {
+      didMissEntries_ = true;
+      return {};
+    }
+    if (!iter_.hasNext(changelog)) {
+      return {};
+    }
+
+    int32_t entrySize = 0;
+    bool isValid = iter_.readNext(changelog, [&](MemoryAccessor entryMem) {
+      entrySize = entryMem.getSize();
+      if (static_cast<int32_t>(entryData_.size()) < entrySize) {
+        entryData_.resize(entrySize);
+      }
+      MemoryAccessor(entryData_.data(), 0, entrySize).copyFrom(entryMem);
+    });
+
+    if (!isValid) {
+      // the writer overwrote the entry while it was being copied
+      didMissEntries_ = true;
+      return {};
+    }
+
+    MemoryAccessor entry{entryData_.data(), 0, entrySize};
+    iterData->eventsRead_++;
+    iterData->bytesRead_ += entrySize;
+    iterData->recordEventLatency(entry, accessor->getBaseTimestamp());
+    return entry;
+  }
+
+ private:
+  MemoryTransportStream* transportStream_;
+  SpmcRingBufferIterator iter_;
+  std::vector<uint8_t> entryData_;
+  bool didMissEntries_ = false;
+};
+
+} // namespace Xrpa
@@ -16,10 +16,37 @@
 
 #include <xrpa-runtime/transport/MemoryTransportStream.h>
 
+#include <xrpa-runtime/transport/LockFreeMemoryTransportStreamIterator.h>
 #include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
 #include <xrpa-runtime/transport/MemoryTransportStreamIterator.h>
+#include <xrpa-runtime/utils/AtomicUtils.h>
 #include <xrpa-runtime/utils/TimeUtils.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <optional>
+#include <random>
+
+#if defined(WIN32)
+#include <Windows.h>
+#ifdef TEXT
+#undef TEXT // undefine UE4 macro, if defined
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#elif defined(__APPLE__) || defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#endif
 
 namespace Xrpa {
 
@@ -32,67 +59,710 @@ static constexpr auto TRANSPORT_HEARTBEAT_INTERVAL =
 static constexpr auto TRANSPORT_EXPIRE_TIME =
     std::chrono::duration_cast<std::chrono::microseconds>(20s);
 
+// a lossless reader that has not ticked for this long no longer holds the writer back
+static constexpr int32_t READER_CURSOR_EXPIRE_MS =
+    std::chrono::duration_cast<std::chrono::milliseconds>(TRANSPORT_EXPIRE_TIME).count();
+static constexpr auto READER_CURSOR_RELEASE_TIMEOUT = 100ms;
+
+// how often waitForChanges() re-checks the header on platforms without a cross-process futex
+static constexpr auto CHANGE_POLL_INTERVAL = 500us;
+
 MemoryTransportStream::MemoryTransportStream(const std::string& name, const TransportConfig& config)
-    : name_(name), config_(config), memSize_(MemoryTransportStreamAccessor::getMemSize(config)) {
-#ifdef WIN32
-  mutex_ = std::make_unique<WindowsInterprocessMutex>(name);
-#elif defined(__APPLE__)
-  mutex_ = std::make_unique<MacInterprocessMutex>(name);
-#else
-#error "Unsupported platform"
-#endif
+    : MemoryTransportStream(name, config, createNamedInterprocessMutex(name)) {}
+
+MemoryTransportStream::MemoryTransportStream(
+    const std::string& name,
+    const TransportConfig& config,
+    std::unique_ptr<InterprocessMutex> mutex)
+    : name_(name),
+      config_(config),
+      memSize_(MemoryTransportStreamAccessor::getMemSize(config)),
+      mutex_(std::move(mutex)) {
+  if (!config_.lockDomain.empty() && !config_.lockFree) {
+    lockDomain_ = TransportLockDomain::get(config_.lockDomain);
+    // owners that died before this stream joined have been recovered from by the streams that
+    // were members then; read without the lock, which at worst costs an extra recovery
+    seenDomainOwnerDeathCount_ = lockDomain_->getOwnerDeathCount();
+  }
+  if (config_.maxChangelogByteCount != 0 &&
+      !MemoryTransportStreamAccessor::hasGrowableChangelog(config_)) {
+    std::cerr << "MemoryTransportStream(" << name_ << "): maxChangelogByteCount "
+              << config_.maxChangelogByteCount << " ignored, the changelog cannot grow past "
+              << config_.changelogByteCount << " bytes\n"
+              << std::flush;
+  }
 }
 
 bool MemoryTransportStream::transact(
     std::chrono::milliseconds timeout,
     std::function<void(TransportStreamAccessor*)> func) {
-  if (memBuffer_ == nullptr || mutex_ == nullptr) {
+  if (memBuffer_ == nullptr || (mutex_ == nullptr && lockDomain_ == nullptr)) {
     return false;
   }
 
-  return mutex_->lockAndExecute(timeout.count(), [&]() {
+  if (config_.lockFree) {
+    return transactLockFree(func);
+  }
+
+  TransportStreamMetrics transactMetrics;
+  transactMetrics.transactCount = 1;
+
+  bool didWrite = false;
+  auto lockStartTime = std::chrono::steady_clock::now();
+  auto transactBody = [&]() {
+    // sampled once the lock is held, so that timestamps follow changelog order across writers
+    ClockTickScope clockTick;
+    auto holdStartTime = std::chrono::steady_clock::now();
+    transactMetrics.lockWait.record(holdStartTime - lockStartTime);
+
     MemoryTransportStreamAccessor streamAccessor{accessMemory()};
-    auto* changelog = streamAccessor.getChangelog();
+    auto* changelog = streamAccessor.getChangelog(config_);
+    auto* changelogIndex = streamAccessor.getChangelogIndex(config_);
+    auto startChangelogId = streamAccessor.getLastChangelogID();
     auto baseTimestamp = streamAccessor.getBaseTimestamp();
-    MemoryTransportStreamIterator::MemoryTransportStreamIteratorData iterData{changelog};
+    MemoryTransportStreamIterator::MemoryTransportStreamIteratorData iterData{
+        changelog, changelogIndex};
+    iterData.readTimestampUs_ = getCurrentClockTimeMicroseconds();
+
+    std::optional<TransportStreamSnapshot> snapshot;
+    TransportStreamAccessor::SnapshotWriter snapshotWriter;
+    if (MemoryTransportStreamAccessor::hasSnapshot(config_)) {
+      snapshot.emplace(streamAccessor.getSnapshot(config_));
+      iterData.snapshot_ = &snapshot.value();
+
+      snapshotWriter = [&](const std::function<void(TransportStreamAccessor*)>& writeFunc) {
+        if (!claimSnapshotWriter(*snapshot)) {
+          return false;
+        }
+        snapshot->beginWrite();
+        TransportStreamAccessor snapshotAccessor{
+            baseTimestamp, &iterData, [&](int32_t byteCount) -> MemoryAccessor {
+              auto elementMem = snapshot->allocateElement(byteCount);
+              if (!elementMem.isNull()) {
+                markDirtyElement(elementMem, TransportStreamSnapshot::ELEMENT_HEADER_SIZE);
+              }
+              return elementMem;
+            }};
+        writeFunc(&snapshotAccessor);
+        if (!snapshot->commitWrite(changelog->getMaxID())) {
+          return false;
+        }
+        for (auto& mem : snapshot->getCommitHeaders()) {
+          markDirty(mem.getRawPointer(0, mem.getSize()), mem.getSize());
+        }
+        return true;
+      };
+    }
+
+    // only looked up once the transaction writes, so that readers skip it
+    std::optional<int32_t> retainAfterId;
+    bool didReadCursors = false;
+    TransportStreamAccessor* transportAccessorPtr = nullptr;
 
     TransportStreamAccessor transportAccessor{
-        baseTimestamp, &iterData, [&](int32_t byteCount) -> MemoryAccessor {
+        baseTimestamp,
+        &iterData,
+        [&](int32_t byteCount) -> MemoryAccessor {
+          if (transportAccessorPtr->isWriteBlocked()) {
+            transactMetrics.blockedWrites++;
+            return MemoryAccessor();
+          }
+          if (!didReadCursors) {
+            retainAfterId = getRetainedChangelogId(streamAccessor);
+            didReadCursors = true;
+          }
           int32_t changeId = 0;
-          auto eventMem = changelog->push(byteCount, &changeId);
+          auto eventMem = retainAfterId.has_value()
+              ? changelog->pushRetaining(
+                    byteCount, &changeId, retainAfterId.value(), changelogIndex)
+              : changelog->push(byteCount, &changeId, changelogIndex);
           if (!eventMem.isNull()) {
             streamAccessor.setLastChangelogID(changeId);
+            markDirtyElement(eventMem, PlacedRingBuffer::ELEMENT_HEADER_SIZE);
+            transactMetrics.eventsWritten++;
+            transactMetrics.bytesWritten += byteCount;
+          } else if (retainAfterId.has_value() && changelog->canFit(byteCount)) {
+            transactMetrics.blockedWrites++;
+            transportAccessorPtr->setWriteBlocked();
+          } else {
+            transactMetrics.failedWrites++;
           }
           return eventMem;
-        }};
+        },
+        std::move(snapshotWriter)};
+    transportAccessorPtr = &transportAccessor;
 
     func(&transportAccessor);
+    if (readIterator_ != nullptr) {
+      readIterator_->publishReaderCursor();
+      readIterator_ = nullptr;
+    }
     streamAccessor.setLastUpdateTimestamp();
 
+    // a snapshot is only kept while a single writer writes to the stream, as replaying it deletes
+    // the objects of every other writer
+    if (snapshot.has_value() && streamAccessor.getLastChangelogID() != startChangelogId) {
+      claimSnapshotWriter(*snapshot);
+    }
+
+    // the transport header and the changelog header, which is not adjacent when mirrored
+    markChangelogHeadersDirty();
+    auto bytesFlushedBefore = bytesFlushed_;
     flushWrites();
+    dirtyRanges_.clear();
+    didWrite = streamAccessor.getLastChangelogID() != startChangelogId;
+
+    transactMetrics.eventsRead = iterData.eventsRead_;
+    transactMetrics.bytesRead = iterData.bytesRead_;
+    transactMetrics.missedEntries = iterData.missedEntries_;
+    transactMetrics.eventLatency = iterData.eventLatency_;
+    transactMetrics.changelogHighWaterMark = changelog->getUsedBytes();
+    transactMetrics.changelogByteCount = changelog->poolSize;
+    transactMetrics.bytesFlushed = bytesFlushed_ - bytesFlushedBefore;
+    transactMetrics.lockHold.record(std::chrono::steady_clock::now() - holdStartTime);
+  };
+
+  bool didLock = lockAndExecute(timeout, transactBody);
+  if (!didLock) {
+    transactMetrics.transactFailures = 1;
+  }
+
+  if (didWrite && notifyChanges()) {
+    // after releasing the lock, so woken readers can take it right away
+    transactMetrics.changeWakes = 1;
+  }
+  recordMetrics(transactMetrics);
+  return didLock;
+}
+
+bool MemoryTransportStream::lockAndExecute(
+    std::chrono::milliseconds timeout,
+    const std::function<void()>& func) {
+  if (lockDomain_ != nullptr) {
+    return lockDomain_->lockAndExecute(timeout, [&]() {
+      auto ownerDeathCount = lockDomain_->getOwnerDeathCount();
+      if (ownerDeathCount != seenDomainOwnerDeathCount_) {
+        seenDomainOwnerDeathCount_ = ownerDeathCount;
+        recoverFromDeadOwner();
+      }
+      func();
+    });
+  }
+  return mutex_->lockAndExecute(static_cast<int>(timeout.count()), [&]() {
+    if (mutex_->didOwnerDie()) {
+      recoverFromDeadOwner();
+    }
+    func();
+  });
+}
+
+void MemoryTransportStream::markChangelogHeadersDirty() {
+  markDirty(memBuffer_, MemoryTransportStreamAccessor::BYTE_COUNT);
+  markDirty(
+      memBuffer_ + MemoryTransportStreamAccessor::getChangelogOffset(config_),
+      static_cast<int32_t>(sizeof(PlacedRingBuffer)));
+}
+
+void MemoryTransportStream::recoverFromDeadOwner() {
+  MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  if (streamAccessor.getBaseTimestamp() == 0) {
+    // the owner died while initializing the memory
+    streamAccessor.initialize(config_);
+    markDirty(memBuffer_, memSize_);
+  } else if (!config_.lockFree) {
+    // the owner may have died part way through writing a change, so drop the changelog; readers
+    // that had not caught up see missed entries and resync from a full update
+    streamAccessor.getChangelog(config_)->resetAfterID(streamAccessor.getLastChangelogID());
+    markChangelogHeadersDirty();
+  }
+  flushWrites();
+  dirtyRanges_.clear();
+
+  std::cerr << "MemoryTransportStream(" << name_ << "): resynced after a lock owner died\n"
+            << std::flush;
+}
+
+bool MemoryTransportStream::transactLockFree(std::function<void(TransportStreamAccessor*)>& func) {
+  // there is exactly one writer, which publishes everything written in the transaction with a
+  // single release-store of the changelog write index; readers validate entries as they copy them
+  ClockTickScope clockTick;
+  TransportStreamMetrics transactMetrics;
+  transactMetrics.transactCount = 1;
+  auto startTime = std::chrono::steady_clock::now();
+
+  MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  auto baseTimestamp = streamAccessor.getBaseTimestamp();
+  if (baseTimestamp == 0) {
+    // memory is being (re)initialized
+    transactMetrics.transactFailures = 1;
+    recordMetrics(transactMetrics);
+    return false;
+  }
+
+  auto changelog = streamAccessor.getLockFreeChangelog();
+  LockFreeMemoryTransportStreamIterator::LockFreeMemoryTransportStreamIteratorData iterData{
+      &changelog};
+  iterData.readTimestampUs_ = getCurrentClockTimeMicroseconds();
+
+  bool didWrite = false;
+  TransportStreamAccessor transportAccessor{
+      baseTimestamp, &iterData, [&](int32_t byteCount) -> MemoryAccessor {
+        if (!claimLockFreeWriter(streamAccessor, changelog)) {
+          transactMetrics.failedWrites++;
+          return MemoryAccessor();
+        }
+        auto eventMem = changelog.reserve(byteCount);
+        if (!eventMem.isNull()) {
+          didWrite = true;
+          markDirtyElement(eventMem, SpmcRingBuffer::BLOCK_HEADER_SIZE);
+          transactMetrics.eventsWritten++;
+          transactMetrics.bytesWritten += byteCount;
+        } else {
+          transactMetrics.failedWrites++;
+        }
+        return eventMem;
+      }};
+
+  func(&transportAccessor);
+  changelog.commitWrites();
+
+  // only the writer touches the headers, so reader transactions never race with it
+  if (didClaimLockFreeWriter_ && changelog.isProducer(writerToken_)) {
+    streamAccessor.setLastUpdateTimestamp();
+    markDirty(memBuffer_, MemoryTransportStreamAccessor::BYTE_COUNT + SpmcRingBuffer::HEADER_SIZE);
+  }
+  auto bytesFlushedBefore = bytesFlushed_;
+  flushWrites();
+  dirtyRanges_.clear();
+
+  // no lock to wait on, so the whole transaction counts as hold time
+  transactMetrics.eventsRead = iterData.eventsRead_;
+  transactMetrics.bytesRead = iterData.bytesRead_;
+  transactMetrics.missedEntries = iterData.missedEntries_;
+  transactMetrics.bytesFlushed = bytesFlushed_ - bytesFlushedBefore;
+  transactMetrics.lockHold.record(std::chrono::steady_clock::now() - startTime);
+
+  if (didWrite) {
+    // readers re-check the changelog after waking, so the counter only has to change
+    auto* notifyWord = streamAccessor.getChangeNotifyWord();
+    atomicStoreRelease(notifyWord, atomicLoadAcquire(notifyWord) + 1);
+    if (notifyChanges()) {
+      transactMetrics.changeWakes = 1;
+    }
+  }
+  recordMetrics(transactMetrics);
+  return true;
+}
+
+TransportStreamMetrics MemoryTransportStream::getMetrics() const {
+  std::lock_guard<std::mutex> lock(metricsMutex_);
+  return metrics_;
+}
+
+void MemoryTransportStream::resetMetrics() {
+  std::lock_guard<std::mutex> lock(metricsMutex_);
+  // the mapping flags describe the memory rather than the traffic, so they outlive a reset
+  TransportStreamMetrics metrics;
+  metrics.mappingFlagsRequested = metrics_.mappingFlagsRequested;
+  metrics.mappingFlagsApplied = metrics_.mappingFlagsApplied;
+  metrics_ = metrics;
+}
+
+void MemoryTransportStream::recordMetrics(const TransportStreamMetrics& transactMetrics) {
+  std::lock_guard<std::mutex> lock(metricsMutex_);
+  metrics_.merge(transactMetrics);
+
+  if (metricsDumpInterval_.count() > 0) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastMetricsDumpTime_ >= metricsDumpInterval_) {
+      lastMetricsDumpTime_ = now;
+      metrics_.dump(*metricsDumpStream_, name_);
+    }
+  }
+}
+
+void MemoryTransportStream::markDirty(const void* ptr, int32_t byteCount) {
+  auto start = static_cast<int32_t>(static_cast<const unsigned char*>(ptr) - memBuffer_);
+  auto end = start + byteCount;
+
+  // consecutive changelog writes are almost always contiguous, so extend the last range
+  if (!dirtyRanges_.empty()) {
+    auto& lastRange = dirtyRanges_.back();
+    if (start <= lastRange.end_ && end >= lastRange.start_) {
+      lastRange.start_ = std::min(lastRange.start_, start);
+      lastRange.end_ = std::max(lastRange.end_, end);
+      return;
+    }
+  }
+  dirtyRanges_.push_back({start, end});
+}
+
+void MemoryTransportStream::markDirtyElement(MemoryAccessor elementMem, int32_t headerSize) {
+  // include the element size header that precedes the data
+  auto* dataPtr = static_cast<unsigned char*>(elementMem.getRawPointer(0, elementMem.getSize()));
+  markDirty(dataPtr - headerSize, headerSize + elementMem.getSize());
+}
+
+void MemoryTransportStream::coalesceDirtyRanges(int32_t alignment) {
+  for (auto& range : dirtyRanges_) {
+    range.start_ = (range.start_ / alignment) * alignment;
+    range.end_ = std::min(memSize_, ((range.end_ + alignment - 1) / alignment) * alignment);
+  }
+  std::sort(dirtyRanges_.begin(), dirtyRanges_.end(), [](auto& a, auto& b) {
+    return a.start_ < b.start_;
+  });
+
+  size_t mergedCount = 0;
+  for (auto& range : dirtyRanges_) {
+    if (mergedCount > 0 && range.start_ <= dirtyRanges_[mergedCount - 1].end_) {
+      auto& lastRange = dirtyRanges_[mergedCount - 1];
+      lastRange.end_ = std::max(lastRange.end_, range.end_);
+    } else {
+      dirtyRanges_[mergedCount++] = range;
+    }
+  }
+  dirtyRanges_.resize(mergedCount);
+}
+
+bool MemoryTransportStream::waitForChangeNotify(
+    uint32_t lastSeenValue,
+    std::chrono::steady_clock::time_point deadline) {
+  auto now = std::chrono::steady_clock::now();
+  if (now >= deadline || memBuffer_ == nullptr) {
+    return false;
+  }
+
+#if defined(__linux__)
+  MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now);
+  struct timespec ts{};
+  ts.tv_sec = timeout.count() / 1000000000;
+  ts.tv_nsec = timeout.count() % 1000000000;
+  // counted before sleeping, so that notifyChanges() knows to wake us
+  if (changeWaiterCount_ != nullptr) {
+    atomicFetchAdd(changeWaiterCount_, 1);
+  }
+  // not FUTEX_PRIVATE_FLAG, the word is shared across processes; returns immediately if the word
+  // has already changed
+  syscall(
+      SYS_futex,
+      streamAccessor.getChangeNotifyWord(),
+      FUTEX_WAIT,
+      lastSeenValue,
+      &ts,
+      nullptr,
+      0);
+  if (changeWaiterCount_ != nullptr) {
+    atomicFetchAdd(changeWaiterCount_, static_cast<uint32_t>(-1));
+  }
+#else
+  // no cross-process address wait on these platforms, so poll at a fine granularity instead
+  sleepUntil(
+      std::min<std::chrono::steady_clock::time_point>(deadline, now + CHANGE_POLL_INTERVAL),
+      std::chrono::microseconds{0});
+#endif
+  return true;
+}
+
+bool MemoryTransportStream::notifyChanges() {
+#if defined(__linux__)
+  if (memBuffer_ == nullptr) {
+    return false;
+  }
+  if (changeWaiterCount_ != nullptr) {
+    // orders the notify word written by the transaction before the count is read, pairing with
+    // the count increment in waitForChangeNotify(), so that a waiter is either seen here or sees
+    // the new notify word value
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (atomicLoadAcquire(changeWaiterCount_) == 0) {
+      return false;
+    }
+  }
+  MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  syscall(
+      SYS_futex, streamAccessor.getChangeNotifyWord(), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void MemoryTransportStream::growChangelog(PlacedRingBuffer* changelog) {
+  auto capacity = MemoryTransportStreamAccessor::getChangelogCapacity(config_);
+  if (config_.lockFree || changelog->poolSize >= capacity) {
+    return;
+  }
+  auto newPoolSize = std::min(capacity, changelog->poolSize * 2);
+  changelog->grow(newPoolSize);
+  std::cout << "MemoryTransportStream(" << name_ << "): changelog grown to " << newPoolSize
+            << " bytes\n"
+            << std::flush;
+}
+
+static uint64_t generateReaderToken() {
+  // unique across the processes attached to the stream, and never 0
+  static const uint64_t processSalt = static_cast<uint64_t>(std::random_device{}()) << 32;
+  static std::atomic<uint32_t> nextReaderId{1};
+  auto token = processSalt | nextReaderId.fetch_add(1, std::memory_order_relaxed);
+  return token != 0 ? token : 1;
+}
+
+bool MemoryTransportStream::claimSnapshotWriter(TransportStreamSnapshot& snapshot) {
+  auto writerToken = getWriterToken();
+  if (snapshot.getWriterToken() == writerToken) {
+    return true;
+  }
+  auto header = snapshot.getHeader();
+  markDirty(header.getRawPointer(0, header.getSize()), header.getSize());
+  return snapshot.claimWriter(writerToken);
+}
+
+uint32_t MemoryTransportStream::getWriterToken() {
+  if (writerToken_ == 0) {
+    auto token = generateReaderToken();
+    // never 0, which marks an unclaimed writer slot, nor TransportStreamSnapshot::SHARED_WRITER
+    writerToken_ = static_cast<uint32_t>(token ^ (token >> 32)) & 0x7fffffff;
+    writerToken_ = writerToken_ != 0 ? writerToken_ : 1;
+  }
+  return writerToken_;
+}
+
+bool MemoryTransportStream::claimLockFreeWriter(
+    MemoryTransportStreamAccessor& streamAccessor,
+    SpmcRingBuffer& changelog) {
+  // a claim held by a writer whose heartbeat has lapsed is taken over
+  if (changelog.claimProducer(getWriterToken(), isTransportExpired(streamAccessor))) {
+    didClaimLockFreeWriter_ = true;
+    hasLoggedWriterConflict_ = false;
+    return true;
+  }
+
+  if (!hasLoggedWriterConflict_) {
+    hasLoggedWriterConflict_ = true;
+    std::cerr << "MemoryTransportStream(" << name_
+              << "): another writer owns the lock-free changelog, refusing writes\n"
+              << std::flush;
+  }
+  return false;
+}
+
+void MemoryTransportStream::releaseLockFreeWriter() {
+  if (didClaimLockFreeWriter_ && memBuffer_ != nullptr) {
+    MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+    streamAccessor.getLockFreeChangelog().releaseProducer(writerToken_);
+    didClaimLockFreeWriter_ = false;
+  }
+}
+
+std::optional<int32_t> MemoryTransportStream::getRetainedChangelogId(
+    MemoryTransportStreamAccessor& streamAccessor) {
+  if (!MemoryTransportStreamAccessor::hasReaderCursors(config_)) {
+    return std::nullopt;
+  }
+
+  auto* cursors = streamAccessor.getReaderCursors(config_);
+  auto nowMs = streamAccessor.getElapsedMilliseconds();
+  std::optional<int32_t> retainAfterId;
+  for (int32_t i = 0; i < config_.losslessReaderCount; ++i) {
+    auto& cursor = cursors[i];
+    if (cursor.readerToken == 0) {
+      continue;
+    }
+    // signed, as the reader may have refreshed its cursor after this transaction sampled the clock
+    auto idleMs = static_cast<int32_t>(nowMs - atomicLoadAcquire(&cursor.lastActiveMs));
+    if (idleMs > READER_CURSOR_EXPIRE_MS) {
+      std::cout << "MemoryTransportStream(" << name_ << "): evicting expired reader cursor " << i
+                << "\n"
+                << std::flush;
+      cursor.readerToken = 0;
+      markDirty(&cursor, sizeof(cursor));
+      continue;
+    }
+    retainAfterId = std::min(retainAfterId.value_or(INT32_MAX), cursor.lastReadId);
+  }
+  return retainAfterId;
+}
+
+void MemoryTransportStream::updateReaderCursor(ReaderCursorHandle& handle, int32_t lastReadId) {
+  if (!MemoryTransportStreamAccessor::hasReaderCursors(config_) || memBuffer_ == nullptr) {
+    return;
+  }
+
+  MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  auto* cursors = streamAccessor.getReaderCursors(config_);
+  if (handle.slot >= 0 && cursors[handle.slot].readerToken != handle.token) {
+    handle.slot = -1;
+  }
+
+  if (handle.slot < 0) {
+    for (int32_t i = 0; i < config_.losslessReaderCount; ++i) {
+      if (cursors[i].readerToken == 0) {
+        handle.slot = i;
+        handle.token = generateReaderToken();
+        cursors[i].readerToken = handle.token;
+        break;
+      }
+    }
+    if (handle.slot < 0) {
+      // every slot is taken, so this reader reads without holding the writer back
+      return;
+    }
+  }
+
+  auto& cursor = cursors[handle.slot];
+  cursor.lastReadId = lastReadId;
+  atomicStoreRelease(&cursor.lastActiveMs, streamAccessor.getElapsedMilliseconds());
+  markDirty(&cursor, sizeof(cursor));
+}
+
+void MemoryTransportStream::refreshReaderCursor(const ReaderCursorHandle& handle) {
+  if (handle.slot < 0 || memBuffer_ == nullptr) {
+    return;
+  }
+  MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  auto& cursor = streamAccessor.getReaderCursors(config_)[handle.slot];
+  if (cursor.readerToken == handle.token) {
+    atomicStoreRelease(&cursor.lastActiveMs, streamAccessor.getElapsedMilliseconds());
+  }
+}
+
+void MemoryTransportStream::releaseReaderCursor(ReaderCursorHandle& handle) {
+  if (handle.slot < 0 || memBuffer_ == nullptr) {
+    return;
+  }
+  // if the lock cannot be had, the slot is reclaimed once it expires instead
+  lockAndExecute(READER_CURSOR_RELEASE_TIMEOUT, [&]() {
+    MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+    auto& cursor = streamAccessor.getReaderCursors(config_)[handle.slot];
+    if (cursor.readerToken == handle.token) {
+      cursor.readerToken = 0;
+      markDirty(&cursor, sizeof(cursor));
+      flushWrites();
+      dirtyRanges_.clear();
+    }
   });
+  handle.slot = -1;
 }
 
 std::unique_ptr<TransportStreamIterator> MemoryTransportStream::createIterator() {
+  if (config_.lockFree) {
+    return std::make_unique<LockFreeMemoryTransportStreamIterator>(this);
+  }
   return std::make_unique<MemoryTransportStreamIterator>(this);
 }
 
 bool MemoryTransportStream::needsHeartbeat() {
   // lock-free version check against the transport header
   MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  if (config_.lockFree &&
+      !(didClaimLockFreeWriter_ &&
+        streamAccessor.getLockFreeChangelog().isProducer(writerToken_))) {
+    // only the writer keeps the header of a lock-free stream fresh
+    return false;
+  }
   return streamAccessor.getLastUpdateAgeMicroseconds() > TRANSPORT_HEARTBEAT_INTERVAL.count();
 }
 
 bool MemoryTransportStream::initializeMemoryOnCreate() {
-  return mutex_->lockAndExecute(
-      std::chrono::duration_cast<std::chrono::milliseconds>(INIT_TIMEOUT).count(), [&]() {
-        MemoryTransportStreamAccessor streamAccessor{accessMemory()};
-        streamAccessor.initialize(config_);
-      });
+  return lockAndExecute(std::chrono::duration_cast<std::chrono::milliseconds>(INIT_TIMEOUT), [&]() {
+    MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+    streamAccessor.initialize(config_);
+  });
+}
+
+static size_t getSystemPageSize() {
+#if defined(WIN32)
+  SYSTEM_INFO sysInfo;
+  GetSystemInfo(&sysInfo);
+  return sysInfo.dwPageSize;
+#elif defined(__APPLE__) || defined(__linux__)
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 4096;
+#endif
+}
+
+void MemoryTransportStream::applyMappingFlags(
+    unsigned char* mem,
+    int32_t byteCount,
+    uint32_t alreadyApplied) {
+  uint32_t requested = config_.mappingFlags;
+  if (requested == 0 || mem == nullptr || byteCount <= 0) {
+    return;
+  }
+  uint32_t applied = alreadyApplied & requested;
+
+  if ((requested & MappingHugePages) != 0) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // transparent huge pages are advisory, and only apply to the page-aligned interior
+    auto pageSize = getSystemPageSize();
+    auto start = (reinterpret_cast<uintptr_t>(mem) + pageSize - 1) & ~(pageSize - 1);
+    auto end = (reinterpret_cast<uintptr_t>(mem) + byteCount) & ~(pageSize - 1);
+    if (end > start && madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE) == 0) {
+      applied |= MappingHugePages;
+    }
+#endif
+  }
+
+  if ((requested & MappingPrefault) != 0 && (applied & MappingPrefault) == 0) {
+    // read one byte per page; the memory may already be in use by another process, so it must not
+    // be written to
+    auto pageSize = static_cast<int32_t>(getSystemPageSize());
+    volatile unsigned char* touchPtr = mem;
+    unsigned char sum = 0;
+    for (int32_t offset = 0; offset < byteCount; offset += pageSize) {
+      sum += touchPtr[offset];
+    }
+    sum += touchPtr[byteCount - 1];
+    (void)sum;
+    applied |= MappingPrefault;
+  }
+
+  if ((requested & MappingLockInMemory) != 0) {
+#if defined(WIN32)
+    if (VirtualLock(mem, byteCount)) {
+      applied |= MappingLockInMemory;
+    }
+#elif defined(__APPLE__) || defined(__linux__)
+    if (mlock(mem, byteCount) == 0) {
+      applied |= MappingLockInMemory;
+    }
+#endif
+  }
+
+  if (applied != requested) {
+    std::cout << "MemoryTransportStream(" << name_ << "): mapping flags 0x" << std::hex
+              << (requested & ~applied) << std::dec << " not supported, skipped\n"
+              << std::flush;
+  }
+
+  std::lock_guard<std::mutex> lock(metricsMutex_);
+  metrics_.mappingFlagsRequested = requested;
+  metrics_.mappingFlagsApplied = applied;
+}
+
+void MemoryTransportStream::releaseMappingFlags(unsigned char* mem, int32_t byteCount) {
+  if (mem == nullptr || byteCount <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(metricsMutex_);
+  if ((metrics_.mappingFlagsApplied & MappingLockInMemory) == 0) {
+    return;
+  }
+#if defined(WIN32)
+  VirtualUnlock(mem, byteCount);
+#elif defined(__APPLE__) || defined(__linux__)
+  munlock(mem, byteCount);
+#endif
+  metrics_.mappingFlagsApplied &= ~static_cast<uint32_t>(MappingLockInMemory);
+}
+
+bool MemoryTransportStream::isTransportExpired(MemoryTransportStreamAccessor& streamAccessor) {
+  return streamAccessor.getLastUpdateAgeMicroseconds() > TRANSPORT_EXPIRE_TIME.count();
 }
 
 bool MemoryTransportStream::initializeMemory(bool didCreate) {
-  if (memBuffer_ == nullptr || mutex_ == nullptr) {
+  if (memBuffer_ == nullptr || (mutex_ == nullptr && lockDomain_ == nullptr)) {
     return false;
   }
 
@@ -111,10 +781,9 @@ bool MemoryTransportStream::initializeMemory(bool didCreate) {
 
   if (streamAccessor.getBaseTimestamp() == 0) {
     // another process could be initializing the memory, so wait for it to finish
-    mutex_->lockAndExecute(
-        std::chrono::duration_cast<std::chrono::milliseconds>(INIT_TIMEOUT).count(), [&]() {
-          // no-op, just needed to wait for the other process to finish initializing the memory
-        });
+    lockAndExecute(std::chrono::duration_cast<std::chrono::milliseconds>(INIT_TIMEOUT), [&]() {
+      // no-op, just needed to wait for the other process to finish initializing the memory
+    });
     if (streamAccessor.getBaseTimestamp() == 0) {
       // if the memory is still not initialized after the timeout, then re-initialize it
       return initializeMemoryOnCreate();
@@ -131,7 +800,7 @@ bool MemoryTransportStream::initializeMemory(bool didCreate) {
   }
 
   // check if the transport memory has expired
-  if (streamAccessor.getLastUpdateAgeMicroseconds() > TRANSPORT_EXPIRE_TIME.count()) {
+  if (isTransportExpired(streamAccessor)) {
     std::cout << "MemoryTransportStream(" << name_
               << ")::initializeMemory: transport memory expired, reinitializing\n"
               << std::flush;
@@ -152,6 +821,28 @@ bool MemoryTransportStream::initializeMemory(bool didCreate) {
     return false;
   }
 
+  if (streamAccessor.getTotalBytes() != memSize_ ||
+      streamAccessor.getStoredLayoutHash(config_) !=
+          MemoryTransportStreamAccessor::getLayoutHash(config_)) {
+    // configured with a different memory layout, so the regions are elsewhere; error out
+    std::cerr << "MemoryTransportStream(" << name_
+              << ")::initializeMemory: memory layout mismatch\n"
+              << std::flush;
+    return false;
+  }
+
+  if (!config_.lockFree) {
+    // the changelog only ever grows within the capacity reserved for it
+    auto poolSize = streamAccessor.getChangelog(config_)->poolSize;
+    if (poolSize < config_.changelogByteCount ||
+        poolSize > MemoryTransportStreamAccessor::getChangelogCapacity(config_)) {
+      std::cerr << "MemoryTransportStream(" << name_
+                << ")::initializeMemory: changelog size out of range\n"
+                << std::flush;
+      return false;
+    }
+  }
+
   return true;
 }
 
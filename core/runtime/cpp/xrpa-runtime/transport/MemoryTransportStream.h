@@ -17,6 +17,8 @@
 #pragma once
 
 #include <xrpa-runtime/transport/InterprocessMutex.h>
+#include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
+#include <xrpa-runtime/transport/TransportLockDomain.h>
 #include <xrpa-runtime/transport/TransportStream.h>
 #include <xrpa-runtime/transport/TransportStreamAccessor.h>
 #include <xrpa-runtime/utils/MemoryAccessor.h>
@@ -25,10 +27,16 @@
 #include <xrpa-runtime/utils/XrpaUtils.h>
 #include <chrono>
 #include <functional>
+#include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 namespace Xrpa {
 
+class MemoryTransportStreamIterator;
+
 class MemoryTransportStream : public TransportStream {
  public:
   MemoryTransportStream(const std::string& name, const TransportConfig& config);
@@ -42,26 +50,168 @@ class MemoryTransportStream : public TransportStream {
 
   bool needsHeartbeat() override;
 
+  TransportStreamMetrics getMetrics() const override;
+
+  void resetMetrics() override;
+
+  // total bytes handed to the platform flush after transactions, 0 where no flush is needed
+  uint64_t getBytesFlushed() const {
+    return getMetrics().bytesFlushed;
+  }
+
+  // periodically dumps the metrics to out from within transact(); a zero interval disables it
+  template <typename R>
+  void setMetricsDumpInterval(
+      std::chrono::duration<int64_t, R> interval,
+      std::ostream& out = std::cout) {
+    std::lock_guard<std::mutex> lock(metricsMutex_);
+    metricsDumpInterval_ = std::chrono::duration_cast<std::chrono::microseconds>(interval);
+    metricsDumpStream_ = &out;
+  }
+
  protected:
   friend class MemoryTransportStreamIterator;
+  friend class LockFreeMemoryTransportStreamIterator;
+
+  // for derived classes that supply their own mutex once the memory is mapped
+  MemoryTransportStream(
+      const std::string& name,
+      const TransportConfig& config,
+      std::unique_ptr<InterprocessMutex> mutex);
 
   std::string name_;
   TransportConfig config_;
   int32_t memSize_ = 0;
   std::unique_ptr<InterprocessMutex> mutex_;
+  // set when config_.lockDomain is, in which case it is locked instead of mutex_
+  std::shared_ptr<TransportLockDomain> lockDomain_;
 
   unsigned char* memBuffer_ = nullptr;
 
+  // Threads of any process sleeping in waitForChangeNotify(), so that notifyChanges() skips the
+  // wake syscall when nobody waits. Set by derived classes that have shared memory to spare
+  // outside the transport layout; otherwise every writing transaction wakes. A waiter that dies
+  // asleep leaves the count high, which only costs the skipped wakes.
+  volatile uint32_t* changeWaiterCount_ = nullptr;
+
   [[nodiscard]] MemoryAccessor accessMemory() const {
     return {memBuffer_, 0, memSize_};
   }
 
   bool initializeMemory(bool didCreate);
 
+  // whether the heartbeat of memory set up by another process has lapsed, so nobody is using it
+  static bool isTransportExpired(MemoryTransportStreamAccessor& streamAccessor);
+
+  // Applies the config_.mappingFlags hints to freshly mapped transport memory, skipping whatever
+  // the platform cannot honor, and records the outcome in the metrics. Flags the caller already
+  // honored while mapping (such as MAP_POPULATE) are passed in alreadyApplied.
+  void applyMappingFlags(unsigned char* mem, int32_t byteCount, uint32_t alreadyApplied = 0);
+
+  // undoes MappingLockInMemory, for memory that is freed rather than unmapped
+  void releaseMappingFlags(unsigned char* mem, int32_t byteCount);
+
+  // Blocks until the header change notify word no longer holds lastSeenValue, or until the
+  // deadline. Returns false without waiting once the deadline has passed.
+  bool waitForChangeNotify(uint32_t lastSeenValue, std::chrono::steady_clock::time_point deadline);
+  // wakes the readers blocked in waitForChangeNotify(); returns false if there was nobody to wake
+  bool notifyChanges();
+
+  // Doubles the changelog, up to TransportConfig::maxChangelogByteCount, once a reader has fallen
+  // far enough behind to miss entries. Called with the transport lock held.
+  void growChangelog(PlacedRingBuffer* changelog);
+
+  // the slot a reader holds in the TransportConfig::losslessReaderCount cursor table
+  struct ReaderCursorHandle {
+    int32_t slot = -1;
+    uint64_t token = 0;
+  };
+
+  // Publishes the reader's position, claiming a free slot first if it holds none or the writer
+  // evicted it; entries dropped meanwhile show up in the changelog IDs. Called with the transport
+  // lock held.
+  void updateReaderCursor(ReaderCursorHandle& handle, int32_t lastReadId);
+
+  // marks the reader as alive, without taking the lock
+  void refreshReaderCursor(const ReaderCursorHandle& handle);
+
+  // frees the reader's slot, taking the transport lock
+  void releaseReaderCursor(ReaderCursorHandle& handle);
+
+  // the iterator that read in the current transaction, whose reader cursor transact() publishes
+  // once func returns
+  MemoryTransportStreamIterator* readIterator_ = nullptr;
+
+  // byte range of the transport memory, [start_, end_)
+  struct DirtyRange {
+    int32_t start_;
+    int32_t end_;
+  };
+
+  // ranges written by the current transaction, cleared once flushWrites() returns
+  std::vector<DirtyRange> dirtyRanges_;
+  // incremented by flushWrites()
+  uint64_t bytesFlushed_ = 0;
+
+  void markDirty(const void* ptr, int32_t byteCount);
+  void markChangelogHeadersDirty();
+  void markDirtyElement(MemoryAccessor elementMem, int32_t headerSize);
+
+  // widens dirtyRanges_ out to multiples of alignment, then sorts and merges them
+  void coalesceDirtyRanges(int32_t alignment);
+
+  // makes the dirtyRanges_ of the transaction visible to other processes
   virtual void flushWrites() {}
 
+  // gives up this stream's claim on the single writer slot of a lock-free changelog, for
+  // derived classes to call before the memory goes away
+  void releaseLockFreeWriter();
+
  private:
   bool initializeMemoryOnCreate();
+
+  // takes lockDomain_ if the stream has one, otherwise mutex_
+  bool lockAndExecute(std::chrono::milliseconds timeout, const std::function<void()>& func);
+
+  // called with the lock held when its previous owner died holding it, leaving the memory in an
+  // unknown state
+  void recoverFromDeadOwner();
+
+  // the lockDomain_ owner death count as of joining the domain or this stream's last transaction;
+  // any process the domain lost may have been writing to this stream, even if it died during
+  // another member's transaction, so a member that has not locked since then recovers
+  uint32_t seenDomainOwnerDeathCount_ = 0;
+
+  bool transactLockFree(std::function<void(TransportStreamAccessor*)>& func);
+
+  // a lock-free changelog has a single writer, which claims it on its first write; returns false
+  // if another writer holds the claim
+  bool claimLockFreeWriter(
+      MemoryTransportStreamAccessor& streamAccessor,
+      SpmcRingBuffer& changelog);
+
+  // identifies this stream as the writer of a lock-free changelog or a snapshot, generated on
+  // first use
+  uint32_t writerToken_ = 0;
+  uint32_t getWriterToken();
+
+  // returns false once another writer has written to the stream, which drops its snapshot
+  bool claimSnapshotWriter(TransportStreamSnapshot& snapshot);
+
+  bool didClaimLockFreeWriter_ = false;
+  bool hasLoggedWriterConflict_ = false;
+
+  void recordMetrics(const TransportStreamMetrics& transactMetrics);
+
+  // the last changelog ID that every registered reader has read, nullopt if no reader holds the
+  // writer back; readers that stopped ticking are evicted from the table along the way
+  std::optional<int32_t> getRetainedChangelogId(MemoryTransportStreamAccessor& streamAccessor);
+
+  mutable std::mutex metricsMutex_;
+  TransportStreamMetrics metrics_;
+  std::chrono::microseconds metricsDumpInterval_{};
+  std::chrono::steady_clock::time_point lastMetricsDumpTime_{};
+  std::ostream* metricsDumpStream_ = &std::cout;
 };
 
 } // namespace Xrpa
@@ -16,23 +16,184 @@
 
 #pragma once
 
+#include <xrpa-runtime/transport/TransportStreamSnapshot.h>
 #include <xrpa-runtime/utils/MemoryAccessor.h>
+#include <xrpa-runtime/utils/MirroredMapping.h>
 #include <xrpa-runtime/utils/PlacedRingBuffer.h>
+#include <xrpa-runtime/utils/SpmcRingBuffer.h>
 #include <xrpa-runtime/utils/TimeUtils.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
+#include <algorithm>
 
 namespace Xrpa {
 
+// One slot of the TransportConfig::losslessReaderCount reader cursor table, which follows the
+// changelog and snapshot regions.
+struct TransportReaderCursor {
+  // nonzero while a reader holds the slot
+  uint64_t readerToken;
+  // the last changelog ID the reader has read; the writer retains every entry after it
+  int32_t lastReadId;
+  // when the reader last ticked, in milliseconds from the transport base timestamp; only the
+  // reader writes it, and it does so without holding the lock
+  uint32_t lastActiveMs;
+};
+static_assert(sizeof(TransportReaderCursor) == 16);
+
 class MemoryTransportStreamAccessor : public ObjectAccessorInterface {
  public:
   static constexpr int32_t BYTE_COUNT = 56;
-  static constexpr int32_t TRANSPORT_VERSION = 9; // conorwdickinson: heartbeat and expiration
+  static constexpr int32_t TRANSPORT_VERSION = 10; // microsecond change event timestamps
+
+  // block size of the SpmcRingBuffer changelog used by lock-free streams
+  static constexpr int32_t LOCK_FREE_CHANGELOG_BLOCK_SIZE = 64;
+
+  static int32_t getLockFreeChangelogBlockCount(const TransportConfig& config) {
+    return std::max(1, config.changelogByteCount / LOCK_FREE_CHANGELOG_BLOCK_SIZE);
+  }
+
+  // bytes reserved for the changelog pool, which it starts out using only changelogByteCount of
+  static int32_t getChangelogCapacity(const TransportConfig& config) {
+    if (config.lockFree) {
+      return config.changelogByteCount;
+    }
+    if (hasMirroredChangelog(config)) {
+      auto pageSize = getMemoryPageSize();
+      return (config.changelogByteCount + pageSize - 1) / pageSize * pageSize;
+    }
+    return std::max(config.changelogByteCount, config.maxChangelogByteCount);
+  }
+
+  static bool hasGrowableChangelog(const TransportConfig& config) {
+    return !config.lockFree && !hasMirroredChangelog(config) &&
+        config.maxChangelogByteCount > config.changelogByteCount;
+  }
+
+  static bool hasMirroredChangelog(const TransportConfig& config) {
+    return !config.lockFree && config.mirroredChangelog;
+  }
+
+  // from the start of the transport memory; a mirrored changelog is placed so that its pool
+  // starts on a page boundary
+  static int32_t getChangelogOffset(const TransportConfig& config) {
+    if (hasMirroredChangelog(config)) {
+      return getMemoryPageSize() - static_cast<int32_t>(sizeof(PlacedRingBuffer));
+    }
+    return BYTE_COUNT;
+  }
+
+  static int32_t getChangelogPoolOffset(const TransportConfig& config) {
+    return getChangelogOffset(config) + static_cast<int32_t>(sizeof(PlacedRingBuffer));
+  }
+
+  // past the reserved changelog capacity, and its mirror if any
+  static int32_t getChangelogEndOffset(const TransportConfig& config) {
+    int32_t offset = getChangelogPoolOffset(config) + getChangelogCapacity(config);
+    if (hasMirroredChangelog(config)) {
+      offset += getChangelogCapacity(config);
+    }
+    return offset;
+  }
 
   static int32_t getMemSize(const TransportConfig& config) {
-    return BYTE_COUNT + PlacedRingBuffer::getMemSize(config.changelogByteCount);
+    if (config.lockFree) {
+      return BYTE_COUNT +
+          SpmcRingBuffer::getMemSize(
+                 LOCK_FREE_CHANGELOG_BLOCK_SIZE, getLockFreeChangelogBlockCount(config));
+    }
+    if (hasExtendedLayout(config)) {
+      return getLayoutFooterOffset(config) + LAYOUT_FOOTER_BYTE_COUNT;
+    }
+    return getRegionsEndOffset(config);
+  }
+
+  // whether the memory holds regions that only the C++ runtime lays out
+  static bool hasExtendedLayout(const TransportConfig& config) {
+    return hasSnapshot(config) || hasGrowableChangelog(config) || hasReaderCursors(config) ||
+        hasChangelogIndex(config) || hasMirroredChangelog(config);
+  }
+
+  // Identifies the placement of the C++-only regions, so that processes configured differently
+  // never use each other's memory; 0 for the layout shared with the C# and Python runtimes.
+  static uint32_t getLayoutHash(const TransportConfig& config) {
+    if (!hasExtendedLayout(config)) {
+      return 0;
+    }
+    // FNV-1a over the layout parameters
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](int32_t value) {
+      for (int32_t i = 0; i < 4; ++i) {
+        hash = (hash ^ ((static_cast<uint32_t>(value) >> (i * 8)) & 0xFF)) * 16777619u;
+      }
+    };
+    mix(config.changelogByteCount);
+    mix(config.snapshotByteCount);
+    mix(getChangelogCapacity(config));
+    mix(hasReaderCursors(config) ? config.losslessReaderCount : 0);
+    mix(hasChangelogIndex(config) ? config.changelogIndexCapacity : 0);
+    mix(hasMirroredChangelog(config) ? 1 : 0);
+    return hash;
+  }
+
+  static bool hasSnapshot(const TransportConfig& config) {
+    return !config.lockFree && config.snapshotByteCount > 0;
+  }
+
+  static bool hasReaderCursors(const TransportConfig& config) {
+    return !config.lockFree && config.losslessReaderCount > 0;
+  }
+
+  static bool hasChangelogIndex(const TransportConfig& config) {
+    return !config.lockFree && config.changelogIndexCapacity > 0;
+  }
+
+  // from the start of the transport memory, 4-byte aligned
+  static int32_t getChangelogIndexOffset(const TransportConfig& config) {
+    int32_t offset = getChangelogEndOffset(config);
+    if (hasSnapshot(config)) {
+      offset += TransportStreamSnapshot::getMemSize(config.snapshotByteCount);
+    }
+    return (offset + 3) & ~3;
+  }
+
+  // from the start of the transport memory, 8-byte aligned
+  static int32_t getReaderCursorsOffset(const TransportConfig& config) {
+    int32_t offset = getChangelogIndexOffset(config);
+    if (hasChangelogIndex(config)) {
+      offset += PlacedRingBufferIndex::getMemSize(config.changelogIndexCapacity);
+    }
+    return (offset + 7) & ~7;
+  }
+
+  // past every region of a locking stream, ahead of the layout footer
+  static int32_t getRegionsEndOffset(const TransportConfig& config) {
+    int32_t offset = getChangelogEndOffset(config);
+    if (hasSnapshot(config)) {
+      offset += TransportStreamSnapshot::getMemSize(config.snapshotByteCount);
+    }
+    if (hasChangelogIndex(config)) {
+      offset = getChangelogIndexOffset(config) +
+          PlacedRingBufferIndex::getMemSize(config.changelogIndexCapacity);
+    }
+    if (hasReaderCursors(config)) {
+      offset = getReaderCursorsOffset(config) +
+          config.losslessReaderCount * static_cast<int32_t>(sizeof(TransportReaderCursor));
+    }
+    return offset;
   }
+
+  // The layout footer of extended layouts holds getLayoutHash(), which attaching processes check.
+  // It sits at the end of the memory, leaving the header shared with the other runtimes as is.
+  static constexpr int32_t LAYOUT_FOOTER_BYTE_COUNT = 8;
+
+  // from the start of the transport memory, 8-byte aligned
+  static int32_t getLayoutFooterOffset(const TransportConfig& config) {
+    return (getRegionsEndOffset(config) + 7) & ~7;
+  }
+
   explicit MemoryTransportStreamAccessor(const MemoryAccessor& memAccessor)
-      : ObjectAccessorInterface(memAccessor.slice(0, BYTE_COUNT)) {}
+      : ObjectAccessorInterface(memAccessor.slice(0, BYTE_COUNT)),
+        changelogMem_(memAccessor.slice(BYTE_COUNT)) {}
 
   int32_t getTransportVersion() {
     auto offset = MemoryOffset(0);
@@ -84,6 +245,13 @@ class MemoryTransportStreamAccessor : public ObjectAccessorInterface {
     memAccessor_.writeValue<int32_t>(id, offset);
   }
 
+  // Futex word that readers block on in waitForChanges(). For locking streams it is the last
+  // changelog ID; lock-free streams do not otherwise use that field, so the writer increments it
+  // as a change counter instead.
+  volatile uint32_t* getChangeNotifyWord() {
+    return static_cast<volatile uint32_t*>(memAccessor_.getRawPointer(48, 4));
+  }
+
   // returns the time in microseconds since the last update
   uint64_t getLastUpdateAgeMicroseconds() {
     // stored value is in milliseconds, offset from baseTimestamp
@@ -94,6 +262,11 @@ class MemoryTransportStreamAccessor : public ObjectAccessorInterface {
     return current_elapsed_us - last_elapsed_us;
   }
 
+  // milliseconds since baseTimestamp, wrapping; the clock of the reader cursor table
+  uint32_t getElapsedMilliseconds() {
+    return static_cast<uint32_t>((getCurrentClockTimeMicroseconds() - getBaseTimestamp()) / 1000);
+  }
+
   // sets the last update timestamp to the current time
   void setLastUpdateTimestamp() {
     // stored value is in milliseconds, offset from baseTimestamp
@@ -103,8 +276,47 @@ class MemoryTransportStreamAccessor : public ObjectAccessorInterface {
     memAccessor_.writeValue<uint32_t>(elapsed_ms, offset);
   }
 
-  PlacedRingBuffer* getChangelog() {
-    return static_cast<PlacedRingBuffer*>(memAccessor_.getRawPointer(BYTE_COUNT, 0));
+  PlacedRingBuffer* getChangelog(const TransportConfig& config) {
+    return static_cast<PlacedRingBuffer*>(
+        changelogMem_.getRawPointer(getChangelogOffset(config) - BYTE_COUNT, 0));
+  }
+
+  // for TransportConfig::lockFree streams
+  SpmcRingBuffer getLockFreeChangelog() {
+    return {changelogMem_, 0};
+  }
+
+  // for TransportConfig::snapshotByteCount streams; the snapshot region follows the reserved
+  // changelog capacity, so that it stays put as the changelog grows
+  TransportStreamSnapshot getSnapshot(const TransportConfig& config) {
+    return TransportStreamSnapshot{changelogMem_.slice(getChangelogEndOffset(config) - BYTE_COUNT)};
+  }
+
+  // null unless TransportConfig::changelogIndexCapacity is set
+  PlacedRingBufferIndex* getChangelogIndex(const TransportConfig& config) {
+    if (!hasChangelogIndex(config)) {
+      return nullptr;
+    }
+    auto offset = getChangelogIndexOffset(config) - BYTE_COUNT;
+    auto byteCount = PlacedRingBufferIndex::getMemSize(config.changelogIndexCapacity);
+    return static_cast<PlacedRingBufferIndex*>(changelogMem_.getRawPointer(offset, byteCount));
+  }
+
+  // for TransportConfig::losslessReaderCount streams
+  TransportReaderCursor* getReaderCursors(const TransportConfig& config) {
+    auto offset = getReaderCursorsOffset(config) - BYTE_COUNT;
+    auto byteCount =
+        config.losslessReaderCount * static_cast<int32_t>(sizeof(TransportReaderCursor));
+    return static_cast<TransportReaderCursor*>(changelogMem_.getRawPointer(offset, byteCount));
+  }
+
+  // the layout hash the memory was initialized with, 0 if it has no layout footer
+  uint32_t getStoredLayoutHash(const TransportConfig& config) {
+    if (!hasExtendedLayout(config)) {
+      return 0;
+    }
+    auto offset = MemoryOffset(getLayoutFooterOffset(config) - BYTE_COUNT);
+    return changelogMem_.readValue<uint32_t>(offset);
   }
 
   void setNull() {
@@ -122,7 +334,29 @@ class MemoryTransportStreamAccessor : public ObjectAccessorInterface {
     setSchemaHash(config.schemaHash);
     setTotalBytes(getMemSize(config));
 
-    getChangelog()->init(config.changelogByteCount);
+    if (config.lockFree) {
+      getLockFreeChangelog().init(
+          LOCK_FREE_CHANGELOG_BLOCK_SIZE, getLockFreeChangelogBlockCount(config));
+    } else {
+      if (hasMirroredChangelog(config)) {
+        getChangelog(config)->initMirrored(getChangelogCapacity(config));
+      } else {
+        getChangelog(config)->init(config.changelogByteCount);
+      }
+      if (hasSnapshot(config)) {
+        getSnapshot(config).init(config.snapshotByteCount);
+      }
+      if (hasChangelogIndex(config)) {
+        getChangelogIndex(config)->init(config.changelogIndexCapacity);
+      }
+      if (hasReaderCursors(config)) {
+        std::fill_n(getReaderCursors(config), config.losslessReaderCount, TransportReaderCursor{});
+      }
+      if (hasExtendedLayout(config)) {
+        auto offset = MemoryOffset(getLayoutFooterOffset(config) - BYTE_COUNT);
+        changelogMem_.writeValue<uint32_t>(getLayoutHash(config), offset);
+      }
+    }
 
     // set this last as it tells anyone accessing the header
     // without a mutex lock that the header is not yet initialized
@@ -133,6 +367,9 @@ class MemoryTransportStreamAccessor : public ObjectAccessorInterface {
   bool isInitialized() {
     return !memAccessor_.isNull();
   }
+
+ private:
+  MemoryAccessor changelogMem_;
 };
 
 } // namespace Xrpa
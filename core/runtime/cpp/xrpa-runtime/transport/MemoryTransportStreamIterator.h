@@ -19,10 +19,12 @@
 #include <xrpa-runtime/transport/MemoryTransportStream.h>
 #include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
 #include <xrpa-runtime/transport/TransportStreamAccessor.h>
+#include <xrpa-runtime/transport/TransportStreamSnapshot.h>
 #include <xrpa-runtime/utils/MemoryAccessor.h>
 #include <xrpa-runtime/utils/PlacedRingBuffer.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
 #include <xrpa-runtime/utils/XrpaUtils.h>
+#include <chrono>
 
 namespace Xrpa {
 
@@ -31,48 +33,144 @@ class MemoryTransportStreamIterator : public TransportStreamIterator {
   class MemoryTransportStreamIteratorData : public TransportStreamIteratorData {
    public:
     static constexpr int32_t TYPE_ID = 82001;
-    explicit MemoryTransportStreamIteratorData(PlacedRingBuffer* changelog)
-        : TransportStreamIteratorData(TYPE_ID), changelog_(changelog) {}
+    explicit MemoryTransportStreamIteratorData(
+        PlacedRingBuffer* changelog,
+        PlacedRingBufferIndex* changelogIndex = nullptr)
+        : TransportStreamIteratorData(TYPE_ID),
+          changelog_(changelog),
+          changelogIndex_(changelogIndex) {}
 
     PlacedRingBuffer* changelog_ = nullptr;
+
+    // only set for TransportConfig::changelogIndexCapacity streams
+    PlacedRingBufferIndex* changelogIndex_ = nullptr;
+
+    // only set for TransportConfig::snapshotByteCount streams
+    TransportStreamSnapshot* snapshot_ = nullptr;
   };
 
   explicit MemoryTransportStreamIterator(MemoryTransportStream* transportStream)
       : transportStream_(transportStream) {}
 
-  ~MemoryTransportStreamIterator() override = default;
+  ~MemoryTransportStreamIterator() override {
+    if (transportStream_->readIterator_ == this) {
+      transportStream_->readIterator_ = nullptr;
+    }
+    transportStream_->releaseReaderCursor(readerCursor_);
+  }
 
   bool needsProcessing() override {
     if (transportStream_->memBuffer_ == nullptr) {
       return false;
     }
 
+    // readers tick through here, so it doubles as the lossless reader liveness signal
+    transportStream_->refreshReaderCursor(readerCursor_);
+
     // lock-free check against the transport header
     MemoryTransportStreamAccessor streamAccessor{transportStream_->accessMemory()};
     return iter_.hasNext(streamAccessor.getLastChangelogID());
   }
 
+  bool waitForChanges(std::chrono::microseconds timeout) override {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (transportStream_->memBuffer_ != nullptr) {
+      // the notify word is the last changelog ID
+      MemoryTransportStreamAccessor streamAccessor{transportStream_->accessMemory()};
+      auto lastChangelogId = streamAccessor.getLastChangelogID();
+      if (iter_.hasNext(lastChangelogId)) {
+        return true;
+      }
+      auto notifyValue = static_cast<uint32_t>(lastChangelogId);
+      if (!transportStream_->waitForChangeNotify(notifyValue, deadline)) {
+        break;
+      }
+    }
+    return false;
+  }
+
   bool hasMissedEntries(TransportStreamAccessor* accessor) override {
     auto* iterData = accessor->getIteratorData<MemoryTransportStreamIteratorData>();
     if (iterData == nullptr) {
       return false;
     }
     auto* changelog = iterData->changelog_;
+    trackRead();
     if (iter_.hasMissedEntries(changelog)) {
       iter_.setToEnd(changelog);
+      iterData->missedEntries_++;
+      transportStream_->growChangelog(changelog);
       return true;
     }
     return false;
   }
 
   MemoryAccessor getNextEntry(TransportStreamAccessor* accessor) override {
-    auto* changelog = accessor->getIteratorData<MemoryTransportStreamIteratorData>()->changelog_;
-    return iter_.next(changelog);
+    auto* iterData = accessor->getIteratorData<MemoryTransportStreamIteratorData>();
+    MemoryAccessor entry;
+    if (snapshotReadOffset_ >= 0 && iterData->snapshot_ != nullptr) {
+      entry = iterData->snapshot_->readNext(snapshotReadOffset_);
+    }
+    if (entry.isNull()) {
+      snapshotReadOffset_ = -1;
+      entry = iter_.next(iterData->changelog_);
+      if (!entry.isNull()) {
+        // snapshot replays are left out, as their timestamps are the original write times
+        iterData->recordEventLatency(entry, accessor->getBaseTimestamp());
+        trackRead();
+      }
+    }
+    if (!entry.isNull()) {
+      iterData->eventsRead_++;
+      iterData->bytesRead_ += entry.getSize();
+    }
+    return entry;
+  }
+
+  bool resyncFromSnapshot(TransportStreamAccessor* accessor) override {
+    auto* iterData = accessor->getIteratorData<MemoryTransportStreamIteratorData>();
+    if (iterData == nullptr || iterData->snapshot_ == nullptr) {
+      return false;
+    }
+    auto* snapshot = iterData->snapshot_;
+    if (!snapshot->hasSnapshot()) {
+      return false;
+    }
+    if (!iter_.setToId(
+            iterData->changelog_, snapshot->getChangelogId(), iterData->changelogIndex_)) {
+      // the changelog has already evicted entries written after the snapshot
+      return false;
+    }
+    snapshotReadOffset_ = 0;
+    return true;
+  }
+
+  // no-op unless the stream has TransportConfig::losslessReaderCount cursors
+  void publishReaderCursor() {
+    transportStream_->updateReaderCursor(readerCursor_, iter_.getLastReadId());
   }
 
  private:
+  // the stream publishes the reader cursor once the transaction is done reading, rather than on
+  // every entry read
+  void trackRead() {
+    auto*& readIterator = transportStream_->readIterator_;
+    if (readIterator != this) {
+      if (readIterator != nullptr) {
+        // another iterator read earlier in the same transaction
+        readIterator->publishReaderCursor();
+      }
+      readIterator = this;
+    }
+  }
+
   MemoryTransportStream* transportStream_;
   PlacedRingBufferIterator iter_;
+
+  MemoryTransportStream::ReaderCursorHandle readerCursor_;
+
+  // read position within the snapshot while replaying it, -1 otherwise
+  int32_t snapshotReadOffset_ = -1;
 };
 
 } // namespace Xrpa
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/transport/SharedMemorySegment.h>
+
+#include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if defined(WIN32)
+#include <Windows.h>
+#ifdef TEXT
+#undef TEXT // undefine UE4 macro, if defined
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#elif defined(__APPLE__) || defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace Xrpa {
+
+static constexpr int DIRECTORY_LOCK_TIMEOUT_MS = 5000;
+
+static int32_t alignRegionOffset(int32_t offset) {
+  return (offset + SharedMemorySegment::REGION_ALIGNMENT - 1) &
+      ~(SharedMemorySegment::REGION_ALIGNMENT - 1);
+}
+
+static std::string formatSegmentName(const std::string& baseName) {
+  std::stringstream ss;
+  ss << baseName << "_seg_v" << std::hex << MemoryTransportStreamAccessor::TRANSPORT_VERSION;
+  return ss.str();
+}
+
+// the name a stream is filed under in the directory: the stream name itself if it fits, otherwise
+// as much of it as fits followed by a hash of the whole name
+static std::string formatDirectoryName(const std::string& streamName) {
+  if (streamName.size() <= SharedMemorySegment::MAX_STREAM_NAME_LENGTH) {
+    return streamName;
+  }
+
+  // FNV-1a; 64 bits, as distinct streams must never collide
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : streamName) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+
+  std::stringstream ss;
+  ss << streamName.substr(0, SharedMemorySegment::MAX_STREAM_NAME_LENGTH - 17) << "#" << std::hex
+     << std::setfill('0') << std::setw(16) << hash;
+  return ss.str();
+}
+
+SharedMemorySegment::SharedMemorySegment(
+    const std::string& name,
+    int32_t byteCount,
+    int32_t maxStreams)
+    : name_(formatSegmentName(name)), mapSize_(byteCount) {
+  int32_t directoryEnd = sizeof(Header) + maxStreams * sizeof(DirectoryEntry);
+  if (maxStreams <= 0 || alignRegionOffset(directoryEnd) >= mapSize_) {
+    std::cerr << "SharedMemorySegment(" << name_ << "): too small for its directory\n"
+              << std::flush;
+    return;
+  }
+
+#if defined(WIN32)
+  mutex_ = createNamedInterprocessMutex(name_);
+
+  // open the shared memory file if it already exists, otherwise create it
+  memHandle_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name_.c_str());
+  if (memHandle_ == 0) {
+    memHandle_ =
+        CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, mapSize_, name_.c_str());
+  }
+
+  // if the create failed then it is possible we hit a race condition, so try opening it again
+  if (memHandle_ == 0) {
+    memHandle_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name_.c_str());
+  }
+
+  mapBuffer_ = (unsigned char*)MapViewOfFile(memHandle_, FILE_MAP_ALL_ACCESS, 0, 0, mapSize_);
+#elif defined(__APPLE__) || defined(__linux__)
+#if defined(__APPLE__)
+  // also creates /tmp/xrpa, which holds the segment file
+  mutex_ = createNamedInterprocessMutex(name_);
+  int fd = open(("/tmp/xrpa/" + name_).c_str(), O_RDWR | O_CREAT, 0666);
+#else
+  int fd = shm_open(("/" + name_).c_str(), O_RDWR | O_CREAT, 0666);
+#endif
+  if (fd == -1) {
+    perror("Error opening shared memory segment");
+  } else {
+    // new (or extended) memory reads as zeros, which is a valid unlocked mutex slot and an
+    // uninitialized header; never shrink a segment created with a larger size
+    struct stat st{};
+    fstat(fd, &st);
+    if (st.st_size < mapSize_) {
+      ftruncate(fd, mapSize_);
+    }
+
+    mapBuffer_ = (unsigned char*)mmap(NULL, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapBuffer_ == MAP_FAILED) {
+      perror("Error mapping shared memory segment");
+      mapBuffer_ = nullptr;
+    }
+
+    close(fd);
+  }
+
+#if defined(__linux__)
+  if (mapBuffer_ != nullptr) {
+    mutex_ = std::make_unique<RobustInterprocessMutex>(
+        name_, reinterpret_cast<Header*>(mapBuffer_)->lockSlot);
+  }
+#endif
+#endif
+
+  if (mapBuffer_ == nullptr || mutex_ == nullptr || !initializeHeader(maxStreams)) {
+    shutdown();
+  }
+}
+
+SharedMemorySegment::~SharedMemorySegment() {
+  shutdown();
+}
+
+bool SharedMemorySegment::initializeHeader(int32_t maxStreams) {
+  auto* header = reinterpret_cast<Header*>(mapBuffer_);
+  bool isCompatible = false;
+  bool didLock = mutex_->lockAndExecute(DIRECTORY_LOCK_TIMEOUT_MS, [&]() {
+    if (header->magic != MAGIC) {
+      // the directory entries are already zeroed
+      header->segmentByteCount = mapSize_;
+      header->maxStreams = maxStreams;
+      header->streamCount = 0;
+      header->nextFreeOffset =
+          alignRegionOffset(sizeof(Header) + maxStreams * sizeof(DirectoryEntry));
+      header->magic = MAGIC;
+    }
+    isCompatible = header->segmentByteCount == mapSize_ && header->maxStreams == maxStreams;
+  });
+
+  if (!didLock || !isCompatible) {
+    std::cerr << "SharedMemorySegment(" << name_
+              << "): segment is in use with a different size or directory size\n"
+              << std::flush;
+    return false;
+  }
+
+  header_ = header;
+  return true;
+}
+
+void SharedMemorySegment::shutdown() {
+  header_ = nullptr;
+
+#if defined(__linux__)
+  if (mutex_ != nullptr) {
+    // the mutex is about to be unmapped
+    mutex_->dispose();
+    mutex_ = nullptr;
+  }
+#endif
+
+#if defined(WIN32)
+  if (mapBuffer_ != nullptr) {
+    UnmapViewOfFile(mapBuffer_);
+    mapBuffer_ = nullptr;
+  }
+
+  if (memHandle_ != 0) {
+    CloseHandle(memHandle_);
+    memHandle_ = 0;
+  }
+#elif defined(__APPLE__) || defined(__linux__)
+  if (mapBuffer_ != nullptr) {
+    munmap(mapBuffer_, mapSize_);
+    mapBuffer_ = nullptr;
+  }
+#endif
+}
+
+bool SharedMemorySegment::acquireRegion(
+    const std::string& streamName,
+    int32_t byteCount,
+    const std::function<void(const Region&)>& func) {
+  if (header_ == nullptr) {
+    return false;
+  }
+  auto directoryName = formatDirectoryName(streamName);
+
+  bool didAcquire = false;
+  mutex_->lockAndExecute(DIRECTORY_LOCK_TIMEOUT_MS, [&]() {
+    auto* directory = getDirectory();
+
+    DirectoryEntry* entry = nullptr;
+    for (int32_t i = 0; i < header_->streamCount; ++i) {
+      if (std::strncmp(directory[i].name, directoryName.c_str(), sizeof(DirectoryEntry::name)) ==
+          0) {
+        entry = &directory[i];
+        break;
+      }
+    }
+
+    bool didCreate = false;
+    if (entry == nullptr) {
+      auto offset = header_->nextFreeOffset;
+      if (header_->streamCount >= header_->maxStreams || byteCount > mapSize_ - offset) {
+        std::cerr << "SharedMemorySegment(" << name_ << "): no room for stream " << streamName
+                  << "\n"
+                  << std::flush;
+        return;
+      }
+
+      entry = &directory[header_->streamCount];
+      std::memset(entry->lockSlot, 0, sizeof(DirectoryEntry::lockSlot));
+      entry->changeWaiterCount = 0;
+      entry->offset = offset;
+      entry->byteCount = byteCount;
+      std::memset(entry->name, 0, sizeof(DirectoryEntry::name));
+      std::memcpy(entry->name, directoryName.data(), directoryName.size());
+
+      header_->streamCount++;
+      header_->nextFreeOffset = alignRegionOffset(offset + byteCount);
+      didCreate = true;
+    } else if (entry->byteCount != byteCount) {
+      std::cerr << "SharedMemorySegment(" << name_ << "): stream " << streamName
+                << " is in use with a different size\n"
+                << std::flush;
+      return;
+    }
+
+    func(
+        {mapBuffer_ + entry->offset,
+         entry->byteCount,
+         entry->lockSlot,
+         &entry->changeWaiterCount,
+         didCreate});
+    didAcquire = true;
+  });
+  return didAcquire;
+}
+
+int32_t SharedMemorySegment::getStreamCount() {
+  int32_t streamCount = 0;
+  if (header_ != nullptr) {
+    mutex_->lockAndExecute(
+        DIRECTORY_LOCK_TIMEOUT_MS, [&]() { streamCount = header_->streamCount; });
+  }
+  return streamCount;
+}
+
+int32_t SharedMemorySegment::getFreeByteCount() {
+  int32_t freeByteCount = 0;
+  if (header_ != nullptr) {
+    mutex_->lockAndExecute(DIRECTORY_LOCK_TIMEOUT_MS, [&]() {
+      freeByteCount = std::max(0, mapSize_ - header_->nextFreeOffset);
+    });
+  }
+  return freeByteCount;
+}
+
+int32_t SharedMemorySegment::flush([[maybe_unused]] const unsigned char* start, int32_t byteCount) {
+  if (mapBuffer_ == nullptr || byteCount <= 0) {
+    return 0;
+  }
+
+#if defined(WIN32) || defined(__APPLE__)
+  // the platform flushes require page-aligned addresses; the mapping itself is page-aligned
+#if defined(WIN32)
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  auto pageSize = static_cast<int32_t>(systemInfo.dwPageSize);
+#else
+  auto pageSize = static_cast<int32_t>(sysconf(_SC_PAGESIZE));
+#endif
+  auto startOffset = static_cast<int32_t>(start - mapBuffer_);
+  auto alignedStart = (startOffset / pageSize) * pageSize;
+  auto alignedEnd =
+      std::min(mapSize_, ((startOffset + byteCount + pageSize - 1) / pageSize) * pageSize);
+  auto alignedByteCount = alignedEnd - alignedStart;
+
+#if defined(WIN32)
+  if (!FlushViewOfFile(mapBuffer_ + alignedStart, alignedByteCount)) {
+    std::cerr << "[XRPA_DEBUG_MSYNC] FlushViewOfFile failed with error: " << GetLastError() << "\n"
+              << std::flush;
+  }
+#else
+  if (msync(mapBuffer_ + alignedStart, alignedByteCount, MS_SYNC) != 0) {
+    std::cerr << "[XRPA_DEBUG_MSYNC] msync failed with error: " << strerror(errno) << "\n"
+              << std::flush;
+  }
+#endif
+  return alignedByteCount;
+#else
+  // no-op: the shm_open() mapping is tmpfs-backed and MAP_SHARED, so writes are immediately
+  // visible to every other process mapping it
+  return 0;
+#endif
+}
+
+} // namespace Xrpa
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/transport/InterprocessMutex.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Xrpa {
+
+// One named shared memory mapping that holds the memory of many transport streams, so that a
+// process attached to dozens of data stores pays for a single mapping (and, on Linux, no lock
+// files) instead of one per stream. The segment starts with a header and a fixed-size directory
+// table; each directory entry names a stream and locates its region. Regions are allocated on
+// first use and are never freed, so every process using the segment must agree on its size.
+//
+// Layout:
+//   [Header, 128 bytes][DirectoryEntry x maxStreams, 128 bytes each][stream regions...]
+class SharedMemorySegment {
+ public:
+  static constexpr uint32_t MAGIC = 0x47535258; // "XRSG"
+  static constexpr int32_t DEFAULT_MAX_STREAMS = 64;
+  // stream regions start on a cache line, so that streams never share one
+  static constexpr int32_t REGION_ALIGNMENT = 64;
+  // longer stream names are filed under a prefix of the name plus a hash of all of it
+  static constexpr int32_t MAX_STREAM_NAME_LENGTH = 51;
+
+  struct Header {
+    // RobustInterprocessMutex guarding the directory, on Linux
+    alignas(8) uint8_t lockSlot[ROBUST_MUTEX_SLOT_SIZE];
+    uint32_t magic;
+    int32_t segmentByteCount;
+    int32_t maxStreams;
+    int32_t streamCount;
+    int32_t nextFreeOffset;
+    uint8_t reserved[44];
+  };
+
+  // two full cache lines, so that lock traffic on one stream does not contend with another
+  struct DirectoryEntry {
+    // RobustInterprocessMutex of the stream, on Linux
+    alignas(8) uint8_t lockSlot[ROBUST_MUTEX_SLOT_SIZE];
+    int32_t offset;
+    int32_t byteCount;
+    // threads sleeping on a change notification of the stream, on Linux
+    uint32_t changeWaiterCount;
+    char name[MAX_STREAM_NAME_LENGTH + 1];
+  };
+
+  static_assert(sizeof(Header) == 128);
+  static_assert(sizeof(DirectoryEntry) == 128);
+
+  struct Region {
+    unsigned char* memBuffer;
+    int32_t byteCount;
+    void* lockSlot;
+    volatile uint32_t* changeWaiterCount;
+    // true if the region was allocated by this call, and so must be initialized by the caller
+    bool didCreate;
+  };
+
+  SharedMemorySegment(
+      const std::string& name,
+      int32_t byteCount,
+      int32_t maxStreams = DEFAULT_MAX_STREAMS);
+  ~SharedMemorySegment();
+
+  [[nodiscard]] bool isValid() const {
+    return header_ != nullptr;
+  }
+
+  [[nodiscard]] const std::string& getName() const {
+    return name_;
+  }
+
+  // Finds the region of the named stream, allocating it if no process has yet, and runs func with
+  // it while holding the directory lock, so that a newly allocated region is initialized before
+  // any other process can find it. Returns false without calling func if the segment is full, or
+  // if the stream exists with a different size.
+  bool acquireRegion(
+      const std::string& streamName,
+      int32_t byteCount,
+      const std::function<void(const Region&)>& func);
+
+  [[nodiscard]] int32_t getStreamCount();
+
+  // bytes still available for stream regions
+  [[nodiscard]] int32_t getFreeByteCount();
+
+  // makes a range of the segment written by a transaction visible to other processes; returns
+  // the number of bytes handed to the platform flush
+  int32_t flush(const unsigned char* start, int32_t byteCount);
+
+ private:
+  bool initializeHeader(int32_t maxStreams);
+  void shutdown();
+
+  [[nodiscard]] DirectoryEntry* getDirectory() const {
+    return reinterpret_cast<DirectoryEntry*>(mapBuffer_ + sizeof(Header));
+  }
+
+  std::string name_;
+  int32_t mapSize_ = 0;
+  unsigned char* mapBuffer_ = nullptr;
+  Header* header_ = nullptr;
+  std::unique_ptr<InterprocessMutex> mutex_;
+
+#if defined(WIN32)
+  void* memHandle_ = nullptr;
+#endif
+};
+
+} // namespace Xrpa
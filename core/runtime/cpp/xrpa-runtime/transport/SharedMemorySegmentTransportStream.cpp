@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/transport/SharedMemorySegmentTransportStream.h>
+
+#include <xrpa-runtime/transport/SharedMemoryTransportStream.h>
+
+namespace Xrpa {
+
+SharedMemorySegmentTransportStream::SharedMemorySegmentTransportStream(
+    std::shared_ptr<SharedMemorySegment> segment,
+    const std::string& name,
+    const TransportConfig& config)
+#if defined(__linux__)
+    // the robust mutex lives in the segment directory, so the mutex is created once it is found
+    : MemoryTransportStream(formatSharedMemoryName(name, config), config, nullptr),
+#else
+    : MemoryTransportStream(formatSharedMemoryName(name, config), config),
+#endif
+      segment_(std::move(segment)) {
+  if (segment_ == nullptr) {
+    return;
+  }
+
+  bool didInitialize = false;
+  segment_->acquireRegion(name_, memSize_, [&](const SharedMemorySegment::Region& region) {
+    memBuffer_ = region.memBuffer;
+#if defined(__linux__)
+    mutex_ = std::make_unique<RobustInterprocessMutex>(name_, region.lockSlot);
+    changeWaiterCount_ = region.changeWaiterCount;
+#endif
+    // under the directory lock, so no other process sees the region before it is initialized
+    didInitialize = initializeMemory(region.didCreate);
+  });
+
+  if (!didInitialize) {
+    shutdown();
+  }
+}
+
+SharedMemorySegmentTransportStream::~SharedMemorySegmentTransportStream() {
+  shutdown();
+}
+
+void SharedMemorySegmentTransportStream::shutdown() {
+  releaseLockFreeWriter();
+
+#if defined(__linux__)
+  if (mutex_ != nullptr) {
+    // the mutex is unmapped along with the segment
+    mutex_->dispose();
+    mutex_ = nullptr;
+  }
+  changeWaiterCount_ = nullptr;
+#endif
+  memBuffer_ = nullptr;
+}
+
+void SharedMemorySegmentTransportStream::flushWrites() {
+  if (memBuffer_ == nullptr) {
+    return;
+  }
+
+  // the segment aligns each range to the pages of the whole mapping
+  coalesceDirtyRanges(1);
+  for (auto& range : dirtyRanges_) {
+    bytesFlushed_ += segment_->flush(memBuffer_ + range.start_, range.end_ - range.start_);
+  }
+}
+
+} // namespace Xrpa
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/transport/MemoryTransportStream.h>
+#include <xrpa-runtime/transport/SharedMemorySegment.h>
+#include <memory>
+
+namespace Xrpa {
+
+// A transport stream whose memory is a region of a SharedMemorySegment, rather than a mapping of
+// its own. Interoperates only with streams of the same name opened through a segment of the same
+// name; on Linux its mutex lives in the segment directory, so it needs no lock file either.
+class SharedMemorySegmentTransportStream : public MemoryTransportStream {
+ public:
+  SharedMemorySegmentTransportStream(
+      std::shared_ptr<SharedMemorySegment> segment,
+      const std::string& name,
+      const TransportConfig& config);
+  ~SharedMemorySegmentTransportStream() override;
+
+ protected:
+  void flushWrites() override;
+
+ private:
+  void shutdown();
+
+  // keeps the mapping alive for as long as the stream uses it
+  std::shared_ptr<SharedMemorySegment> segment_;
+};
+
+} // namespace Xrpa
@@ -21,6 +21,7 @@
 #include <sstream>
 
 #include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
+#include <xrpa-runtime/utils/MirroredMapping.h>
 
 #if defined(WIN32)
 #include <Windows.h>
@@ -32,29 +33,70 @@
 #define WIN32_LEAN_AND_MEAN
 #endif
 
-#elif defined(__APPLE__)
+#elif defined(__APPLE__) || defined(__linux__)
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <cerrno>
+#include <cstring>
 #endif
 
 namespace Xrpa {
 
+#if defined(__APPLE__) || defined(__linux__)
+// Memory in use by a process configured with a different layout must not be mapped, nor resized
+// out from under that process.
+static bool checkExistingSize(bool didCreate, off_t existingSize, int32_t expectedSize) {
+  if (didCreate || existingSize == expectedSize) {
+    return true;
+  }
+  std::cerr << "SharedMemoryTransportStream: existing shared memory is " << existingSize
+            << " bytes rather than " << expectedSize << ", memory layout mismatch\n"
+            << std::flush;
+  return false;
+}
+#endif
+
+static uint32_t hashLockDomainName(const std::string& lockDomain) {
+  // FNV-1a, keeping the shared memory name short
+  uint32_t hash = 2166136261u;
+  for (char c : lockDomain) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return hash;
+}
+
 std::string formatSharedMemoryName(const std::string& baseName, const TransportConfig& config) {
   auto hashPrefix = static_cast<uint32_t>(config.schemaHash.value0 & 0xFFFFFFFF);
 
   std::stringstream ss;
   ss << baseName << "_v" << std::hex << MemoryTransportStreamAccessor::TRANSPORT_VERSION << "_"
      << std::setfill('0') << std::setw(8) << hashPrefix;
+  if (config.lockFree) {
+    // the changelog format differs, so never share memory with a locking stream
+    ss << "_lf";
+  }
+  if (MemoryTransportStreamAccessor::hasExtendedLayout(config)) {
+    // the memory layout differs, so never share memory with a stream configured otherwise
+    ss << "_ly" << std::setw(8) << MemoryTransportStreamAccessor::getLayoutHash(config);
+  }
+  if (!config.lockDomain.empty() && !config.lockFree) {
+    // streams locked by a domain must never share memory with streams that lock on their own
+    ss << "_ld" << std::setw(8) << hashLockDomainName(config.lockDomain);
+  }
   return ss.str();
 }
 
 SharedMemoryTransportStream::SharedMemoryTransportStream(
     const std::string& name,
     const TransportConfig& config)
+#if defined(__linux__)
+    // the robust mutex lives in the mapping, so the mutex is created once it is mapped
+    : MemoryTransportStream(formatSharedMemoryName(name, config), config, nullptr) {
+#else
     : MemoryTransportStream(formatSharedMemoryName(name, config), config) {
+#endif
   bool didCreate = false;
 #if defined(WIN32)
   // open the shared memory file if it already exists
@@ -79,29 +121,119 @@ SharedMemoryTransportStream::SharedMemoryTransportStream(
 #elif defined(__APPLE__)
   std::string filePath = "/tmp/xrpa/" + name_;
   int fd = open(filePath.c_str(), O_RDWR | O_CREAT, 0666);
+  bool isSizeValid = false;
   if (fd != -1) {
     struct stat st{};
     fstat(fd, &st);
     didCreate = (st.st_size == 0);
+    if (!didCreate && st.st_size != memSize_ && isAbandoned(fd, st.st_size, 0)) {
+      didCreate = true;
+    }
     if (didCreate) {
       ftruncate(fd, memSize_);
     }
+    isSizeValid = checkExistingSize(didCreate, st.st_size, memSize_);
   }
 
   if (fd == -1) {
     perror("Error opening shared memory");
+  } else if (isSizeValid) {
+    // Map the shared memory segment into our address space
+    memBuffer_ = (unsigned char*)mmap(NULL, memSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memBuffer_ == MAP_FAILED) {
+      perror("Error mapping shared memory");
+      memBuffer_ = nullptr;
+    }
   }
 
-  // Set the size of the shared memory segment
-  ftruncate(fd, memSize_);
+  if (fd != -1) {
+    close(fd);
+  }
+#elif defined(__linux__)
+  // POSIX shared memory object, backed by tmpfs at /dev/shm/<name>; it must be named (rather than
+  // a memfd_create() fd) so that unrelated processes can rendezvous on it
+  std::string shmName = "/" + name_;
+  int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT, 0666);
+  if (fd == -1) {
+    perror("Error opening shared memory");
+  } else {
+    struct stat st{};
+    fstat(fd, &st);
+    didCreate = (st.st_size == 0);
+
+    // the mapping is prefixed by the lock region, ahead of the transport memory itself; a
+    // mirrored changelog has to start on a page boundary, so the lock region then takes a page
+    bool isMirrored = MemoryTransportStreamAccessor::hasMirroredChangelog(config);
+    lockRegionSize_ = isMirrored ? getMemoryPageSize() : LOCK_REGION_SIZE;
+    mapSize_ = lockRegionSize_ + memSize_;
+    bool isPrefaulted = (config.mappingFlags & MappingPrefault) != 0;
+
+    // The mirror is a second view of the changelog, so it takes no space in the file. If the
+    // creator cannot map the mirror, it sizes the file to hold the mirror region as plain memory
+    // instead, as on other platforms; the file size then tells attaching processes which layout
+    // to map.
+    auto mirrorByteCount =
+        isMirrored ? MemoryTransportStreamAccessor::getChangelogCapacity(config) : 0;
+    auto mirroredFileSize = mapSize_ - mirrorByteCount;
+    auto mirrorOffset =
+        lockRegionSize_ + MemoryTransportStreamAccessor::getChangelogPoolOffset(config);
+    bool isKnownSize = st.st_size == mapSize_ || (isMirrored && st.st_size == mirroredFileSize);
+    if (!didCreate && !isKnownSize && isAbandoned(fd, st.st_size, lockRegionSize_)) {
+      // left by an earlier run configured otherwise, which has since exited
+      didCreate = true;
+    }
+
+    if (isMirrored && (didCreate || st.st_size == mirroredFileSize)) {
+      if (didCreate) {
+        ftruncate(fd, mirroredFileSize);
+      }
+      mapBuffer_ =
+          mapFileWithMirror(fd, mirroredFileSize, mirrorOffset, mirrorByteCount, isPrefaulted);
+      if (mapBuffer_ == nullptr) {
+        if (didCreate) {
+          std::cout << "SharedMemoryTransportStream(" << name_
+                    << "): cannot map the changelog mirror, mapping it as plain memory\n"
+                    << std::flush;
+        } else {
+          // the creator mapped the mirror, so plain memory cannot be shared with it
+          std::cerr << "SharedMemoryTransportStream(" << name_
+                    << "): cannot map the changelog mirror\n"
+                    << std::flush;
+        }
+      }
+    }
 
-  // Map the shared memory segment into our address space
-  memBuffer_ = (unsigned char*)mmap(NULL, memSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-  if (memBuffer_ == MAP_FAILED) {
-    perror("Error mapping shared memory");
+    if (mapBuffer_ == nullptr && (didCreate || !isMirrored || st.st_size != mirroredFileSize)) {
+      if (didCreate) {
+        ftruncate(fd, mapSize_);
+      }
+      if (checkExistingSize(didCreate, st.st_size, mapSize_)) {
+        int mapFlags = MAP_SHARED;
+        if (isPrefaulted) {
+          mapFlags |= MAP_POPULATE;
+        }
+        mapBuffer_ =
+            (unsigned char*)mmap(NULL, mapSize_, PROT_READ | PROT_WRITE, mapFlags, fd, 0);
+        if (mapBuffer_ == MAP_FAILED) {
+          perror("Error mapping shared memory");
+          mapBuffer_ = nullptr;
+        }
+      }
+    }
+
+    close(fd);
   }
 
-  close(fd);
+  if (mapBuffer_ != nullptr) {
+    memBuffer_ = mapBuffer_ + lockRegionSize_;
+    mutex_ = std::make_unique<RobustInterprocessMutex>(name_, mapBuffer_);
+    changeWaiterCount_ = reinterpret_cast<volatile uint32_t*>(mapBuffer_ + ROBUST_MUTEX_SLOT_SIZE);
+    applyMappingFlags(mapBuffer_, mapSize_, config.mappingFlags & MappingPrefault);
+  }
+#endif
+
+#if defined(WIN32) || defined(__APPLE__)
+  applyMappingFlags(memBuffer_, memSize_);
 #endif
 
   if (!initializeMemory(didCreate)) {
@@ -109,11 +241,33 @@ SharedMemoryTransportStream::SharedMemoryTransportStream(
   }
 }
 
+#if defined(__APPLE__) || defined(__linux__)
+bool SharedMemoryTransportStream::isAbandoned(int fd, int64_t existingSize, int32_t headerOffset) {
+  auto byteCount = headerOffset + MemoryTransportStreamAccessor::BYTE_COUNT;
+  if (existingSize < byteCount) {
+    // too small to have ever been set up
+    return true;
+  }
+  void* mem = mmap(nullptr, byteCount, PROT_READ, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  auto headerMem = static_cast<unsigned char*>(mem) + headerOffset;
+  MemoryTransportStreamAccessor streamAccessor{
+      MemoryAccessor(headerMem, 0, MemoryTransportStreamAccessor::BYTE_COUNT)};
+  bool isExpired = isTransportExpired(streamAccessor);
+  munmap(mem, byteCount);
+  return isExpired;
+}
+#endif
+
 SharedMemoryTransportStream::~SharedMemoryTransportStream() {
   shutdown();
 }
 
 void SharedMemoryTransportStream::shutdown() {
+  releaseLockFreeWriter();
+
 #if defined(WIN32)
   if (memBuffer_ != nullptr) {
     UnmapViewOfFile(memBuffer_);
@@ -129,28 +283,60 @@ void SharedMemoryTransportStream::shutdown() {
     munmap(memBuffer_, memSize_);
     memBuffer_ = nullptr;
   }
+#elif defined(__linux__)
+  if (mutex_ != nullptr) {
+    // the mutex is about to be unmapped
+    mutex_->dispose();
+    mutex_ = nullptr;
+  }
+  changeWaiterCount_ = nullptr;
+
+  memBuffer_ = nullptr;
+  if (mapBuffer_ != nullptr) {
+    munmap(mapBuffer_, mapSize_);
+    mapBuffer_ = nullptr;
+  }
 #endif
 }
 
 void SharedMemoryTransportStream::flushWrites() {
-  // Force memory synchronization to ensure writes are visible to other processes
+  // Force memory synchronization to ensure writes are visible to other processes. Only the pages
+  // touched by the transaction are flushed, rather than the whole (possibly multi-megabyte) view.
 #if defined(WIN32)
   if (memBuffer_ != nullptr) {
-    // FlushViewOfFile ensures writes are flushed to disk/shared memory
-    if (!FlushViewOfFile(memBuffer_, memSize_)) {
-      std::cerr << "[XRPA_DEBUG_MSYNC] FlushViewOfFile failed with error: " << GetLastError()
-                << "\n"
-                << std::flush;
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    coalesceDirtyRanges(static_cast<int32_t>(systemInfo.dwPageSize));
+
+    for (auto& range : dirtyRanges_) {
+      // FlushViewOfFile ensures writes are flushed to disk/shared memory
+      auto byteCount = range.end_ - range.start_;
+      if (!FlushViewOfFile(memBuffer_ + range.start_, byteCount)) {
+        std::cerr << "[XRPA_DEBUG_MSYNC] FlushViewOfFile failed with error: " << GetLastError()
+                  << "\n"
+                  << std::flush;
+      }
+      bytesFlushed_ += byteCount;
     }
   }
 #elif defined(__APPLE__)
   if (memBuffer_ != nullptr) {
-    // MS_SYNC (from sys/mman.h) = synchronous flush
-    if (msync(memBuffer_, memSize_, MS_SYNC) != 0) {
-      std::cerr << "[XRPA_DEBUG_MSYNC] msync failed with error: " << strerror(errno) << "\n"
-                << std::flush;
+    // msync() requires page-aligned addresses; the mapping itself is page-aligned
+    coalesceDirtyRanges(static_cast<int32_t>(sysconf(_SC_PAGESIZE)));
+
+    for (auto& range : dirtyRanges_) {
+      // MS_SYNC (from sys/mman.h) = synchronous flush
+      auto byteCount = range.end_ - range.start_;
+      if (msync(memBuffer_ + range.start_, byteCount, MS_SYNC) != 0) {
+        std::cerr << "[XRPA_DEBUG_MSYNC] msync failed with error: " << strerror(errno) << "\n"
+                  << std::flush;
+      }
+      bytesFlushed_ += byteCount;
     }
   }
+#elif defined(__linux__)
+  // no-op: the shm_open() mapping is tmpfs-backed and MAP_SHARED, so writes are immediately
+  // visible to every other process mapping it and there is no backing file to sync
 #endif
 }
 
@@ -20,6 +20,10 @@
 
 namespace Xrpa {
 
+// the name of the shared memory backing a stream; streams whose memory layout or locking differ
+// get different names, so they never attach to each other's memory
+std::string formatSharedMemoryName(const std::string& baseName, const TransportConfig& config);
+
 class SharedMemoryTransportStream : public MemoryTransportStream {
  public:
   SharedMemoryTransportStream(const std::string& name, const TransportConfig& config);
@@ -31,8 +35,21 @@ class SharedMemoryTransportStream : public MemoryTransportStream {
  private:
   void shutdown();
 
+#if defined(__APPLE__) || defined(__linux__)
+  // Whether memory of a different size than expected was left behind by a process that is gone,
+  // so that it can be resized and set up afresh. headerOffset locates the transport header.
+  static bool isAbandoned(int fd, int64_t existingSize, int32_t headerOffset);
+#endif
+
 #if defined(WIN32)
   void* memHandle_ = nullptr;
+#elif defined(__linux__)
+  // holds the RobustInterprocessMutex, then the change waiter count on a cache line of its own
+  static constexpr int32_t LOCK_REGION_SIZE = ROBUST_MUTEX_SLOT_SIZE + 64;
+
+  unsigned char* mapBuffer_ = nullptr;
+  int32_t mapSize_ = 0;
+  int32_t lockRegionSize_ = LOCK_REGION_SIZE;
 #endif
 };
 
@@ -0,0 +1,814 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/transport/SocketTransportStream.h>
+
+#include <xrpa-runtime/transport/MemoryTransportStreamAccessor.h>
+#include <xrpa-runtime/utils/PlacedRingBuffer.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace Xrpa {
+
+using namespace std::chrono_literals;
+
+static constexpr uint32_t FRAME_MAGIC = 0x4b535258; // "XRSK"
+static constexpr int32_t MAX_FRAME_PAYLOAD = 64 << 20;
+static constexpr auto RECONNECT_INTERVAL = 100ms;
+static constexpr auto SEND_TIMEOUT = 100ms;
+static constexpr auto APPLY_TIMEOUT = 5ms;
+
+enum SocketFrameType : int32_t {
+  Hello = 1,
+  Changes = 2,
+  // the sender lost change events before it could send them
+  Resync = 3,
+};
+
+// followed by payloadByteCount bytes: for Hello, the transport version and schema hash; for
+// Changes, eventCount change events, each prefixed by its int32 byte count
+struct SocketFrameHeader {
+  uint32_t magic;
+  int32_t frameType;
+  int32_t eventCount;
+  int32_t payloadByteCount;
+  // the sender's transport base timestamp, which the event timestamps are relative to
+  uint64_t baseTimestampUs;
+};
+static_assert(sizeof(SocketFrameHeader) == 24, "SocketFrameHeader layout");
+
+static constexpr int32_t HELLO_PAYLOAD_SIZE = 8 + sizeof(HashValue);
+
+struct SocketAddressParts {
+  bool isUnix = false;
+  std::string path;
+  std::string host;
+  std::string port;
+};
+
+static bool parseSocketAddress(const std::string& address, SocketAddressParts& parts) {
+  if (address.rfind("unix:", 0) == 0) {
+    parts.isUnix = true;
+    parts.path = address.substr(5);
+    return !parts.path.empty();
+  }
+  if (address.rfind("tcp:", 0) == 0) {
+    auto portPos = address.rfind(':');
+    if (portPos <= 4) {
+      return false;
+    }
+    parts.host = address.substr(4, portPos - 4);
+    parts.port = address.substr(portPos + 1);
+    return !parts.host.empty() && !parts.port.empty();
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// platform socket calls; file descriptors are -1 when closed
+
+#if defined(__APPLE__) || defined(__linux__)
+
+static void configureSocket(int fd, bool isTcp) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  int enable = 1;
+  if (isTcp) {
+    // change frames are already batched, so do not hold them back
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  }
+#if defined(__APPLE__)
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+}
+
+static bool makeUnixAddress(const std::string& path, sockaddr_un& addr) {
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+static addrinfo* resolveTcpAddress(const SocketAddressParts& parts, bool isPassive) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_NUMERICSERV | (isPassive ? AI_PASSIVE : 0);
+  addrinfo* result = nullptr;
+  if (getaddrinfo(parts.host.c_str(), parts.port.c_str(), &hints, &result) != 0) {
+    return nullptr;
+  }
+  return result;
+}
+
+// boundPort is set to the port actually bound, for tcp listeners
+static int openListenSocket(const SocketAddressParts& parts, std::string& boundPort) {
+  int fd = -1;
+  if (parts.isUnix) {
+    sockaddr_un addr{};
+    if (!makeUnixAddress(parts.path, addr)) {
+      return -1;
+    }
+    // a stale socket file left by a previous listener would fail the bind
+    unlink(parts.path.c_str());
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  } else {
+    auto* addrList = resolveTcpAddress(parts, true);
+    for (auto* ai = addrList; ai != nullptr && fd < 0; ai = ai->ai_next) {
+      fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (fd < 0) {
+        continue;
+      }
+      int enable = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+      if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+      }
+    }
+    if (addrList != nullptr) {
+      freeaddrinfo(addrList);
+    }
+    if (fd >= 0) {
+      sockaddr_storage addr{};
+      socklen_t addrLen = sizeof(addr);
+      getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addrLen);
+      auto port = addr.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port
+                                             : reinterpret_cast<sockaddr_in*>(&addr)->sin_port;
+      boundPort = std::to_string(ntohs(port));
+    }
+  }
+
+  if (fd >= 0 && listen(fd, 4) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  if (fd >= 0) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  }
+  return fd;
+}
+
+// non-blocking connect; inProgress is set if the connection completes later
+static int openConnectSocket(const SocketAddressParts& parts, bool& inProgress) {
+  inProgress = false;
+  int fd = -1;
+  int result = -1;
+  if (parts.isUnix) {
+    sockaddr_un addr{};
+    if (!makeUnixAddress(parts.path, addr)) {
+      return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0) {
+      configureSocket(fd, false);
+      result = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+  } else {
+    auto* addrList = resolveTcpAddress(parts, false);
+    if (addrList != nullptr) {
+      fd = socket(addrList->ai_family, addrList->ai_socktype, addrList->ai_protocol);
+      if (fd >= 0) {
+        configureSocket(fd, true);
+        result = connect(fd, addrList->ai_addr, addrList->ai_addrlen);
+      }
+      freeaddrinfo(addrList);
+    }
+  }
+
+  if (fd >= 0 && result != 0) {
+    if (errno == EINPROGRESS) {
+      inProgress = true;
+    } else {
+      close(fd);
+      fd = -1;
+    }
+  }
+  return fd;
+}
+
+static int acceptSocket(int listenFd, bool isTcp) {
+  int fd = accept(listenFd, nullptr, nullptr);
+  if (fd >= 0) {
+    configureSocket(fd, isTcp);
+  }
+  return fd;
+}
+
+// 1 once connected, 0 while still connecting, -1 if the connection failed
+static int getConnectResult(int fd) {
+  pollfd pfd{fd, POLLOUT, 0};
+  if (poll(&pfd, 1, 0) <= 0) {
+    return 0;
+  }
+  int error = 0;
+  socklen_t errorLen = sizeof(error);
+  getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLen);
+  return error == 0 ? 1 : -1;
+}
+
+static void closeSocketFd(int fd) {
+  close(fd);
+}
+
+static bool sendSegments(int fd, const std::vector<std::pair<const void*, size_t>>& segments) {
+  constexpr int MAX_IOV = 64;
+  iovec iov[MAX_IOV];
+  size_t segIndex = 0;
+  size_t segOffset = 0;
+  auto deadline = std::chrono::steady_clock::now() + SEND_TIMEOUT;
+
+  while (segIndex < segments.size()) {
+    int iovCount = 0;
+    for (size_t i = segIndex; i < segments.size() && iovCount < MAX_IOV; ++i, ++iovCount) {
+      auto skip = i == segIndex ? segOffset : 0;
+      iov[iovCount].iov_base =
+          const_cast<uint8_t*>(static_cast<const uint8_t*>(segments[i].first) + skip);
+      iov[iovCount].iov_len = segments[i].second - skip;
+    }
+
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovCount;
+#if defined(__linux__)
+    auto sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+#else
+    auto sent = sendmsg(fd, &msg, 0);
+#endif
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      pollfd pfd{fd, POLLOUT, 0};
+      if (remaining.count() <= 0 || poll(&pfd, 1, static_cast<int>(remaining.count())) <= 0) {
+        return false;
+      }
+      continue;
+    }
+
+    auto remainingSent = static_cast<size_t>(sent);
+    while (remainingSent > 0) {
+      auto segRemaining = segments[segIndex].second - segOffset;
+      if (remainingSent < segRemaining) {
+        segOffset += remainingSent;
+        break;
+      }
+      remainingSent -= segRemaining;
+      ++segIndex;
+      segOffset = 0;
+    }
+  }
+  return true;
+}
+
+// bytes read, 0 if the peer closed the connection, -1 if nothing is available, -2 on error
+static int64_t receiveBytes(int fd, void* buffer, size_t byteCount) {
+  while (true) {
+    auto received = recv(fd, buffer, byteCount, 0);
+    if (received >= 0) {
+      return received;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK ? -1 : -2;
+  }
+}
+
+// waits for the socket to become readable, or writable while connecting, or for the listen socket
+// to have a connection to accept; fds of -1 are skipped
+static void pollSockets(
+    int socketFd,
+    bool isConnecting,
+    int listenFd,
+    std::chrono::steady_clock::time_point deadline) {
+  auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  if (remaining.count() <= 0) {
+    return;
+  }
+  pollfd pfds[2];
+  nfds_t count = 0;
+  if (socketFd >= 0) {
+    pfds[count++] = {socketFd, static_cast<short>(isConnecting ? POLLOUT : POLLIN), 0};
+  }
+  if (listenFd >= 0) {
+    pfds[count++] = {listenFd, POLLIN, 0};
+  }
+  if (count == 0) {
+    std::this_thread::sleep_until(deadline);
+    return;
+  }
+  poll(pfds, count, static_cast<int>(remaining.count()));
+}
+
+#else
+
+static int openListenSocket(const SocketAddressParts& /*parts*/, std::string& /*boundPort*/) {
+  return -1;
+}
+
+static int openConnectSocket(const SocketAddressParts& /*parts*/, bool& inProgress) {
+  inProgress = false;
+  return -1;
+}
+
+static int acceptSocket(int /*listenFd*/, bool /*isTcp*/) {
+  return -1;
+}
+
+static int getConnectResult(int /*fd*/) {
+  return -1;
+}
+
+static void closeSocketFd(int /*fd*/) {}
+
+static bool sendSegments(int /*fd*/, const std::vector<std::pair<const void*, size_t>>&) {
+  return false;
+}
+
+static int64_t receiveBytes(int /*fd*/, void* /*buffer*/, size_t /*byteCount*/) {
+  return -2;
+}
+
+static void pollSockets(int, bool, int, std::chrono::steady_clock::time_point deadline) {
+  std::this_thread::sleep_until(deadline);
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+class SocketTransportStreamIterator : public TransportStreamIterator {
+ public:
+  SocketTransportStreamIterator(
+      SocketTransportStream* transportStream,
+      std::unique_ptr<TransportStreamIterator> memoryIter)
+      : transportStream_(transportStream),
+        memoryIter_(std::move(memoryIter)),
+        seenEpoch_(transportStream->getResyncEpoch()) {}
+
+  bool needsProcessing() override {
+    transportStream_->serviceSocket();
+    return transportStream_->getResyncEpoch() != seenEpoch_ ||
+        memoryIter_->needsProcessing();
+  }
+
+  bool waitForChanges(std::chrono::microseconds timeout) override {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!needsProcessing()) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return false;
+      }
+      transportStream_->waitForSocketActivity(deadline);
+    }
+    return true;
+  }
+
+  bool hasMissedEntries(TransportStreamAccessor* accessor) override {
+    // the peer may have written changes that were never sent
+    auto epoch = transportStream_->getResyncEpoch();
+    bool didReconnect = epoch != seenEpoch_;
+    seenEpoch_ = epoch;
+    return memoryIter_->hasMissedEntries(accessor) || didReconnect;
+  }
+
+  MemoryAccessor getNextEntry(TransportStreamAccessor* accessor) override {
+    return memoryIter_->getNextEntry(accessor);
+  }
+
+  // resyncFromSnapshot() keeps the default: the local snapshot is not the peer's
+
+ private:
+  SocketTransportStream* transportStream_;
+  std::unique_ptr<TransportStreamIterator> memoryIter_;
+  uint32_t seenEpoch_;
+};
+
+static TransportConfig toSocketTransportConfig(const TransportConfig& config) {
+  // the sender walks its changelog by ID, which lock-free changelogs do not support
+  TransportConfig socketConfig = config;
+  socketConfig.lockFree = false;
+  return socketConfig;
+}
+
+SocketTransportStream::SocketTransportStream(
+    const std::string& name,
+    const TransportConfig& config,
+    const std::string& address,
+    SocketRole role)
+    : HeapMemoryTransportStream(name, toSocketTransportConfig(config)),
+      address_(address),
+      role_(role) {
+  SocketAddressParts parts;
+  if (!parseSocketAddress(address_, parts)) {
+    std::cerr << "SocketTransportStream(" << name_ << "): invalid address " << address_ << "\n"
+              << std::flush;
+  }
+  if (role_ == SocketRole::Listen) {
+    std::lock_guard<std::mutex> lock(socketMutex_);
+    openListener();
+  }
+}
+
+SocketTransportStream::~SocketTransportStream() {
+  std::lock_guard<std::mutex> lock(socketMutex_);
+  closeSocket();
+  if (listenFd_ >= 0) {
+    closeSocketFd(listenFd_);
+    listenFd_ = -1;
+    SocketAddressParts parts;
+    if (parseSocketAddress(address_, parts) && parts.isUnix) {
+#if defined(__APPLE__) || defined(__linux__)
+      unlink(parts.path.c_str());
+#endif
+    }
+  }
+}
+
+bool SocketTransportStream::transact(
+    std::chrono::milliseconds timeout,
+    std::function<void(TransportStreamAccessor*)> func) {
+  serviceSocket();
+
+  return MemoryTransportStream::transact(timeout, [&](TransportStreamAccessor* accessor) {
+    MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+    auto startId = streamAccessor.getChangelog(config_)->getMaxID();
+    func(accessor);
+    if (streamAccessor.getChangelog(config_)->getMaxID() != startId) {
+      // sent while the transport lock is held, straight out of the changelog
+      sendChanges(startId, accessor->getBaseTimestamp());
+    }
+  });
+}
+
+std::unique_ptr<TransportStreamIterator> SocketTransportStream::createIterator() {
+  return std::make_unique<SocketTransportStreamIterator>(
+      this, HeapMemoryTransportStream::createIterator());
+}
+
+bool SocketTransportStream::isConnected() {
+  std::lock_guard<std::mutex> lock(socketMutex_);
+  return socketFd_ >= 0 && !isConnecting_ && peerReady_;
+}
+
+bool SocketTransportStream::waitForConnection(std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    serviceSocket();
+    if (isConnected()) {
+      return true;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    waitForSocketActivity(deadline);
+  }
+}
+
+void SocketTransportStream::disconnect() {
+  std::lock_guard<std::mutex> lock(socketMutex_);
+  closeSocket();
+}
+
+std::string SocketTransportStream::getAddress() {
+  std::lock_guard<std::mutex> lock(socketMutex_);
+  return address_;
+}
+
+void SocketTransportStream::serviceSocket() {
+  std::lock_guard<std::mutex> applyLock(applyMutex_);
+  {
+    std::lock_guard<std::mutex> lock(socketMutex_);
+    if (role_ == SocketRole::Listen) {
+      if (listenFd_ < 0) {
+        openListener();
+      }
+      if (listenFd_ >= 0) {
+        SocketAddressParts parts;
+        parseSocketAddress(address_, parts);
+        int fd = acceptSocket(listenFd_, !parts.isUnix);
+        if (fd >= 0) {
+          // the newest connection wins, as the previous peer has likely gone away
+          closeSocket();
+          onSocketConnected(fd);
+        }
+      }
+    } else if (socketFd_ < 0) {
+      openConnection();
+    } else if (isConnecting_) {
+      auto result = getConnectResult(socketFd_);
+      if (result > 0) {
+        onSocketConnected(socketFd_);
+      } else if (result < 0) {
+        closeSocket();
+      }
+    }
+
+    if (socketFd_ >= 0 && !isConnecting_) {
+      receiveFrames();
+    }
+  }
+
+  if (!receivedChanges_.empty()) {
+    applyReceivedChanges();
+  }
+}
+
+void SocketTransportStream::waitForSocketActivity(std::chrono::steady_clock::time_point deadline) {
+  int socketFd = -1;
+  bool isConnecting = false;
+  int listenFd = -1;
+  {
+    std::lock_guard<std::mutex> lock(socketMutex_);
+    socketFd = socketFd_;
+    isConnecting = isConnecting_;
+    listenFd = listenFd_;
+    if (socketFd < 0 && listenFd < 0) {
+      // nothing to wait on until the next connection attempt
+      deadline = std::min(deadline, nextConnectTime_);
+    }
+  }
+  pollSockets(socketFd, isConnecting, listenFd, deadline);
+}
+
+void SocketTransportStream::openListener() {
+  auto now = std::chrono::steady_clock::now();
+  if (now < nextConnectTime_) {
+    return;
+  }
+
+  SocketAddressParts parts;
+  std::string boundPort;
+  if (parseSocketAddress(address_, parts)) {
+    listenFd_ = openListenSocket(parts, boundPort);
+  }
+  if (listenFd_ < 0) {
+    std::cerr << "SocketTransportStream(" << name_ << "): failed to listen on " << address_
+              << "\n"
+              << std::flush;
+    nextConnectTime_ = now + RECONNECT_INTERVAL;
+    return;
+  }
+  if (!parts.isUnix && boundPort != parts.port) {
+    address_ = "tcp:" + parts.host + ":" + boundPort;
+  }
+}
+
+void SocketTransportStream::openConnection() {
+  auto now = std::chrono::steady_clock::now();
+  if (now < nextConnectTime_) {
+    return;
+  }
+
+  // the peer not being up yet is routine, so failures here are not logged
+  SocketAddressParts parts;
+  bool inProgress = false;
+  int fd = -1;
+  if (parseSocketAddress(address_, parts)) {
+    fd = openConnectSocket(parts, inProgress);
+  }
+  if (fd < 0) {
+    nextConnectTime_ = now + RECONNECT_INTERVAL;
+  } else if (inProgress) {
+    socketFd_ = fd;
+    isConnecting_ = true;
+  } else {
+    onSocketConnected(fd);
+  }
+}
+
+void SocketTransportStream::onSocketConnected(int fd) {
+  socketFd_ = fd;
+  isConnecting_ = false;
+  peerReady_ = false;
+  recvByteCount_ = 0;
+
+  uint8_t payload[HELLO_PAYLOAD_SIZE] = {};
+  MemoryAccessor payloadMem{payload, 0, HELLO_PAYLOAD_SIZE};
+  MemoryOffset offset;
+  payloadMem.writeValue<int32_t>(MemoryTransportStreamAccessor::TRANSPORT_VERSION, offset);
+  offset.advance(4);
+  HashValue::writeValue(config_.schemaHash, payloadMem, offset);
+
+  SocketFrameHeader header{FRAME_MAGIC, SocketFrameType::Hello, 0, HELLO_PAYLOAD_SIZE, 0};
+  sendSegments_.clear();
+  sendSegments_.emplace_back(&header, sizeof(header));
+  sendSegments_.emplace_back(payload, sizeof(payload));
+  if (!sendSegments(socketFd_, sendSegments_)) {
+    closeSocket();
+  }
+}
+
+void SocketTransportStream::closeSocket() {
+  if (socketFd_ >= 0) {
+    closeSocketFd(socketFd_);
+    nextConnectTime_ = std::chrono::steady_clock::now() + RECONNECT_INTERVAL;
+  }
+  socketFd_ = -1;
+  isConnecting_ = false;
+  peerReady_ = false;
+  recvByteCount_ = 0;
+}
+
+void SocketTransportStream::receiveFrames() {
+  constexpr size_t RECV_CHUNK_SIZE = 64 * 1024;
+
+  bool didClose = false;
+  while (true) {
+    if (recvBuffer_.size() - recvByteCount_ < RECV_CHUNK_SIZE / 4) {
+      recvBuffer_.resize(recvByteCount_ + RECV_CHUNK_SIZE);
+    }
+    auto received = receiveBytes(
+        socketFd_, recvBuffer_.data() + recvByteCount_, recvBuffer_.size() - recvByteCount_);
+    if (received > 0) {
+      recvByteCount_ += static_cast<size_t>(received);
+      continue;
+    }
+    didClose = received != -1;
+    break;
+  }
+
+  size_t offset = 0;
+  bool isValid = true;
+  while (isValid && recvByteCount_ - offset >= sizeof(SocketFrameHeader)) {
+    SocketFrameHeader header{};
+    std::memcpy(&header, recvBuffer_.data() + offset, sizeof(header));
+    if (header.magic != FRAME_MAGIC || header.payloadByteCount < 0 ||
+        header.payloadByteCount > MAX_FRAME_PAYLOAD) {
+      isValid = false;
+      break;
+    }
+    auto frameSize = sizeof(header) + static_cast<size_t>(header.payloadByteCount);
+    if (recvByteCount_ - offset < frameSize) {
+      break;
+    }
+    MemoryAccessor payloadMem{
+        recvBuffer_.data() + offset + sizeof(header), 0, header.payloadByteCount};
+
+    if (header.frameType == SocketFrameType::Hello) {
+      MemoryOffset payloadOffset;
+      int32_t version = -1;
+      HashValue schemaHash;
+      if (header.payloadByteCount >= HELLO_PAYLOAD_SIZE) {
+        version = payloadMem.readValue<int32_t>(payloadOffset);
+        payloadOffset.advance(4);
+        schemaHash = HashValue::readValue(payloadMem, payloadOffset);
+      }
+      if (version != MemoryTransportStreamAccessor::TRANSPORT_VERSION ||
+          schemaHash != config_.schemaHash) {
+        std::cerr << "SocketTransportStream(" << name_
+                  << "): peer transport version or schema hash mismatch\n"
+                  << std::flush;
+        didClose = true;
+        break;
+      }
+      peerReady_ = true;
+      resyncEpoch_.fetch_add(1, std::memory_order_acq_rel);
+    } else if (header.frameType == SocketFrameType::Changes && peerReady_) {
+      // check the event framing up front, so applying them cannot run off the payload
+      int32_t eventOffset = 0;
+      for (int32_t i = 0; i < header.eventCount && isValid; ++i) {
+        int32_t eventSize = 0;
+        isValid = header.payloadByteCount - eventOffset >= 4;
+        if (isValid) {
+          MemoryOffset sizeOffset(eventOffset);
+          eventSize = payloadMem.readValue<int32_t>(sizeOffset);
+          eventOffset += 4 + eventSize;
+          isValid = eventSize >= ChangeEventAccessor::DS_SIZE &&
+              eventOffset <= header.payloadByteCount;
+        }
+      }
+      if (isValid) {
+        auto* frameStart = recvBuffer_.data() + offset;
+        receivedChanges_.insert(receivedChanges_.end(), frameStart, frameStart + frameSize);
+      }
+    } else if (header.frameType == SocketFrameType::Resync && peerReady_) {
+      resyncEpoch_.fetch_add(1, std::memory_order_acq_rel);
+    } else {
+      isValid = false;
+    }
+
+    if (isValid) {
+      offset += frameSize;
+    }
+  }
+
+  if (!isValid) {
+    std::cerr << "SocketTransportStream(" << name_ << "): invalid frame, dropping connection\n"
+              << std::flush;
+    didClose = true;
+  }
+
+  if (didClose) {
+    closeSocket();
+  } else if (offset > 0) {
+    std::memmove(recvBuffer_.data(), recvBuffer_.data() + offset, recvByteCount_ - offset);
+    recvByteCount_ -= offset;
+  }
+}
+
+void SocketTransportStream::sendChanges(int32_t startId, uint64_t baseTimestampUs) {
+  std::lock_guard<std::mutex> lock(socketMutex_);
+  if (socketFd_ < 0 || isConnecting_) {
+    // the peer requests a full update once it connects
+    return;
+  }
+
+  MemoryTransportStreamAccessor streamAccessor{accessMemory()};
+  auto* changelog = streamAccessor.getChangelog(config_);
+  PlacedRingBufferIterator iter;
+  if (!iter.setToId(changelog, startId, streamAccessor.getChangelogIndex(config_))) {
+    // the transaction overflowed the changelog, just as a shared memory reader can fall behind
+    SocketFrameHeader header{FRAME_MAGIC, SocketFrameType::Resync, 0, 0, baseTimestampUs};
+    sendSegments_.clear();
+    sendSegments_.emplace_back(&header, sizeof(header));
+    if (!sendSegments(socketFd_, sendSegments_)) {
+      closeSocket();
+    }
+    return;
+  }
+
+  // each changelog element is already its byte count followed by the event, which is exactly the
+  // wire format, so the events are sent in place
+  SocketFrameHeader header{FRAME_MAGIC, SocketFrameType::Changes, 0, 0, baseTimestampUs};
+  sendSegments_.clear();
+  sendSegments_.emplace_back(&header, sizeof(header));
+  while (iter.hasNext(changelog)) {
+    auto entry = iter.next(changelog);
+    auto* eventPtr = static_cast<uint8_t*>(entry.getRawPointer(0, entry.getSize()));
+    auto elementSize = PlacedRingBuffer::ELEMENT_HEADER_SIZE + entry.getSize();
+    sendSegments_.emplace_back(eventPtr - PlacedRingBuffer::ELEMENT_HEADER_SIZE, elementSize);
+    header.eventCount++;
+    header.payloadByteCount += elementSize;
+  }
+
+  if (!sendSegments(socketFd_, sendSegments_)) {
+    closeSocket();
+  }
+}
+
+bool SocketTransportStream::applyReceivedChanges() {
+  return MemoryTransportStream::transact(APPLY_TIMEOUT, [&](TransportStreamAccessor* accessor) {
+    size_t offset = 0;
+    while (offset < receivedChanges_.size()) {
+      SocketFrameHeader header{};
+      std::memcpy(&header, receivedChanges_.data() + offset, sizeof(header));
+      offset += sizeof(header);
+
+      MemoryAccessor payloadMem{
+          receivedChanges_.data() + offset, 0, header.payloadByteCount};
+      MemoryOffset payloadOffset;
+      for (int32_t i = 0; i < header.eventCount; ++i) {
+        auto eventSize = payloadMem.readValue<int32_t>(payloadOffset);
+        auto eventMem = payloadMem.slice(payloadOffset.advance(eventSize), eventSize);
+        // re-expressed against the local base timestamp
+        auto timestampUs = ChangeEventAccessor(eventMem).getTimestamp(header.baseTimestampUs);
+        accessor->writePrefilledChangeEvent(eventMem, timestampUs);
+      }
+      offset += header.payloadByteCount;
+    }
+    receivedChanges_.clear();
+  });
+}
+
+} // namespace Xrpa
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/transport/HeapMemoryTransportStream.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Xrpa {
+
+enum class SocketRole : uint32_t {
+  Listen,
+  Connect,
+};
+
+// A transport stream that spans hosts. Both ends keep a local HeapMemoryTransportStream, which
+// their iterators read exactly as they would shared memory. The change events of each transaction
+// are also sent to the peer in a single sendmsg(), and the peer appends the events it receives
+// to its own copy.
+//
+// The address is "unix:<path>" or "tcp:<host>:<port>". A Listen stream accepts one peer at a time,
+// with a newer connection replacing the current one; a Connect stream keeps reconnecting. The
+// peers exchange TRANSPORT_VERSION and schemaHash when they connect, and a mismatch drops the
+// connection. Events written while disconnected are not sent. Instead, each (re)connection is
+// reported to iterators as missed entries, which makes DataStoreReconciler request a full update;
+// the same happens when a transaction overflows the sender's changelog.
+//
+// There is no background thread: the socket is serviced from transact() and the iterators.
+// POSIX only for now; elsewhere the stream never connects.
+class SocketTransportStream : public HeapMemoryTransportStream {
+ public:
+  SocketTransportStream(
+      const std::string& name,
+      const TransportConfig& config,
+      const std::string& address,
+      SocketRole role);
+  ~SocketTransportStream() override;
+
+  bool transact(
+      std::chrono::milliseconds timeout,
+      std::function<void(TransportStreamAccessor*)> func) override;
+
+  std::unique_ptr<TransportStreamIterator> createIterator() override;
+
+  // true once the peer's handshake has been received on the current connection
+  bool isConnected();
+
+  // services the socket until isConnected() or the timeout elapses
+  bool waitForConnection(std::chrono::milliseconds timeout);
+
+  // drops the current connection; a Connect stream reconnects on a later service
+  void disconnect();
+
+  // the address the stream was created with, except that a "tcp:<host>:0" listener reports the
+  // port it was assigned
+  std::string getAddress();
+
+ private:
+  friend class SocketTransportStreamIterator;
+
+  // accepts or connects, reads whatever the peer has sent, and appends received change events to
+  // the local memory
+  void serviceSocket();
+
+  // blocks until the socket has activity or the deadline passes
+  void waitForSocketActivity(std::chrono::steady_clock::time_point deadline);
+
+  uint32_t getResyncEpoch() const {
+    return resyncEpoch_.load(std::memory_order_acquire);
+  }
+
+  // the rest are called with socketMutex_ held
+  void openListener();
+  void openConnection();
+  void onSocketConnected(int fd);
+  void closeSocket();
+  void receiveFrames();
+
+  // takes the changelog entries with IDs after startId and sends them as one frame
+  void sendChanges(int32_t startId, uint64_t baseTimestampUs);
+
+  // appends the change frames queued by receiveFrames(); false if the local lock timed out
+  bool applyReceivedChanges();
+
+  std::string address_;
+  SocketRole role_;
+
+  // serializes applying received changes, so that they land in the order they arrived; taken
+  // before socketMutex_ and before the transport lock, while transact() sends with the transport
+  // lock held and then takes socketMutex_
+  std::mutex applyMutex_;
+  std::mutex socketMutex_;
+
+  int listenFd_ = -1;
+  int socketFd_ = -1;
+  bool isConnecting_ = false;
+  bool peerReady_ = false;
+  std::chrono::steady_clock::time_point nextConnectTime_{};
+
+  // incremented whenever a peer handshake completes, and when the peer reports that it lost
+  // changes before they could be sent; either way iterators report missed entries
+  std::atomic<uint32_t> resyncEpoch_{0};
+
+  // bytes received but not yet parsed into frames
+  std::vector<uint8_t> recvBuffer_;
+  size_t recvByteCount_ = 0;
+
+  // complete change frames waiting for applyReceivedChanges()
+  std::vector<uint8_t> receivedChanges_;
+
+  // the (pointer, length) pieces of the frame being sent, kept to reuse their allocation
+  std::vector<std::pair<const void*, size_t>> sendSegments_;
+};
+
+} // namespace Xrpa
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/transport/TransportLockDomain.h>
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+namespace Xrpa {
+
+struct LockDomainRegistry {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<TransportLockDomain>> domains;
+};
+
+static LockDomainRegistry& getLockDomainRegistry() {
+  static LockDomainRegistry registry;
+  return registry;
+}
+
+TransportLockDomain::TransportLockDomain(const std::string& name) : name_(name) {
+  auto mutexName = "XrpaLockDomain_" + name;
+
+#if defined(__linux__)
+  // the lock lives in a small shared memory object of its own, so that it is robust against its
+  // owner dying just like the locks of the member streams
+  int fd = shm_open(("/" + mutexName).c_str(), O_RDWR | O_CREAT, 0666);
+  if (fd == -1) {
+    perror("Error opening lock domain shared memory");
+  } else {
+    // new memory reads as zeros, which is a valid unlocked mutex slot and a zero death count
+    struct stat st{};
+    fstat(fd, &st);
+    if (st.st_size < LOCK_REGION_SIZE) {
+      ftruncate(fd, LOCK_REGION_SIZE);
+    }
+
+    lockRegion_ = (unsigned char*)mmap(
+        NULL, LOCK_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (lockRegion_ == MAP_FAILED) {
+      perror("Error mapping lock domain shared memory");
+      lockRegion_ = nullptr;
+    }
+
+    close(fd);
+  }
+
+  if (lockRegion_ != nullptr) {
+    mutex_ = std::make_unique<RobustInterprocessMutex>(mutexName, lockRegion_);
+    ownerDeathCount_ = reinterpret_cast<volatile uint32_t*>(lockRegion_ + ROBUST_MUTEX_SLOT_SIZE);
+    return;
+  }
+#endif
+
+  // the count is then kept per process, as is the named mutex's owner death detection
+  mutex_ = createNamedInterprocessMutex(mutexName);
+  ownerDeathCount_ = &localOwnerDeathCount_;
+}
+
+TransportLockDomain::~TransportLockDomain() {
+#if defined(__linux__)
+  if (lockRegion_ != nullptr) {
+    // the mutex is about to be unmapped
+    mutex_->dispose();
+    mutex_ = nullptr;
+    munmap(lockRegion_, LOCK_REGION_SIZE);
+    lockRegion_ = nullptr;
+  }
+#endif
+}
+
+std::shared_ptr<TransportLockDomain> TransportLockDomain::get(const std::string& name) {
+  auto& registry = getLockDomainRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto& entry = registry.domains[name];
+  auto domain = entry.lock();
+  if (domain == nullptr) {
+    domain = std::shared_ptr<TransportLockDomain>(
+        new TransportLockDomain(name), [](TransportLockDomain* released) {
+          {
+            auto& registry = getLockDomainRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            // get() may already have replaced the entry with a new instance
+            auto iter = registry.domains.find(released->getName());
+            if (iter != registry.domains.end() && iter->second.expired()) {
+              registry.domains.erase(iter);
+            }
+          }
+          delete released;
+        });
+    entry = domain;
+  }
+  return domain;
+}
+
+bool TransportLockDomain::transact(
+    const std::function<void()>& func,
+    std::chrono::milliseconds timeout) {
+  if (lockAndExecute(timeout, func)) {
+    return true;
+  }
+  func();
+  return false;
+}
+
+bool TransportLockDomain::lockAndExecute(
+    std::chrono::milliseconds timeout,
+    const std::function<void()>& func) {
+  if (isHeldByCurrentThread()) {
+    func();
+    return true;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  std::unique_lock<std::timed_mutex> threadLock(threadMutex_, std::defer_lock);
+  if (!threadLock.try_lock_until(deadline)) {
+    return false;
+  }
+
+  // whatever is left of the timeout goes to the interprocess lock
+  auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  return mutex_->lockAndExecute(static_cast<int>(std::max<int64_t>(remaining.count(), 0)), [&]() {
+    holder_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    struct HolderReset {
+      std::atomic<std::thread::id>& holder;
+      ~HolderReset() {
+        holder.store(std::thread::id{}, std::memory_order_relaxed);
+      }
+    } holderReset{holder_};
+
+    if (mutex_->didOwnerDie()) {
+      *ownerDeathCount_ = *ownerDeathCount_ + 1;
+      std::cerr << "TransportLockDomain(" << name_ << "): a lock owner died\n"
+                << std::flush;
+    }
+    func();
+  });
+}
+
+} // namespace Xrpa
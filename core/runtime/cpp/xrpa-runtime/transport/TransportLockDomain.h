@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/transport/InterprocessMutex.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Xrpa {
+
+// A single interprocess lock shared by every stream configured with the same
+// TransportConfig::lockDomain. Transactions on member streams made from inside transact() do not
+// lock again, so a module can tick several data stores with one lock acquisition, and readers that
+// do the same observe all of the stores at a consistent point.
+class TransportLockDomain {
+ public:
+  static constexpr auto DEFAULT_TRANSACT_TIMEOUT = std::chrono::milliseconds(1);
+
+  explicit TransportLockDomain(const std::string& name);
+  ~TransportLockDomain();
+
+  // returns the instance for name shared by all streams of this process, creating it if needed; it
+  // is dropped from the registry once the last stream releases it
+  static std::shared_ptr<TransportLockDomain> get(const std::string& name);
+
+  const std::string& getName() const {
+    return name_;
+  }
+
+  // Runs func while holding the domain lock. If the lock cannot be taken within the timeout, func
+  // is still run, and each member stream transaction locks on its own (so the data stores' retry
+  // policies apply to them as usual). Returns true if func ran under a single acquisition.
+  bool transact(
+      const std::function<void()>& func,
+      std::chrono::milliseconds timeout = DEFAULT_TRANSACT_TIMEOUT);
+
+  // used by the member streams; calls made while the current thread holds the lock run directly
+  bool lockAndExecute(std::chrono::milliseconds timeout, const std::function<void()>& func);
+
+  bool isHeldByCurrentThread() const {
+    return holder_.load(std::memory_order_relaxed) == std::this_thread::get_id();
+  }
+
+  // how many times a process died while holding the domain lock, counted across all processes
+  // where the platform allows; only stable while the lock is held. Member streams compare it
+  // against the count they last saw to tell that they may have been left half-written.
+  [[nodiscard]] uint32_t getOwnerDeathCount() const {
+    return *ownerDeathCount_;
+  }
+
+ private:
+  std::string name_;
+
+#if defined(__linux__)
+  // holds the RobustInterprocessMutex, then the owner death count on a cache line of its own
+  static constexpr int32_t LOCK_REGION_SIZE = ROBUST_MUTEX_SLOT_SIZE + 64;
+
+  unsigned char* lockRegion_ = nullptr;
+#endif
+
+  // the interprocess mutex implementations are not safe to share between threads, so threads of
+  // this process are serialized before it is taken
+  std::timed_mutex threadMutex_;
+  std::unique_ptr<InterprocessMutex> mutex_;
+  std::atomic<std::thread::id> holder_{};
+
+  // points into the lock region when there is one, otherwise at localOwnerDeathCount_
+  volatile uint32_t localOwnerDeathCount_ = 0;
+  volatile uint32_t* ownerDeathCount_ = &localOwnerDeathCount_;
+};
+
+} // namespace Xrpa
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <xrpa-runtime/transport/TransportStreamAccessor.h>
+#include <xrpa-runtime/transport/TransportStreamMetrics.h>
 #include <xrpa-runtime/utils/MemoryAccessor.h>
 #include <chrono>
 #include <functional>
@@ -30,8 +31,21 @@ class TransportStreamIterator {
 
   virtual bool needsProcessing() = 0;
 
+  // Blocks until needsProcessing() would return true or the timeout elapses, and returns its
+  // result. Transports without a wakeup mechanism just check once.
+  virtual bool waitForChanges(std::chrono::microseconds /*timeout*/) {
+    return needsProcessing();
+  }
+
   virtual bool hasMissedEntries(TransportStreamAccessor* accessor) = 0;
   virtual MemoryAccessor getNextEntry(TransportStreamAccessor* accessor) = 0;
+
+  // Called after hasMissedEntries() returns true: repositions the iterator so that it yields the
+  // writer's snapshot followed by the changelog entries written after it. Returns false if the
+  // transport keeps no usable snapshot, in which case the reader must request a full update.
+  virtual bool resyncFromSnapshot(TransportStreamAccessor* /*accessor*/) {
+    return false;
+  }
 };
 
 class TransportStream {
@@ -45,6 +59,14 @@ class TransportStream {
   virtual std::unique_ptr<TransportStreamIterator> createIterator() = 0;
 
   virtual bool needsHeartbeat() = 0;
+
+  // counters accumulated since creation or the last resetMetrics() call; safe to call from any
+  // thread
+  virtual TransportStreamMetrics getMetrics() const {
+    return {};
+  }
+
+  virtual void resetMetrics() {}
 };
 
 } // namespace Xrpa
@@ -16,7 +16,7 @@
 
 #pragma once
 
-#include <xrpa-runtime/transport/TransportStreamAccessor.h>
+#include <xrpa-runtime/transport/TransportStreamMetrics.h>
 #include <xrpa-runtime/utils/TimeUtils.h>
 #include <xrpa-runtime/utils/XrpaTypes.h>
 #include <functional>
@@ -25,7 +25,9 @@ namespace Xrpa {
 
 class ChangeEventAccessor : public ObjectAccessorInterface {
  public:
-  static constexpr int32_t DS_SIZE = 8;
+  // int32 change type, then the event timestamp as a uint64 microsecond offset from the
+  // transport's baseTimestamp
+  static constexpr int32_t DS_SIZE = 12;
 
   explicit ChangeEventAccessor(MemoryAccessor memAccessor)
       : ObjectAccessorInterface(std::move(memAccessor)) {}
@@ -42,13 +44,13 @@ class ChangeEventAccessor : public ObjectAccessorInterface {
 
   uint64_t getTimestamp(uint64_t baseTimestampUs) {
     auto offset = MemoryOffset(4);
-    uint64_t timestampOffsetMs = memAccessor_.readValue<int32_t>(offset);
-    return baseTimestampUs + (timestampOffsetMs * 1000);
+    return baseTimestampUs + memAccessor_.readValue<uint64_t>(offset);
   }
 
   void setTimestamp(uint64_t timestampUs, uint64_t baseTimestampUs) {
+    // unsigned wraparound keeps timestamps older than the base exact
     auto offset = MemoryOffset(4);
-    memAccessor_.writeValue<int32_t>((timestampUs - baseTimestampUs) / 1000, offset);
+    memAccessor_.writeValue<uint64_t>(timestampUs - baseTimestampUs, offset);
   }
 };
 
@@ -58,17 +60,42 @@ class TransportStreamIteratorData {
   virtual ~TransportStreamIteratorData() = default;
 
   int32_t typeId_;
+
+  // filled in by the iterator during a transaction, for TransportStreamMetrics
+  uint64_t eventsRead_ = 0;
+  uint64_t bytesRead_ = 0;
+  uint64_t missedEntries_ = 0;
+  LatencyHistogram eventLatency_;
+
+  // when the transaction started reading, as the reference point for eventLatency_; 0 disables
+  // latency tracking
+  uint64_t readTimestampUs_ = 0;
+
+  // records the writer-to-reader latency of a change event read from the changelog
+  void recordEventLatency(const MemoryAccessor& entry, uint64_t baseTimestampUs) {
+    if (readTimestampUs_ == 0) {
+      return;
+    }
+    auto timestampUs = ChangeEventAccessor(entry).getTimestamp(baseTimestampUs);
+    auto latencyUs = static_cast<int64_t>(readTimestampUs_ - timestampUs);
+    eventLatency_.record(std::chrono::microseconds{latencyUs});
+  }
 };
 
 class TransportStreamAccessor {
  public:
+  // writes a snapshot of the writer's state, using the given function to fill in the change events
+  using SnapshotWriter = std::function<bool(const std::function<void(TransportStreamAccessor*)>&)>;
+
   TransportStreamAccessor(
       uint64_t baseTimestampUs,
       TransportStreamIteratorData* iteratorData,
-      std::function<MemoryAccessor(int32_t)> eventAllocator)
+      std::function<MemoryAccessor(int32_t)> eventAllocator,
+      SnapshotWriter snapshotWriter = nullptr)
       : baseTimestampUs_(baseTimestampUs),
         iteratorData_(iteratorData),
-        eventAllocator_(std::move(eventAllocator)) {}
+        eventAllocator_(std::move(eventAllocator)),
+        snapshotWriter_(std::move(snapshotWriter)) {}
 
   template <typename EventAccessor = ChangeEventAccessor>
   EventAccessor
@@ -96,10 +123,33 @@ class TransportStreamAccessor {
         timestampUs ? timestampUs : getCurrentClockTimeMicroseconds(), baseTimestampUs_);
   }
 
+  // Set by the transport when it refuses a change event to protect entries that a lossless reader
+  // has not read yet (TransportConfig::losslessReaderCount). Every later write in the transaction
+  // is refused as well, so that nothing lands in the changelog ahead of the refused event; the
+  // writer keeps whatever was refused pending and writes it again in a later transaction.
+  bool isWriteBlocked() const {
+    return isWriteBlocked_;
+  }
+
+  void setWriteBlocked() {
+    isWriteBlocked_ = true;
+  }
+
   uint64_t getBaseTimestamp() {
     return baseTimestampUs_;
   }
 
+  bool canWriteSnapshot() const {
+    return snapshotWriter_ != nullptr;
+  }
+
+  // Replaces the transport's snapshot with the change events written by func, tagged as current
+  // as of the last change written to this stream. Returns false if the transport does not keep a
+  // snapshot or it did not fit, in which case the previous snapshot is left in place.
+  bool writeSnapshot(const std::function<void(TransportStreamAccessor*)>& func) {
+    return snapshotWriter_ != nullptr && snapshotWriter_(func);
+  }
+
   template <typename T>
   T* getIteratorData() {
     // can't use reinterpret_cast because Unreal Engine has RTTI disabled
@@ -113,6 +163,8 @@ class TransportStreamAccessor {
   uint64_t baseTimestampUs_;
   TransportStreamIteratorData* iteratorData_;
   std::function<MemoryAccessor(int32_t)> eventAllocator_;
+  SnapshotWriter snapshotWriter_;
+  bool isWriteBlocked_ = false;
 };
 
 } // namespace Xrpa
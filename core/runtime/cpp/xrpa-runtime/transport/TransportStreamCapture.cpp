@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/transport/TransportStreamCapture.h>
+
+#include <xrpa-runtime/transport/TransportStreamAccessor.h>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace Xrpa {
+
+static constexpr size_t INITIAL_CAPTURE_BYTE_COUNT = 1 << 20;
+static constexpr size_t RECORD_HEADER_SIZE = 12;
+
+static size_t getRecordSize(int32_t byteCount) {
+  return (RECORD_HEADER_SIZE + byteCount + 7) & ~static_cast<size_t>(7);
+}
+
+TransportStreamRecorder::TransportStreamRecorder(
+    std::shared_ptr<TransportStream> transportStream,
+    const std::string& filePath,
+    const HashValue& schemaHash)
+    : transportStream_(std::move(transportStream)),
+      iterator_(transportStream_->createIterator()),
+      filePath_(filePath) {
+  if (!file_.openForWrite(filePath_, INITIAL_CAPTURE_BYTE_COUNT)) {
+    std::cerr << "TransportStreamRecorder(" << filePath_ << "): failed to create capture file\n"
+              << std::flush;
+    return;
+  }
+  auto* header = getHeader();
+  *header = TransportCaptureHeader{};
+  header->magic = TransportCaptureHeader::MAGIC;
+  header->version = TransportCaptureHeader::VERSION;
+  header->schemaHash = schemaHash;
+}
+
+TransportStreamRecorder::~TransportStreamRecorder() {
+  finish();
+}
+
+int32_t TransportStreamRecorder::recordPending(std::chrono::milliseconds timeout) {
+  if (!isOpen()) {
+    return 0;
+  }
+
+  int32_t eventCount = 0;
+  bool didLock = transportStream_->transact(timeout, [&](TransportStreamAccessor* accessor) {
+    if (iterator_->hasMissedEntries(accessor)) {
+      getHeader()->missedEntryCount++;
+    }
+    auto baseTimestampUs = accessor->getBaseTimestamp();
+    for (auto entry = iterator_->getNextEntry(accessor); !entry.isNull() && isOpen();
+         entry = iterator_->getNextEntry(accessor)) {
+      appendEvent(ChangeEventAccessor(entry).getTimestamp(baseTimestampUs), entry);
+      eventCount++;
+    }
+  });
+  return didLock ? eventCount : -1;
+}
+
+void TransportStreamRecorder::appendEvent(uint64_t timestampUs, const MemoryAccessor& entry) {
+  auto byteCount = entry.getSize();
+  auto recordSize = getRecordSize(byteCount);
+  auto offset = sizeof(TransportCaptureHeader) + getHeader()->recordByteCount;
+
+  if (offset + recordSize > file_.size()) {
+    // doubling keeps the number of remaps logarithmic in the capture length
+    auto newSize = file_.size() * 2;
+    while (offset + recordSize > newSize) {
+      newSize *= 2;
+    }
+    if (!file_.resize(newSize)) {
+      std::cerr << "TransportStreamRecorder(" << filePath_ << "): failed to grow capture file\n"
+                << std::flush;
+      finish();
+      return;
+    }
+  }
+
+  auto* record = file_.data() + offset;
+  std::memcpy(record, &timestampUs, sizeof(timestampUs));
+  std::memcpy(record + 8, &byteCount, sizeof(byteCount));
+  MemoryAccessor(record + RECORD_HEADER_SIZE, 0, byteCount).copyFrom(entry);
+
+  // the counts are updated last, so the header never covers a partially written record
+  auto* header = getHeader();
+  header->recordByteCount += static_cast<int64_t>(recordSize);
+  header->eventCount++;
+}
+
+void TransportStreamRecorder::finish() {
+  if (!isOpen()) {
+    return;
+  }
+  file_.resize(sizeof(TransportCaptureHeader) + getHeader()->recordByteCount);
+  file_.close();
+}
+
+int64_t TransportStreamRecorder::getEventCount() const {
+  return isOpen() ? getHeader()->eventCount : 0;
+}
+
+int64_t TransportStreamRecorder::getMissedEntryCount() const {
+  return isOpen() ? getHeader()->missedEntryCount : 0;
+}
+
+TransportCaptureHeader* TransportStreamRecorder::getHeader() const {
+  return reinterpret_cast<TransportCaptureHeader*>(file_.data());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+TransportStreamReplayer::TransportStreamReplayer(const std::string& filePath) {
+  if (!file_.openForRead(filePath)) {
+    std::cerr << "TransportStreamReplayer(" << filePath << "): failed to open capture file\n"
+              << std::flush;
+    return;
+  }
+
+  auto* header = getHeader();
+  if (file_.size() < sizeof(TransportCaptureHeader) ||
+      header->magic != TransportCaptureHeader::MAGIC ||
+      header->version != TransportCaptureHeader::VERSION ||
+      header->recordByteCount < 0 ||
+      sizeof(TransportCaptureHeader) + header->recordByteCount > file_.size()) {
+    std::cerr << "TransportStreamReplayer(" << filePath << "): not a valid capture file\n"
+              << std::flush;
+    file_.close();
+  }
+}
+
+HashValue TransportStreamReplayer::getSchemaHash() const {
+  return isOpen() ? getHeader()->schemaHash : HashValue();
+}
+
+int64_t TransportStreamReplayer::getEventCount() const {
+  return isOpen() ? getHeader()->eventCount : 0;
+}
+
+int64_t TransportStreamReplayer::getMissedEntryCount() const {
+  return isOpen() ? getHeader()->missedEntryCount : 0;
+}
+
+int64_t TransportStreamReplayer::replay(
+    TransportStream* transportStream,
+    double speed,
+    std::chrono::milliseconds timeout) {
+  if (!isOpen()) {
+    return 0;
+  }
+
+  auto* recordStart = file_.data() + sizeof(TransportCaptureHeader);
+  auto* recordEnd = recordStart + getHeader()->recordByteCount;
+  auto readRecord = [&](const uint8_t* record, uint64_t& timestampUs, int32_t& byteCount) {
+    if (recordEnd - record < static_cast<ptrdiff_t>(RECORD_HEADER_SIZE)) {
+      return false;
+    }
+    std::memcpy(&timestampUs, record, sizeof(timestampUs));
+    std::memcpy(&byteCount, record + 8, sizeof(byteCount));
+    return byteCount > 0 &&
+        recordEnd - record >= static_cast<ptrdiff_t>(getRecordSize(byteCount));
+  };
+
+  int64_t eventCount = 0;
+  uint64_t firstTimestampUs = 0;
+  auto replayStart = std::chrono::steady_clock::now();
+
+  auto* record = recordStart;
+  uint64_t timestampUs = 0;
+  int32_t byteCount = 0;
+  while (readRecord(record, timestampUs, byteCount)) {
+    if (eventCount == 0) {
+      firstTimestampUs = timestampUs;
+    } else if (speed > MAX_SPEED) {
+      auto offsetUs = static_cast<double>(timestampUs - firstTimestampUs) / speed;
+      std::this_thread::sleep_until(
+          replayStart + std::chrono::microseconds(static_cast<int64_t>(offsetUs)));
+    }
+
+    // the run of events sharing this timestamp came from one transaction
+    auto groupTimestampUs = timestampUs;
+    auto* groupEnd = record;
+    int64_t groupCount = 0;
+    bool didLock = transportStream->transact(timeout, [&](TransportStreamAccessor* accessor) {
+      while (readRecord(groupEnd, timestampUs, byteCount) && timestampUs == groupTimestampUs) {
+        MemoryAccessor eventMem{groupEnd + RECORD_HEADER_SIZE, 0, byteCount};
+        accessor->writePrefilledChangeEvent(eventMem);
+        groupEnd += getRecordSize(byteCount);
+        groupCount++;
+      }
+    });
+    if (!didLock) {
+      break;
+    }
+    eventCount += groupCount;
+    record = groupEnd;
+  }
+  return eventCount;
+}
+
+const TransportCaptureHeader* TransportStreamReplayer::getHeader() const {
+  return reinterpret_cast<const TransportCaptureHeader*>(file_.data());
+}
+
+} // namespace Xrpa
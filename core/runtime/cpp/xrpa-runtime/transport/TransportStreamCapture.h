@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/transport/TransportStream.h>
+#include <xrpa-runtime/utils/MappedFile.h>
+#include <xrpa-runtime/utils/XrpaTypes.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Xrpa {
+
+// Capture files hold the change events that flowed through a transport stream, for replaying
+// offline as a deterministic load. Each event is stored with its absolute timestamp, so events
+// written by one transaction (which share a clock sample) can be replayed as one; transactions
+// that sampled the same microsecond are merged.
+//
+// Layout:
+//   [Header, 64 bytes][records...]
+//   record: [uint64_t timestampUs][int32_t byteCount][event bytes], padded to 8 bytes
+struct TransportCaptureHeader {
+  static constexpr uint32_t MAGIC = 0x50435258; // "XRCP"
+  static constexpr int32_t VERSION = 1;
+
+  uint32_t magic;
+  int32_t version;
+  HashValue schemaHash;
+  int64_t eventCount;
+  // bytes of records following the header
+  int64_t recordByteCount;
+  // times the recorder fell behind the stream and lost events
+  int64_t missedEntryCount;
+};
+static_assert(sizeof(TransportCaptureHeader) == 64);
+
+// Tails a transport stream through its own iterator and appends the events it reads to a capture
+// file. The header is kept current after each call to recordPending(), so a capture cut short by
+// a crash is still readable.
+class TransportStreamRecorder {
+ public:
+  TransportStreamRecorder(
+      std::shared_ptr<TransportStream> transportStream,
+      const std::string& filePath,
+      const HashValue& schemaHash);
+  ~TransportStreamRecorder();
+
+  [[nodiscard]] bool isOpen() const {
+    return file_.isOpen();
+  }
+
+  // appends the events written to the stream since the last call; returns how many were recorded,
+  // or -1 if the stream could not be locked
+  int32_t recordPending(std::chrono::milliseconds timeout = std::chrono::milliseconds(1));
+
+  // trims the file to its contents and closes it
+  void finish();
+
+  [[nodiscard]] int64_t getEventCount() const;
+  [[nodiscard]] int64_t getMissedEntryCount() const;
+
+ private:
+  void appendEvent(uint64_t timestampUs, const MemoryAccessor& entry);
+  TransportCaptureHeader* getHeader() const;
+
+  std::shared_ptr<TransportStream> transportStream_;
+  std::unique_ptr<TransportStreamIterator> iterator_;
+  MappedFile file_;
+  std::string filePath_;
+};
+
+// Writes the events of a capture file into a transport stream, at their original pacing or
+// scaled by speed. Events are restamped with the replay time as they are written, so latency
+// measured on the replayed stream is that of the replay.
+class TransportStreamReplayer {
+ public:
+  // replays without waiting between transactions
+  static constexpr double MAX_SPEED = 0;
+
+  explicit TransportStreamReplayer(const std::string& filePath);
+
+  [[nodiscard]] bool isOpen() const {
+    return file_.isOpen();
+  }
+
+  [[nodiscard]] HashValue getSchemaHash() const;
+  [[nodiscard]] int64_t getEventCount() const;
+  [[nodiscard]] int64_t getMissedEntryCount() const;
+
+  // speed 1 keeps the original pacing, 2 replays twice as fast, and MAX_SPEED as fast as the
+  // stream accepts the events. Returns the number of events written, which falls short if the
+  // stream could not be locked within timeout.
+  int64_t replay(
+      TransportStream* transportStream,
+      double speed = 1,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+
+ private:
+  [[nodiscard]] const TransportCaptureHeader* getHeader() const;
+
+  MappedFile file_;
+};
+
+} // namespace Xrpa
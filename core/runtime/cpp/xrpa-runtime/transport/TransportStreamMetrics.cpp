@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/transport/TransportStreamMetrics.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Xrpa {
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+  auto durationUs = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  auto us = static_cast<uint64_t>(std::max<int64_t>(durationUs.count(), 0));
+
+  int32_t bucket = 0;
+  while (us > 0 && bucket < BUCKET_COUNT - 1) {
+    us >>= 1;
+    ++bucket;
+  }
+
+  ++buckets[bucket];
+  ++count;
+  total += durationUs;
+  max = std::max(max, durationUs);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  for (int32_t i = 0; i < BUCKET_COUNT; ++i) {
+    buckets[i] += other.buckets[i];
+  }
+  count += other.count;
+  total += other.total;
+  max = std::max(max, other.max);
+}
+
+std::chrono::microseconds LatencyHistogram::getPercentileUpperBound(double fraction) const {
+  if (count == 0) {
+    return {};
+  }
+
+  auto threshold = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count))));
+  uint64_t cumulative = 0;
+  for (int32_t i = 0; i < BUCKET_COUNT - 1; ++i) {
+    cumulative += buckets[i];
+    if (cumulative >= threshold) {
+      return std::chrono::microseconds{int64_t{1} << i};
+    }
+  }
+  return max;
+}
+
+void TransportStreamMetrics::merge(const TransportStreamMetrics& other) {
+  transactCount += other.transactCount;
+  transactFailures += other.transactFailures;
+  lockWait.merge(other.lockWait);
+  lockHold.merge(other.lockHold);
+  eventsWritten += other.eventsWritten;
+  bytesWritten += other.bytesWritten;
+  failedWrites += other.failedWrites;
+  blockedWrites += other.blockedWrites;
+  eventsRead += other.eventsRead;
+  bytesRead += other.bytesRead;
+  missedEntries += other.missedEntries;
+  changeWakes += other.changeWakes;
+  eventLatency.merge(other.eventLatency);
+  changelogHighWaterMark = std::max(changelogHighWaterMark, other.changelogHighWaterMark);
+  changelogByteCount = std::max(changelogByteCount, other.changelogByteCount);
+  bytesFlushed += other.bytesFlushed;
+  mappingFlagsRequested |= other.mappingFlagsRequested;
+  mappingFlagsApplied |= other.mappingFlagsApplied;
+}
+
+static void dumpHistogram(std::ostream& out, const char* name, const LatencyHistogram& histogram) {
+  out << " " << name << "Mean=" << histogram.getMean().count() << "us " << name
+      << "P99<" << histogram.getPercentileUpperBound(0.99).count() << "us " << name
+      << "Max=" << histogram.max.count() << "us";
+}
+
+void TransportStreamMetrics::dump(std::ostream& out, const std::string& streamName) const {
+  out << "[TransportStream] " << streamName << ": transacts=" << transactCount
+      << " failures=" << transactFailures;
+  dumpHistogram(out, "lockWait", lockWait);
+  dumpHistogram(out, "lockHold", lockHold);
+  out << " written=" << eventsWritten << "/" << bytesWritten << "B"
+      << " failedWrites=" << failedWrites << " blockedWrites=" << blockedWrites
+      << " read=" << eventsRead << "/" << bytesRead << "B"
+      << " missedEntries=" << missedEntries << " changeWakes=" << changeWakes;
+  if (eventLatency.count > 0) {
+    dumpHistogram(out, "eventLatency", eventLatency);
+  }
+  out << " changelogHWM=" << changelogHighWaterMark << "/"
+      << changelogByteCount << "B flushed=" << bytesFlushed << "B";
+  if (mappingFlagsRequested != 0) {
+    out << " mappingFlags=0x" << std::hex << mappingFlagsApplied << "/0x" << mappingFlagsRequested
+        << std::dec;
+  }
+  out << "\n";
+}
+
+} // namespace Xrpa
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Xrpa {
+
+// Duration histogram with power-of-two microsecond buckets: bucket 0 counts durations under 1us,
+// bucket i counts [2^(i-1), 2^i) us, and the last bucket also takes everything longer.
+struct LatencyHistogram {
+  static constexpr int32_t BUCKET_COUNT = 24;
+
+  std::array<uint64_t, BUCKET_COUNT> buckets{};
+  uint64_t count = 0;
+  std::chrono::microseconds total{};
+  std::chrono::microseconds max{};
+
+  void record(std::chrono::nanoseconds duration);
+
+  void merge(const LatencyHistogram& other);
+
+  // exclusive upper bound of the first bucket at which the given fraction (0-1] of the recorded
+  // durations is reached
+  [[nodiscard]] std::chrono::microseconds getPercentileUpperBound(double fraction) const;
+
+  [[nodiscard]] std::chrono::microseconds getMean() const {
+    if (count == 0) {
+      return {};
+    }
+    return total / static_cast<int64_t>(count);
+  }
+};
+
+struct TransportStreamMetrics {
+  uint64_t transactCount = 0;
+
+  // transactions that could not acquire the transport lock within their timeout
+  uint64_t transactFailures = 0;
+
+  LatencyHistogram lockWait;
+  LatencyHistogram lockHold;
+
+  uint64_t eventsWritten = 0;
+  uint64_t bytesWritten = 0;
+
+  // change events that did not fit in the changelog at all and were dropped
+  uint64_t failedWrites = 0;
+
+  // change events refused because they would have evicted entries that a registered lossless
+  // reader had not read yet (TransportConfig::losslessReaderCount)
+  uint64_t blockedWrites = 0;
+
+  uint64_t eventsRead = 0;
+  uint64_t bytesRead = 0;
+
+  // times a reader found that the changelog had evicted entries it had not read yet
+  uint64_t missedEntries = 0;
+
+  // writing transactions that woke readers sleeping in waitForChanges(); a write with nobody
+  // waiting skips the wake
+  uint64_t changeWakes = 0;
+
+  // age of each change event when it was read, from its writer's timestamp to the start of the
+  // reading transaction; both ends use the system clock, so this spans processes on one host
+  LatencyHistogram eventLatency;
+
+  // peak changelog occupancy seen at the end of a transaction, against its capacity; compare the
+  // two when sizing TransportConfig::changelogByteCount (locking streams only)
+  int32_t changelogHighWaterMark = 0;
+  int32_t changelogByteCount = 0;
+
+  // bytes handed to the platform flush, 0 where no flush is needed
+  uint64_t bytesFlushed = 0;
+
+  // the TransportConfig::mappingFlags asked for, and the subset the platform honored; set when
+  // the memory is mapped, and kept by resetMetrics()
+  uint32_t mappingFlagsRequested = 0;
+  uint32_t mappingFlagsApplied = 0;
+
+  void merge(const TransportStreamMetrics& other);
+
+  void dump(std::ostream& out, const std::string& streamName) const;
+};
+
+} // namespace Xrpa
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/utils/MemoryAccessor.h>
+#include <array>
+#include <cstdint>
+
+namespace Xrpa {
+
+// Double-buffered region, next to a transport changelog, holding a snapshot of the writer's live
+// state as a sequence of change events (a FullUpdate marker followed by the same events a full
+// update would write to the changelog), tagged with the changelog ID it is current as of.
+//
+// The writer fills the inactive buffer and then flips the active index, so a snapshot that
+// overflows or is abandoned never replaces the last complete one. All access happens while the
+// transport lock is held.
+//
+// A snapshot only holds the objects of the writer that wrote it, so replaying it on a stream that
+// several writers share would delete everyone else's objects. The first writer claims the region,
+// and once a second one writes to the stream it is marked shared and the snapshot dropped, leaving
+// readers to request a full update from every writer instead.
+//
+// Layout:
+//   int32 activeBuffer (-1 if there is no snapshot)
+//   int32 bufferByteCount
+//   uint32 writerToken (0 until a writer claims the region, SHARED_WRITER once it is shared)
+//   int32 reserved
+//   buffer[2]: int32 changelogId, int32 usedBytes, then elements of [int32 size][size bytes]
+class TransportStreamSnapshot {
+ public:
+  static constexpr int32_t HEADER_SIZE = 16;
+  static constexpr int32_t BUFFER_HEADER_SIZE = 8;
+  static constexpr int32_t ELEMENT_HEADER_SIZE = 4;
+  static constexpr uint32_t SHARED_WRITER = 0xffffffff;
+
+  static int32_t getMemSize(int32_t bufferByteCount) {
+    return HEADER_SIZE + 2 * (BUFFER_HEADER_SIZE + bufferByteCount);
+  }
+
+  explicit TransportStreamSnapshot(MemoryAccessor memAccessor)
+      : memAccessor_(std::move(memAccessor)) {}
+
+  void init(int32_t bufferByteCount) {
+    setActiveBuffer(-1);
+    auto offset = MemoryOffset(4);
+    memAccessor_.writeValue<int32_t>(bufferByteCount, offset);
+    setWriterToken(0);
+  }
+
+  [[nodiscard]] bool hasSnapshot() const {
+    return getActiveBuffer() >= 0;
+  }
+
+  // changelog ID of the last change included in the active snapshot
+  [[nodiscard]] int32_t getChangelogId() const {
+    auto offset = MemoryOffset(0);
+    return getBuffer(getActiveBuffer()).readValue<int32_t>(offset);
+  }
+
+  // the writer that claimed the region, 0 if none has yet
+  [[nodiscard]] uint32_t getWriterToken() const {
+    auto offset = MemoryOffset(8);
+    return memAccessor_.readValue<uint32_t>(offset);
+  }
+
+  // writer side: records that writerToken wrote to the stream, returning false, and dropping the
+  // snapshot, if another writer already claimed the region
+  bool claimWriter(uint32_t writerToken) {
+    auto claimedToken = getWriterToken();
+    if (claimedToken == writerToken) {
+      return true;
+    }
+    if (claimedToken == 0) {
+      setWriterToken(writerToken);
+      return true;
+    }
+    setWriterToken(SHARED_WRITER);
+    setActiveBuffer(-1);
+    return false;
+  }
+
+  // writer side: discards any partially written snapshot and starts a new one
+  void beginWrite() {
+    writeBuffer_ = getActiveBuffer() == 0 ? 1 : 0;
+    writeOffset_ = BUFFER_HEADER_SIZE;
+  }
+
+  // writer side: returns a null accessor once the buffer is full, which fails the snapshot
+  [[nodiscard]] MemoryAccessor allocateElement(int32_t numBytes) {
+    numBytes = (numBytes + 3) & ~3;
+    auto buffer = getBuffer(writeBuffer_);
+    if (writeOffset_ < 0 || writeOffset_ + ELEMENT_HEADER_SIZE + numBytes > buffer.getSize()) {
+      writeOffset_ = -1;
+      return {};
+    }
+
+    auto offset = MemoryOffset(writeOffset_);
+    buffer.writeValue<int32_t>(numBytes, offset);
+    writeOffset_ = offset.offset_ + numBytes;
+    return buffer.slice(offset.offset_, numBytes);
+  }
+
+  // writer side: publishes the snapshot if everything fit, returns false otherwise
+  bool commitWrite(int32_t changelogId) {
+    if (writeOffset_ < 0) {
+      return false;
+    }
+
+    auto buffer = getBuffer(writeBuffer_);
+    auto offset = MemoryOffset(0);
+    buffer.writeValue<int32_t>(changelogId, offset);
+    buffer.writeValue<int32_t>(writeOffset_ - BUFFER_HEADER_SIZE, offset);
+    setActiveBuffer(writeBuffer_);
+    return true;
+  }
+
+  // writer side: the headers updated by the last successful commitWrite()
+  [[nodiscard]] std::array<MemoryAccessor, 2> getCommitHeaders() const {
+    return {getHeader(), getBuffer(writeBuffer_).slice(0, BUFFER_HEADER_SIZE)};
+  }
+
+  // holds the active buffer index and the writer claim
+  [[nodiscard]] MemoryAccessor getHeader() const {
+    return memAccessor_.slice(0, HEADER_SIZE);
+  }
+
+  // reader side: iterates the elements of the active snapshot; readOffset starts at 0
+  [[nodiscard]] MemoryAccessor readNext(int32_t& readOffset) const {
+    auto buffer = getBuffer(getActiveBuffer());
+    auto headerOffset = MemoryOffset(4);
+    auto usedBytes = buffer.readValue<int32_t>(headerOffset);
+    if (readOffset >= usedBytes) {
+      return {};
+    }
+
+    auto offset = MemoryOffset(BUFFER_HEADER_SIZE + readOffset);
+    auto numBytes = buffer.readValue<int32_t>(offset);
+    readOffset += ELEMENT_HEADER_SIZE + numBytes;
+    return buffer.slice(offset.offset_, numBytes);
+  }
+
+ private:
+  MemoryAccessor memAccessor_;
+  int32_t writeBuffer_ = 0;
+  int32_t writeOffset_ = -1;
+
+  [[nodiscard]] int32_t getActiveBuffer() const {
+    auto offset = MemoryOffset(0);
+    return memAccessor_.readValue<int32_t>(offset);
+  }
+
+  void setActiveBuffer(int32_t bufferIndex) {
+    auto offset = MemoryOffset(0);
+    memAccessor_.writeValue<int32_t>(bufferIndex, offset);
+  }
+
+  void setWriterToken(uint32_t writerToken) {
+    auto offset = MemoryOffset(8);
+    memAccessor_.writeValue<uint32_t>(writerToken, offset);
+  }
+
+  [[nodiscard]] MemoryAccessor getBuffer(int32_t bufferIndex) const {
+    auto offset = MemoryOffset(4);
+    auto bufferByteCount = memAccessor_.readValue<int32_t>(offset);
+    auto bufferSize = BUFFER_HEADER_SIZE + bufferByteCount;
+    return memAccessor_.slice(HEADER_SIZE + bufferIndex * bufferSize, bufferSize);
+  }
+};
+
+} // namespace Xrpa
@@ -23,6 +23,7 @@
 #pragma intrinsic(_InterlockedOr)
 #pragma intrinsic(_InterlockedExchange)
 #pragma intrinsic(_InterlockedCompareExchange)
+#pragma intrinsic(_InterlockedExchangeAdd)
 #endif
 
 namespace Xrpa {
@@ -63,6 +64,16 @@ inline uint32_t atomicExchange(volatile uint32_t* const ptr, uint32_t value) {
 #endif
 }
 
+// Atomic add with full barrier semantics (returns old value)
+inline uint32_t atomicFetchAdd(volatile uint32_t* const ptr, uint32_t delta) {
+#if defined(_MSC_VER)
+  return static_cast<uint32_t>(
+      _InterlockedExchangeAdd(reinterpret_cast<volatile long*>(ptr), static_cast<long>(delta)));
+#else
+  return __atomic_fetch_add(ptr, delta, __ATOMIC_SEQ_CST);
+#endif
+}
+
 // Atomic compare-and-swap
 // Returns true if exchange succeeded (ptr contained expected value)
 // On failure, expected is updated with the actual value found
@@ -85,4 +96,17 @@ atomicCompareExchange(volatile uint32_t* const ptr, uint32_t* const expected, ui
 #endif
 }
 
+// Spin-wait hint to the CPU, for use in busy-wait loops
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+  __yield();
+#elif defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
 } // namespace Xrpa
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DeadlineScheduler.h"
+
+#include <algorithm>
+
+namespace Xrpa {
+
+void DeadlineScheduler::addTask(
+    const std::string& name,
+    std::chrono::nanoseconds period,
+    std::function<void()> callback,
+    std::chrono::nanoseconds deadline) {
+  period = std::max(period, std::chrono::nanoseconds{1});
+  tasks_.push_back({std::move(callback), std::chrono::steady_clock::now()});
+
+  auto& stats = stats_.emplace_back();
+  stats.name = name;
+  stats.period = period;
+  stats.deadline = deadline.count() > 0 ? deadline : period;
+}
+
+void DeadlineScheduler::addTaskAtRate(
+    const std::string& name,
+    double ratePerSecond,
+    std::function<void()> callback) {
+  addTask(
+      name,
+      std::chrono::nanoseconds(static_cast<int64_t>(1e9 / ratePerSecond)),
+      std::move(callback));
+}
+
+void DeadlineScheduler::removeTask(const std::string& name) {
+  for (size_t i = 0; i < stats_.size();) {
+    if (stats_[i].name == name) {
+      tasks_.erase(tasks_.begin() + i);
+      stats_.erase(stats_.begin() + i);
+    } else {
+      ++i;
+    }
+  }
+}
+
+void DeadlineScheduler::run(const std::function<bool()>& shouldContinue) {
+  // start everything on the same release time so that equal rates stay in phase
+  auto startTime = std::chrono::steady_clock::now();
+  for (auto& task : tasks_) {
+    task.nextRelease = startTime;
+  }
+
+  while (!tasks_.empty() && shouldContinue()) {
+    auto nextRelease = tasks_[0].nextRelease;
+    for (auto& task : tasks_) {
+      nextRelease = std::min(nextRelease, task.nextRelease);
+    }
+
+    sleepUntil(nextRelease, spinThreshold_);
+
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+      if (tasks_[i].nextRelease <= std::chrono::steady_clock::now()) {
+        runTask(i);
+      }
+    }
+  }
+}
+
+void DeadlineScheduler::runTask(size_t taskIndex) {
+  auto& task = tasks_[taskIndex];
+  auto& stats = stats_[taskIndex];
+  auto release = task.nextRelease;
+
+  auto startTime = std::chrono::steady_clock::now();
+  task.callback();
+  auto endTime = std::chrono::steady_clock::now();
+
+  auto startJitter = startTime - release;
+  auto runTime = endTime - startTime;
+  stats.runCount++;
+  stats.totalStartJitter += startJitter;
+  stats.maxStartJitter = std::max(stats.maxStartJitter, startJitter);
+  stats.maxRunTime = std::max(stats.maxRunTime, runTime);
+  if (endTime > release + stats.deadline) {
+    stats.overrunCount++;
+  }
+
+  // a single late release is run immediately to catch up, but rather than bursting through a
+  // backlog of releases the task drops any that are more than a full period behind
+  task.nextRelease = release + stats.period;
+  while (task.nextRelease + stats.period <= endTime) {
+    task.nextRelease += stats.period;
+    stats.skippedCount++;
+  }
+}
+
+void DeadlineScheduler::resetTaskStats() {
+  for (auto& stats : stats_) {
+    stats.runCount = 0;
+    stats.overrunCount = 0;
+    stats.skippedCount = 0;
+    stats.maxStartJitter = {};
+    stats.totalStartJitter = {};
+    stats.maxRunTime = {};
+  }
+}
+
+void DeadlineScheduler::dumpTaskStats(std::ostream& out) const {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  for (auto& stats : stats_) {
+    out << "[DeadlineScheduler] " << stats.name
+        << ": period=" << duration_cast<microseconds>(stats.period).count() << "us"
+        << " runs=" << stats.runCount << " overruns=" << stats.overrunCount
+        << " skipped=" << stats.skippedCount
+        << " jitterMean=" << duration_cast<microseconds>(stats.getMeanStartJitter()).count()
+        << "us jitterMax=" << duration_cast<microseconds>(stats.maxStartJitter).count()
+        << "us runMax=" << duration_cast<microseconds>(stats.maxRunTime).count() << "us\n";
+  }
+}
+
+} // namespace Xrpa
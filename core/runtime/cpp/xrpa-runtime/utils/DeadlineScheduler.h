@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <xrpa-runtime/utils/TimeUtils.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Xrpa {
+
+struct ScheduledTaskStats {
+  std::string name;
+  std::chrono::nanoseconds period{};
+  std::chrono::nanoseconds deadline{};
+
+  uint64_t runCount = 0;
+
+  // runs that finished after their release time plus deadline
+  uint64_t overrunCount = 0;
+
+  // releases dropped because the task was still more than a full period behind
+  uint64_t skippedCount = 0;
+
+  // start jitter is how late a run started relative to its release time
+  std::chrono::nanoseconds maxStartJitter{};
+  std::chrono::nanoseconds totalStartJitter{};
+
+  std::chrono::nanoseconds maxRunTime{};
+
+  [[nodiscard]] std::chrono::nanoseconds getMeanStartJitter() const {
+    if (runCount == 0) {
+      return {};
+    }
+    return totalStartJitter / static_cast<int64_t>(runCount);
+  }
+};
+
+// Runs a set of periodic tasks, each at its own rate, from a single thread. The thread sleeps on
+// the absolute release time of the next due task rather than on a relative frame time, so task
+// run time does not accumulate as drift. Tasks due at the same time run in registration order.
+class DeadlineScheduler {
+ public:
+  // deadline is relative to each release time; a zero deadline means the task's period
+  void addTask(
+      const std::string& name,
+      std::chrono::nanoseconds period,
+      std::function<void()> callback,
+      std::chrono::nanoseconds deadline = std::chrono::nanoseconds{0});
+
+  void addTaskAtRate(const std::string& name, double ratePerSecond, std::function<void()> callback);
+
+  void removeTask(const std::string& name);
+
+  // how much of each sleep is spent spinning for accuracy instead of sleeping
+  void setSpinThreshold(std::chrono::microseconds spinThreshold) {
+    spinThreshold_ = spinThreshold;
+  }
+
+  // runs tasks until shouldContinue returns false, which is checked before every sleep
+  void run(const std::function<bool()>& shouldContinue);
+
+  [[nodiscard]] const std::vector<ScheduledTaskStats>& getTaskStats() const {
+    return stats_;
+  }
+
+  void resetTaskStats();
+
+  void dumpTaskStats(std::ostream& out) const;
+
+ private:
+  struct Task {
+    std::function<void()> callback;
+    std::chrono::steady_clock::time_point nextRelease;
+  };
+
+  std::vector<Task> tasks_;
+  std::vector<ScheduledTaskStats> stats_;
+  std::chrono::microseconds spinThreshold_ = kDefaultSleepSpinThreshold;
+
+  void runTask(size_t taskIndex);
+};
+
+} // namespace Xrpa
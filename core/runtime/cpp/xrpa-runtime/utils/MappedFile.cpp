@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/utils/MappedFile.h>
+
+#if defined(WIN32)
+#include <Windows.h>
+#ifdef TEXT
+#undef TEXT // undefine UE4 macro, if defined
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#elif defined(__APPLE__) || defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Xrpa {
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+#if defined(WIN32)
+
+bool MappedFile::openForWrite(const std::string& filePath, size_t byteCount) {
+  close();
+  fileHandle_ = CreateFileA(
+      filePath.c_str(),
+      GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ,
+      nullptr,
+      CREATE_ALWAYS,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+  if (fileHandle_ == INVALID_HANDLE_VALUE) {
+    fileHandle_ = nullptr;
+    return false;
+  }
+  isWritable_ = true;
+  if (!setFileSize(byteCount) || !map()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::openForRead(const std::string& filePath) {
+  close();
+  fileHandle_ = CreateFileA(
+      filePath.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+  if (fileHandle_ == INVALID_HANDLE_VALUE) {
+    fileHandle_ = nullptr;
+    return false;
+  }
+  isWritable_ = false;
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(fileHandle_, &fileSize) || fileSize.QuadPart == 0) {
+    close();
+    return false;
+  }
+  size_ = static_cast<size_t>(fileSize.QuadPart);
+  if (!map()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::close() {
+  unmap();
+  if (fileHandle_ != nullptr) {
+    CloseHandle(fileHandle_);
+    fileHandle_ = nullptr;
+  }
+  size_ = 0;
+}
+
+bool MappedFile::setFileSize(size_t byteCount) {
+  LARGE_INTEGER distance;
+  distance.QuadPart = static_cast<LONGLONG>(byteCount);
+  if (!SetFilePointerEx(fileHandle_, distance, nullptr, FILE_BEGIN) ||
+      !SetEndOfFile(fileHandle_)) {
+    return false;
+  }
+  size_ = byteCount;
+  return true;
+}
+
+bool MappedFile::map() {
+  mappingHandle_ = CreateFileMappingA(
+      fileHandle_, nullptr, isWritable_ ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+  if (mappingHandle_ == nullptr) {
+    return false;
+  }
+  data_ = static_cast<uint8_t*>(
+      MapViewOfFile(mappingHandle_, isWritable_ ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size_));
+  return data_ != nullptr;
+}
+
+void MappedFile::unmap() {
+  if (data_ != nullptr) {
+    if (isWritable_) {
+      FlushViewOfFile(data_, size_);
+    }
+    UnmapViewOfFile(data_);
+    data_ = nullptr;
+  }
+  if (mappingHandle_ != nullptr) {
+    CloseHandle(mappingHandle_);
+    mappingHandle_ = nullptr;
+  }
+}
+
+#elif defined(__APPLE__) || defined(__linux__)
+
+bool MappedFile::openForWrite(const std::string& filePath, size_t byteCount) {
+  close();
+  fd_ = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+  isWritable_ = true;
+  if (!setFileSize(byteCount) || !map()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::openForRead(const std::string& filePath) {
+  close();
+  fd_ = open(filePath.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    return false;
+  }
+  isWritable_ = false;
+  struct stat fileStat {};
+  if (fstat(fd_, &fileStat) != 0 || fileStat.st_size == 0) {
+    close();
+    return false;
+  }
+  size_ = static_cast<size_t>(fileStat.st_size);
+  if (!map()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::close() {
+  unmap();
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  size_ = 0;
+}
+
+bool MappedFile::setFileSize(size_t byteCount) {
+  if (ftruncate(fd_, static_cast<off_t>(byteCount)) != 0) {
+    return false;
+  }
+  size_ = byteCount;
+  return true;
+}
+
+bool MappedFile::map() {
+  auto* mem = mmap(
+      nullptr, size_, isWritable_ ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<uint8_t*>(mem);
+  return true;
+}
+
+void MappedFile::unmap() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+    data_ = nullptr;
+  }
+}
+
+#endif
+
+bool MappedFile::resize(size_t byteCount) {
+  if (!isWritable_ || !isOpen()) {
+    return false;
+  }
+  auto oldSize = size_;
+  unmap();
+  if (!setFileSize(byteCount)) {
+    // put the old mapping back, so the file stays usable at its old size
+    size_ = oldSize;
+    map();
+    return false;
+  }
+  return map();
+}
+
+} // namespace Xrpa
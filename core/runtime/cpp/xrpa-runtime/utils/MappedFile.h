@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Xrpa {
+
+// A file mapped into memory, for data that outlives the process (captures, for instance) rather
+// than shared memory, which is unlinked with its last user.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // creates (or truncates) the file at byteCount bytes and maps it read-write
+  bool openForWrite(const std::string& filePath, size_t byteCount);
+
+  // maps the whole of an existing file read-only
+  bool openForRead(const std::string& filePath);
+
+  // grows or shrinks a file opened for write; the file is remapped, so pointers previously
+  // returned by data() are invalidated
+  bool resize(size_t byteCount);
+
+  // flushes and unmaps the file
+  void close();
+
+  [[nodiscard]] bool isOpen() const {
+    return data_ != nullptr;
+  }
+
+  [[nodiscard]] uint8_t* data() const {
+    return data_;
+  }
+
+  [[nodiscard]] size_t size() const {
+    return size_;
+  }
+
+ private:
+  bool setFileSize(size_t byteCount);
+  bool map();
+  void unmap();
+
+#if defined(WIN32)
+  void* fileHandle_ = nullptr;
+  void* mappingHandle_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  bool isWritable_ = false;
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+} // namespace Xrpa
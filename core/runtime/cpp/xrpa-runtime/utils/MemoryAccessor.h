@@ -45,6 +45,10 @@ class MemoryOffset {
   }
 
   int32_t offset_;
+
+  // set once variable-length data has been accessed, as the record extent check done in
+  // XRPA_BOUNDS_CHECK_CHECKED_ONCE mode no longer covers the fields that follow
+  bool pastVariableLengthData_ = false;
 };
 
 class MemoryAccessor {
@@ -82,7 +86,7 @@ class MemoryAccessor {
     if (size < 0) {
       size = 0;
     }
-    xrpaDebugBoundsAssert(offset, size, 0, size_);
+    assertRecordBounds(offset, size);
     return {memPtr_, offset_ + offset, size};
   }
 
@@ -113,71 +117,103 @@ class MemoryAccessor {
     std::memcpy(memPtr_ + offset_, ptr, size_);
   }
 
+  // Validates that byteCount bytes of fixed-size fields can be accessed from the start of this
+  // record. Only does anything in XRPA_BOUNDS_CHECK_CHECKED_ONCE mode, where it replaces the
+  // per-field checks; generated readers call it once per change event.
+  void checkRecordExtent(int32_t byteCount) const {
+    if constexpr (kBoundsCheckMode == BoundsCheckMode::CheckedOnce) {
+      xrpaDebugBoundsAssert(0, byteCount, 0, size_);
+    }
+  }
+
   template <typename T>
   [[nodiscard]] T readValue(MemoryOffset& pos) const {
-    xrpaDebugBoundsAssert(pos.offset_, sizeof(T), 0, size_);
+    assertFieldBounds(pos, sizeof(T));
     return *reinterpret_cast<T*>(memPtr_ + offset_ + pos.advance(sizeof(T)));
   }
 
-  template <>
-  [[nodiscard]] std::string readValue<std::string>(MemoryOffset& pos) const {
-    auto byteCount = readValue<int32_t>(pos);
-
-    xrpaDebugBoundsAssert(pos.offset_, byteCount, 0, size_);
-    return std::string(
-        reinterpret_cast<char*>(memPtr_ + offset_ + pos.advance(byteCount)), byteCount);
-  }
-
-  template <>
-  [[nodiscard]] ByteVector readValue<ByteVector>(MemoryOffset& pos) const {
-    auto byteCount = readValue<int32_t>(pos);
-
-    xrpaDebugBoundsAssert(pos.offset_, byteCount, 0, size_);
-    ByteVector ret(byteCount);
-    std::memcpy(ret.data(), memPtr_ + offset_ + pos.advance(byteCount), byteCount);
-    return ret;
-  }
-
   template <typename T>
   void writeValue(const T& val, MemoryOffset& pos) const {
-    xrpaDebugBoundsAssert(pos.offset_, sizeof(T), 0, size_);
+    assertFieldBounds(pos, sizeof(T));
     *reinterpret_cast<T*>(memPtr_ + offset_ + pos.advance(sizeof(T))) = val;
   }
 
-  template <>
-  void writeValue<std::string>(const std::string& val, MemoryOffset& pos) const {
-    int32_t byteCount = val.size();
-    writeValue<int32_t>(byteCount, pos);
-
-    xrpaDebugBoundsAssert(pos.offset_, byteCount, 0, size_);
-    std::memcpy(memPtr_ + offset_ + pos.advance(byteCount), val.data(), byteCount);
-  }
-
-  template <>
-  void writeValue<ByteVector>(const ByteVector& val, MemoryOffset& pos) const {
-    int32_t byteCount = val.size();
-    writeValue<int32_t>(byteCount, pos);
-
-    xrpaDebugBoundsAssert(pos.offset_, byteCount, 0, size_);
-    std::memcpy(memPtr_ + offset_ + pos.advance(byteCount), val.data(), byteCount);
-  }
-
   template <typename T>
   [[nodiscard]] static int32_t dynSizeOfValue(const T& /*val*/) {
     return 0;
   }
 
   void* getRawPointer(int32_t pos, int32_t maxBytes) {
-    xrpaDebugBoundsAssert(pos, maxBytes, 0, size_);
+    assertRecordBounds(pos, maxBytes);
     return memPtr_ + offset_ + pos;
   }
 
  private:
+  void assertFieldBounds(const MemoryOffset& pos, int32_t byteCount) const {
+    if constexpr (kBoundsCheckMode == BoundsCheckMode::Checked) {
+      xrpaDebugBoundsAssert(pos.offset_, byteCount, 0, size_);
+    } else if constexpr (kBoundsCheckMode == BoundsCheckMode::CheckedOnce) {
+      if (pos.pastVariableLengthData_) {
+        xrpaDebugBoundsAssert(pos.offset_, byteCount, 0, size_);
+      }
+    }
+  }
+
+  void assertRecordBounds(int32_t offset, int32_t byteCount) const {
+    if constexpr (kBoundsCheckMode != BoundsCheckMode::Unchecked) {
+      xrpaDebugBoundsAssert(offset, byteCount, 0, size_);
+    }
+  }
+
   uint8_t* memPtr_ = nullptr;
   int32_t offset_ = 0;
   int32_t size_ = 0;
 };
 
+// explicit specializations must live at namespace scope to be portable to gcc
+template <>
+[[nodiscard]] inline std::string MemoryAccessor::readValue<std::string>(MemoryOffset& pos) const {
+  auto byteCount = readValue<int32_t>(pos);
+
+  pos.pastVariableLengthData_ = true;
+  assertRecordBounds(pos.offset_, byteCount);
+  return std::string(
+      reinterpret_cast<char*>(memPtr_ + offset_ + pos.advance(byteCount)), byteCount);
+}
+
+template <>
+[[nodiscard]] inline ByteVector MemoryAccessor::readValue<ByteVector>(MemoryOffset& pos) const {
+  auto byteCount = readValue<int32_t>(pos);
+
+  pos.pastVariableLengthData_ = true;
+  assertRecordBounds(pos.offset_, byteCount);
+  ByteVector ret(byteCount);
+  std::memcpy(ret.data(), memPtr_ + offset_ + pos.advance(byteCount), byteCount);
+  return ret;
+}
+
+template <>
+inline void MemoryAccessor::writeValue<std::string>(const std::string& val, MemoryOffset& pos)
+    const {
+  int32_t byteCount = val.size();
+  writeValue<int32_t>(byteCount, pos);
+
+  pos.pastVariableLengthData_ = true;
+  assertRecordBounds(pos.offset_, byteCount);
+  std::memcpy(memPtr_ + offset_ + pos.advance(byteCount), val.data(), byteCount);
+}
+
+template <>
+inline void MemoryAccessor::writeValue<ByteVector>(const ByteVector& val, MemoryOffset& pos)
+    const {
+  int32_t byteCount = val.size();
+  writeValue<int32_t>(byteCount, pos);
+
+  pos.pastVariableLengthData_ = true;
+  assertRecordBounds(pos.offset_, byteCount);
+  std::memcpy(memPtr_ + offset_ + pos.advance(byteCount), val.data(), byteCount);
+}
+
 template <>
 [[nodiscard]] inline int32_t MemoryAccessor::dynSizeOfValue<std::string>(const std::string& val) {
   return val.size();
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <xrpa-runtime/utils/MirroredMapping.h>
+
+#if defined(WIN32)
+#include <Windows.h>
+#ifdef TEXT
+#undef TEXT // undefine UE4 macro, if defined
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#elif defined(__APPLE__) || defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Xrpa {
+
+int32_t getMemoryPageSize() {
+#if defined(WIN32)
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  return static_cast<int32_t>(systemInfo.dwPageSize);
+#else
+  return static_cast<int32_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+#if defined(__linux__)
+
+uint8_t* mapFileWithMirror(
+    int fd,
+    size_t fileByteCount,
+    size_t mirrorOffset,
+    size_t mirrorByteCount,
+    bool prefault) {
+  auto mirrorEnd = mirrorOffset + mirrorByteCount;
+  auto byteCount = fileByteCount + mirrorByteCount;
+
+  // reserve the whole range up front, so that the pieces land back to back
+  void* reserved = mmap(nullptr, byteCount, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED) {
+    return nullptr;
+  }
+  auto* mem = static_cast<uint8_t*>(reserved);
+
+  int mapFlags = MAP_SHARED | MAP_FIXED;
+  if (prefault) {
+    mapFlags |= MAP_POPULATE;
+  }
+  auto mapPiece = [&](uint8_t* addr, size_t pieceByteCount, size_t fileOffset) {
+    if (pieceByteCount == 0) {
+      return true;
+    }
+    void* piece = mmap(
+        addr, pieceByteCount, PROT_READ | PROT_WRITE, mapFlags, fd, static_cast<off_t>(fileOffset));
+    return piece != MAP_FAILED;
+  };
+
+  bool didMap = mapPiece(mem, mirrorEnd, 0) &&
+      mapPiece(mem + mirrorEnd, mirrorByteCount, mirrorOffset) &&
+      mapPiece(mem + mirrorEnd + mirrorByteCount, fileByteCount - mirrorEnd, mirrorEnd);
+  if (!didMap) {
+    munmap(mem, byteCount);
+    return nullptr;
+  }
+  return mem;
+}
+
+uint8_t* mapMemoryWithMirror(
+    size_t fileByteCount,
+    size_t mirrorOffset,
+    size_t mirrorByteCount,
+    bool prefault) {
+  int fd = memfd_create("xrpa_mirror", MFD_CLOEXEC);
+  if (fd == -1) {
+    return nullptr;
+  }
+  uint8_t* mem = nullptr;
+  if (ftruncate(fd, static_cast<off_t>(fileByteCount)) == 0) {
+    mem = mapFileWithMirror(fd, fileByteCount, mirrorOffset, mirrorByteCount, prefault);
+  }
+  // the mappings keep the memory alive
+  close(fd);
+  return mem;
+}
+
+void unmapWithMirror(uint8_t* mem, size_t byteCount) {
+  if (mem != nullptr) {
+    munmap(mem, byteCount);
+  }
+}
+
+#else
+
+uint8_t* mapFileWithMirror(
+    int /*fd*/,
+    size_t /*fileByteCount*/,
+    size_t /*mirrorOffset*/,
+    size_t /*mirrorByteCount*/,
+    bool /*prefault*/) {
+  return nullptr;
+}
+
+uint8_t* mapMemoryWithMirror(
+    size_t /*fileByteCount*/,
+    size_t /*mirrorOffset*/,
+    size_t /*mirrorByteCount*/,
+    bool /*prefault*/) {
+  return nullptr;
+}
+
+void unmapWithMirror(uint8_t* /*mem*/, size_t /*byteCount*/) {}
+
+#endif
+
+} // namespace Xrpa
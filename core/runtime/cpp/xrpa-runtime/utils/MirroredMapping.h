@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Xrpa {
+
+// Mappings in which one range of memory appears twice, back to back, so that a ring buffer over
+// that range can have its elements run on past the end of the ring into the mirror instead of
+// wrapping. Only supported on Linux; elsewhere the map functions fail and callers fall back to
+// plain memory, where the mirror is simply extra space.
+
+// the granularity of mappings, which mirrored ranges must be aligned to
+int32_t getMemoryPageSize();
+
+// Maps the first fileByteCount bytes of fd read-write and shared, with the range
+// [mirrorOffset, mirrorOffset + mirrorByteCount) mapped a second time right after itself and the
+// rest of the file following the mirror. The mapping spans fileByteCount + mirrorByteCount bytes.
+// Offsets and sizes must be page-aligned. Returns nullptr on failure.
+uint8_t* mapFileWithMirror(
+    int fd,
+    size_t fileByteCount,
+    size_t mirrorOffset,
+    size_t mirrorByteCount,
+    bool prefault);
+
+// like mapFileWithMirror(), for process-private memory backed by an anonymous memfd
+uint8_t* mapMemoryWithMirror(
+    size_t fileByteCount,
+    size_t mirrorOffset,
+    size_t mirrorByteCount,
+    bool prefault);
+
+// unmaps the whole of a mapping returned by the functions above, given its full size
+void unmapWithMirror(uint8_t* mem, size_t byteCount);
+
+} // namespace Xrpa
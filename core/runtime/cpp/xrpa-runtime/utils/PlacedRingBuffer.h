@@ -18,6 +18,7 @@
 
 #include <xrpa-runtime/utils/MemoryAccessor.h>
 #include <xrpa-runtime/utils/XrpaUtils.h>
+#include <algorithm>
 #include <cstdint>
 
 namespace Xrpa {
@@ -27,6 +28,38 @@ namespace Xrpa {
 #define PRB_POOL_START (reinterpret_cast<uint8_t*>(this) + sizeof(PlacedRingBuffer))
 #define PRB_POOL_START_CONST (reinterpret_cast<const uint8_t*>(this) + sizeof(PlacedRingBuffer))
 
+#define PRBI_OFFSETS (reinterpret_cast<int32_t*>(this + 1))
+#define PRBI_OFFSETS_CONST (reinterpret_cast<const int32_t*>(this + 1))
+
+// Offsets of the most recently pushed elements of a PlacedRingBuffer, keyed by ID modulo capacity,
+// for constant-time lookup by ID. It is placed apart from the ring buffer, leaving the ring buffer
+// layout untouched, and is kept up to date by passing it to push().
+struct PlacedRingBufferIndex {
+  int32_t capacity;
+
+  static int32_t getMemSize(int32_t capacityIn) {
+    return sizeof(PlacedRingBufferIndex) + capacityIn * static_cast<int32_t>(sizeof(int32_t));
+  }
+
+  void init(int32_t capacityIn) {
+    capacity = capacityIn;
+    std::fill_n(PRBI_OFFSETS, capacity, 0);
+  }
+
+  void setOffset(int32_t id, int32_t offset) {
+    PRBI_OFFSETS[id % capacity] = offset;
+  }
+
+  // the slot for id has not been reused as long as no ID capacity or more past it was pushed
+  [[nodiscard]] bool hasOffset(int32_t id, int32_t maxID) const {
+    return maxID - id < capacity;
+  }
+
+  [[nodiscard]] int32_t getOffset(int32_t id) const {
+    return PRBI_OFFSETS_CONST[id % capacity];
+  }
+};
+
 struct PlacedRingBuffer {
   static constexpr int32_t ELEMENT_HEADER_SIZE = 4;
 
@@ -35,7 +68,8 @@ struct PlacedRingBuffer {
   int32_t startID;
   int32_t startOffset;
   int32_t lastElemOffset;
-  int32_t prewrapOffset; // offset past which the ring buffer is wrapped
+  // offset past which the ring buffer is wrapped; twice poolSize for a mirrored ring buffer
+  int32_t prewrapOffset;
 
   static int32_t getMemSize(int32_t poolSizeIn) {
     return sizeof(PlacedRingBuffer) + poolSizeIn;
@@ -50,8 +84,32 @@ struct PlacedRingBuffer {
     prewrapOffset = poolSize;
   }
 
+  // For a pool that is immediately followed in memory by a mirror of itself (see
+  // MirroredMapping.h), elements never wrap early: they run on past the end of the pool into the
+  // mirror, so every element is contiguous and no space is skipped at the end of the pool. Readers
+  // without the mirror mapped still see every element whole, only at the cost of the extra memory.
+  void initMirrored(int32_t poolSizeIn) {
+    init(poolSizeIn);
+    prewrapOffset = 2 * poolSize;
+  }
+
+  [[nodiscard]] bool isMirrored() const {
+    return prewrapOffset > poolSize;
+  }
+
   void reset() {
-    init(poolSize);
+    if (isMirrored()) {
+      initMirrored(poolSize);
+    } else {
+      init(poolSize);
+    }
+  }
+
+  // empties the ring buffer but continues numbering after lastID, so that readers which had not
+  // yet read up to lastID see missed entries
+  void resetAfterID(int32_t lastID) {
+    reset();
+    startID = lastID + 1;
   }
 
   // returns an accessor to the element at the given index from the start of the ring buffer
@@ -60,15 +118,17 @@ struct PlacedRingBuffer {
       return {};
     }
 
-    int32_t offset = getOffsetForIndex(index);
+    int32_t offset = getOffsetForID(startID + index, nullptr);
     return getElementAccessor(offset);
   }
 
-  [[nodiscard]] MemoryAccessor getByID(int32_t id) {
+  // constant time when the element is covered by index, otherwise linear in its distance from
+  // the start of the ring buffer
+  [[nodiscard]] MemoryAccessor getByID(int32_t id, const PlacedRingBufferIndex* index = nullptr) {
     if (id < startID || id > getMaxID()) {
       return {};
     }
-    return getAt(getIndexForID(id));
+    return getElementAccessor(getOffsetForID(id, index));
   }
 
   [[nodiscard]] int32_t getID(int32_t index) const {
@@ -90,9 +150,56 @@ struct PlacedRingBuffer {
     return startID + count - 1;
   }
 
+  // bytes of the pool occupied by elements, including their headers and any space skipped at the
+  // end of the pool when the ring wrapped
+  [[nodiscard]] int32_t getUsedBytes() const {
+    if (count == 0) {
+      return 0;
+    }
+    int32_t endOffset = lastElemOffset + ELEMENT_HEADER_SIZE + getElementSize(lastElemOffset);
+    if (endOffset > startOffset) {
+      return endOffset - startOffset;
+    }
+    if (isMirrored()) {
+      return (poolSize - startOffset) + endOffset;
+    }
+    return (prewrapOffset - startOffset) + endOffset;
+  }
+
+  // Enlarges the pool in place, for a ring buffer whose memory extends past poolSize. Elements
+  // keep their offsets, so iterators are unaffected. If the ring has wrapped, the new space only
+  // comes into use once the start of the ring has wrapped around as well.
+  // Mirrored ring buffers cannot grow, as the mirror is mapped at the end of the pool.
+  void grow(int32_t newPoolSize) {
+    if (newPoolSize <= poolSize || isMirrored()) {
+      return;
+    }
+    bool isWrapped = count > 0 && lastElemOffset < startOffset;
+    if (!isWrapped) {
+      prewrapOffset = newPoolSize;
+    }
+    poolSize = newPoolSize;
+  }
+
+  // whether an element of numBytes can be pushed at all, given room enough
+  [[nodiscard]] bool canFit(int32_t numBytes) const {
+    return ELEMENT_HEADER_SIZE + PRB_ALIGN(numBytes) < poolSize;
+  }
+
   // allocates space in the ring buffer at the end, shifting out the oldest data if needed
   // returns the monotonically-increasing ID of the newly-added value in idOut
-  [[nodiscard]] MemoryAccessor push(int32_t numBytes, int32_t* idOut) {
+  // records the offset of the new element in index, if given
+  [[nodiscard]] MemoryAccessor
+  push(int32_t numBytes, int32_t* idOut, PlacedRingBufferIndex* index = nullptr) {
+    return pushRetaining(numBytes, idOut, INT32_MAX, index);
+  }
+
+  // like push(), but fails rather than shift out any element with an ID above retainAfterId
+  [[nodiscard]] MemoryAccessor pushRetaining(
+      int32_t numBytes,
+      int32_t* idOut,
+      int32_t retainAfterId,
+      PlacedRingBufferIndex* index = nullptr) {
     // validateEntries();
 
     numBytes = PRB_ALIGN(numBytes);
@@ -104,6 +211,9 @@ struct PlacedRingBuffer {
 
     int32_t offset = 0;
     for (offset = findFreeOffset(sizeNeeded); offset < 0; offset = findFreeOffset(sizeNeeded)) {
+      if (startID > retainAfterId) {
+        return {};
+      }
       // free oldest element to make room
       shift();
     }
@@ -112,6 +222,9 @@ struct PlacedRingBuffer {
     if (idOut != nullptr) {
       *idOut = startID + count - 1;
     }
+    if (index != nullptr) {
+      index->setOffset(startID + count - 1, offset);
+    }
 
     setElementSize(offset, numBytes);
     lastElemOffset = offset;
@@ -138,6 +251,9 @@ struct PlacedRingBuffer {
       // shifting start past the wrap-point, so reset the offset and prewrapOffset
       startOffset = 0;
       prewrapOffset = poolSize;
+    } else if (startOffset >= poolSize) {
+      // the element ran on into the mirror
+      startOffset -= poolSize;
     }
 
     startID++;
@@ -146,7 +262,9 @@ struct PlacedRingBuffer {
     if (count == 0) {
       startOffset = 0;
       lastElemOffset = 0;
-      prewrapOffset = poolSize;
+      if (!isMirrored()) {
+        prewrapOffset = poolSize;
+      }
     }
 
     // validateEntries();
@@ -155,6 +273,16 @@ struct PlacedRingBuffer {
   }
 
   void validateEntries() {
+    if (isMirrored()) {
+      int32_t offset = startOffset;
+      for (int32_t i = 0; i < count; ++i) {
+        xrpaDebugBoundsAssert(offset, ELEMENT_HEADER_SIZE, 0, poolSize);
+        offset = getNextOffset(offset);
+      }
+      xrpaDebugAssert(getUsedBytes() <= poolSize, "Mirrored ring buffer overlaps itself");
+      return;
+    }
+
     int32_t offset = startOffset;
     bool isWrapped = false;
     for (int32_t i = 0; i < count; ++i) {
@@ -194,17 +322,27 @@ struct PlacedRingBuffer {
 
   [[nodiscard]] MemoryAccessor getElementAccessor(int32_t offset) {
     int32_t numBytes = getElementSize(offset);
-    xrpaDebugBoundsAssert(offset, ELEMENT_HEADER_SIZE + numBytes, 0, poolSize);
+    // elements of a mirrored ring buffer may extend into the mirror
+    xrpaDebugBoundsAssert(
+        offset, ELEMENT_HEADER_SIZE + numBytes, 0, isMirrored() ? prewrapOffset : poolSize);
     return {PRB_POOL_START, offset + ELEMENT_HEADER_SIZE, numBytes};
   }
 
+  // id must be in the ring buffer
+  [[nodiscard]] int32_t getOffsetForID(int32_t id, const PlacedRingBufferIndex* index) const {
+    if (id == getMaxID()) {
+      return lastElemOffset;
+    }
+    if (index != nullptr && index->hasOffset(id, getMaxID())) {
+      return index->getOffset(id);
+    }
+    return getOffsetForIndex(id - startID);
+  }
+
   [[nodiscard]] int32_t getOffsetForIndex(int32_t index) const {
     int32_t offset = startOffset;
     for (int32_t i = 0; i < index; ++i) {
-      offset += ELEMENT_HEADER_SIZE + getElementSize(offset);
-      if (offset >= prewrapOffset) {
-        offset = 0;
-      }
+      offset = getNextOffset(offset);
     }
     return offset;
   }
@@ -214,6 +352,9 @@ struct PlacedRingBuffer {
     offset += ELEMENT_HEADER_SIZE + numBytes;
     if (offset >= prewrapOffset) {
       offset = 0;
+    } else if (offset >= poolSize) {
+      // the element ran on into the mirror
+      offset -= poolSize;
     }
     return offset;
   }
@@ -227,6 +368,13 @@ struct PlacedRingBuffer {
 
     int32_t offset = lastElemOffset + ELEMENT_HEADER_SIZE + getElementSize(lastElemOffset);
 
+    if (isMirrored()) {
+      if (poolSize - getUsedBytes() < sizeNeeded) {
+        return -1;
+      }
+      return offset >= poolSize ? offset - poolSize : offset;
+    }
+
     if (startOffset < offset) {
       // check if there is space between the last element and the end of the buffer
       if (poolSize - offset >= sizeNeeded) {
@@ -278,11 +426,33 @@ class PlacedRingBufferIterator {
     return ringBuffer->getElementAccessor(lastReadOffset_);
   }
 
+  [[nodiscard]] int32_t getLastReadId() const {
+    return lastReadId_;
+  }
+
   void setToEnd(const PlacedRingBuffer* ringBuffer) {
     lastReadId_ = ringBuffer->getMaxID();
     lastReadOffset_ = ringBuffer->lastElemOffset;
   }
 
+  // positions the iterator so that the next entry returned is the one following id; fails if that
+  // entry has already been evicted from the ring buffer
+  bool setToId(
+      const PlacedRingBuffer* ringBuffer,
+      int32_t id,
+      const PlacedRingBufferIndex* index = nullptr) {
+    if (id < ringBuffer->startID - 1 || id > ringBuffer->getMaxID()) {
+      return false;
+    }
+    lastReadId_ = id;
+    if (id < ringBuffer->startID) {
+      lastReadOffset_ = ringBuffer->startOffset;
+    } else {
+      lastReadOffset_ = ringBuffer->getOffsetForID(id, index);
+    }
+    return true;
+  }
+
  private:
   int32_t lastReadId_ = -1;
   int32_t lastReadOffset_ = 0;
@@ -20,6 +20,7 @@
 #include <xrpa-runtime/utils/MemoryAccessor.h>
 #include <xrpa-runtime/utils/XrpaUtils.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 
@@ -38,7 +39,7 @@ class SpmcRingBufferIterator;
  * 0       | 4    | poolSize (total memory after header)
  * 4       | 4    | blockSize (aligned size of each block, includes 4-byte header)
  * 8       | 4    | blockCount (number of blocks)
- * 12      | 4    | (padding/reserved)
+ * 12      | 4    | producerToken (atomic uint32, 0 = no producer has claimed the buffer)
  * 16      | 4    | writeIndex (atomic uint32, monotonically increasing)
  * 20      | 4    | minReadIndex (atomic uint32, minimum valid read index)
  * 24      | ...  | Block pool starts here
@@ -93,7 +94,7 @@ class SpmcRingBuffer {
     headerAccessor_.writeValue<int32_t>(poolSize, pos);
     headerAccessor_.writeValue<int32_t>(blockSizeIn, pos);
     headerAccessor_.writeValue<int32_t>(blockCountIn, pos);
-    headerAccessor_.writeValue<int32_t>(0, pos); // reserved
+    headerAccessor_.writeValue<uint32_t>(0, pos); // producerToken
     headerAccessor_.writeValue<uint32_t>(0, pos); // writeIndex
     headerAccessor_.writeValue<uint32_t>(0, pos); // minReadIndex
 
@@ -131,21 +132,127 @@ class SpmcRingBuffer {
     }
 
     uint32_t writeIndex = loadWriteIndex();
-    uint32_t startBlockIndex = writeIndex % static_cast<uint32_t>(blockCount_);
+    uint32_t newWriteIndex = 0;
+    int32_t firstBlockOffset = allocateEntry(writeIndex, dataSize, blocksNeeded, &newWriteIndex);
+
+    // Create MemoryAccessor for the data region
+    // Data starts after the first block's header and spans blocksNeeded blocks
+    int32_t dataOffset = firstBlockOffset + BLOCK_HEADER_SIZE;
+    int32_t maxDataSpace = (blocksNeeded * blockSize_) - BLOCK_HEADER_SIZE;
+    MemoryAccessor dataAccessor = poolAccessor_.slice(dataOffset, maxDataSpace);
+
+    callback(dataAccessor);
+
+    // Update writeIndex after data is written
+    storeWriteIndex(newWriteIndex);
+
+    return true;
+  }
+
+  // Producer: reserve space for an entry without publishing it, for writing a batch of entries in
+  // place. Reserved entries become visible to consumers all at once in commitWrites(). As with
+  // write(), old entries are evicted to make room, including uncommitted ones if the batch is
+  // larger than the whole pool; consumers then see missed entries.
+  // Do not mix with write() while there are uncommitted entries.
+  [[nodiscard]] MemoryAccessor reserve(int32_t dataSize) {
+    if (isNull() || dataSize <= 0) {
+      return {};
+    }
+
+    int32_t blocksNeeded = getBlocksNeeded(dataSize);
+    if (blocksNeeded > blockCount_) {
+      return {};
+    }
+
+    if (!hasPendingWrites_) {
+      pendingWriteIndex_ = loadWriteIndex();
+    }
 
-    // Check if entry would wrap
-    uint32_t endBlockIndex = startBlockIndex + static_cast<uint32_t>(blocksNeeded);
     uint32_t newWriteIndex = 0;
-    int32_t skippedBlocks = 0;
+    int32_t firstBlockOffset =
+        allocateEntry(pendingWriteIndex_, dataSize, blocksNeeded, &newWriteIndex);
+    pendingWriteIndex_ = newWriteIndex;
+    hasPendingWrites_ = true;
+
+    return poolAccessor_.slice(firstBlockOffset + BLOCK_HEADER_SIZE, dataSize);
+  }
+
+  // Producer: claims the buffer for the producer identified by token, which must be nonzero, so
+  // that a second producer is refused rather than corrupting it. steal takes over a claim left by
+  // a producer that has stopped. Returns false if another producer holds the claim.
+  bool claimProducer(uint32_t token, bool steal) {
+    if (isNull()) {
+      return false;
+    }
+    uint32_t holder = atomicLoadAcquire(getProducerTokenPtr());
+    if (holder == token) {
+      return true;
+    }
+    if (holder != 0 && !steal) {
+      return false;
+    }
+    return atomicCompareExchange(getProducerTokenPtr(), &holder, token);
+  }
+
+  [[nodiscard]] bool isProducer(uint32_t token) const {
+    return !isNull() && atomicLoadAcquire(getProducerTokenPtr()) == token;
+  }
+
+  void releaseProducer(uint32_t token) {
+    if (!isNull()) {
+      atomicCompareExchange(getProducerTokenPtr(), &token, 0);
+    }
+  }
+
+  // Producer: publish all entries reserved since the last commit
+  void commitWrites() {
+    if (hasPendingWrites_) {
+      storeWriteIndex(pendingWriteIndex_);
+      hasPendingWrites_ = false;
+    }
+  }
+
+ private:
+  friend class SpmcRingBufferIterator;
+
+  MemoryAccessor memSource_;
+  MemoryAccessor headerAccessor_;
+  MemoryAccessor poolAccessor_;
+
+  int32_t blockSize_ = 0;
+  int32_t blockCount_ = 0;
+
+  // producer-local state for reserve()/commitWrites()
+  uint32_t pendingWriteIndex_ = 0;
+  bool hasPendingWrites_ = false;
 
+  // number of blocks that must be skipped at the end of the pool for an entry starting at
+  // writeIndex to be contiguous
+  [[nodiscard]] uint32_t getWrapBlocks(uint32_t writeIndex, int32_t blocksNeeded) const {
+    uint32_t startBlockIndex = writeIndex % static_cast<uint32_t>(blockCount_);
+    uint32_t endBlockIndex = startBlockIndex + static_cast<uint32_t>(blocksNeeded);
     if (endBlockIndex > static_cast<uint32_t>(blockCount_)) {
+      return static_cast<uint32_t>(blockCount_) - startBlockIndex;
+    }
+    return 0;
+  }
+
+  // Claims the blocks for an entry starting at writeIndex, evicting old entries as needed, and
+  // writes the entry header. Does not publish the entry. Returns the offset of the first block.
+  int32_t allocateEntry(
+      uint32_t writeIndex,
+      int32_t dataSize,
+      int32_t blocksNeeded,
+      uint32_t* newWriteIndexOut) {
+    uint32_t startBlockIndex = writeIndex % static_cast<uint32_t>(blockCount_);
+
+    // Check if entry would wrap
+    int32_t skippedBlocks = static_cast<int32_t>(getWrapBlocks(writeIndex, blocksNeeded));
+    if (skippedBlocks > 0) {
       // Need to wrap - mark remaining blocks as skipped
-      skippedBlocks = blockCount_ - static_cast<int32_t>(startBlockIndex);
       startBlockIndex = 0;
-      newWriteIndex = writeIndex + static_cast<uint32_t>(skippedBlocks + blocksNeeded);
-    } else {
-      newWriteIndex = writeIndex + static_cast<uint32_t>(blocksNeeded);
     }
+    uint32_t newWriteIndex = writeIndex + static_cast<uint32_t>(skippedBlocks + blocksNeeded);
 
     // Update minReadIndex to make room (evict old blocks)
     uint32_t minReadIndex = loadMinReadIndex();
@@ -173,30 +280,10 @@ class SpmcRingBuffer {
     int32_t firstBlockOffset = getBlockOffset(startBlockIndex);
     setBlockDataSize(firstBlockOffset, static_cast<uint32_t>(dataSize));
 
-    // Create MemoryAccessor for the data region
-    // Data starts after the first block's header and spans blocksNeeded blocks
-    int32_t dataOffset = firstBlockOffset + BLOCK_HEADER_SIZE;
-    int32_t maxDataSpace = (blocksNeeded * blockSize_) - BLOCK_HEADER_SIZE;
-    MemoryAccessor dataAccessor = poolAccessor_.slice(dataOffset, maxDataSpace);
-
-    callback(dataAccessor);
-
-    // Update writeIndex after data is written
-    storeWriteIndex(newWriteIndex);
-
-    return true;
+    *newWriteIndexOut = newWriteIndex;
+    return firstBlockOffset;
   }
 
- private:
-  friend class SpmcRingBufferIterator;
-
-  MemoryAccessor memSource_;
-  MemoryAccessor headerAccessor_;
-  MemoryAccessor poolAccessor_;
-
-  int32_t blockSize_ = 0;
-  int32_t blockCount_ = 0;
-
   [[nodiscard]] int32_t getBlockOffset(uint32_t blockIndex) const {
     return static_cast<int32_t>(blockIndex) * blockSize_;
   }
@@ -213,6 +300,11 @@ class SpmcRingBuffer {
     return 1 + ((remaining - 1) / blockSize_) + 1;
   }
 
+  [[nodiscard]] volatile uint32_t* getProducerTokenPtr() const {
+    return reinterpret_cast<volatile uint32_t*>(
+        const_cast<MemoryAccessor&>(headerAccessor_).getRawPointer(12, sizeof(uint32_t)));
+  }
+
   [[nodiscard]] volatile uint32_t* getWriteIndexPtr() const {
     return reinterpret_cast<volatile uint32_t*>(
         const_cast<MemoryAccessor&>(headerAccessor_).getRawPointer(16, sizeof(uint32_t)));
@@ -251,9 +343,14 @@ class SpmcRingBuffer {
         const_cast<MemoryAccessor&>(poolAccessor_).getRawPointer(blockOffset, BLOCK_HEADER_SIZE));
   }
 
+  // the producer's view of the write index, including uncommitted entries
+  [[nodiscard]] uint32_t getProducerWriteIndex() const {
+    return hasPendingWrites_ ? pendingWriteIndex_ : loadWriteIndex();
+  }
+
   // Skip to a valid start block (one with dataSize > 0)
   [[nodiscard]] uint32_t skipToValidBlock(uint32_t startIndex) const {
-    uint32_t writeIndex = loadWriteIndex();
+    uint32_t writeIndex = getProducerWriteIndex();
     while (startIndex < writeIndex) {
       uint32_t blockIndex = startIndex % static_cast<uint32_t>(blockCount_);
       int32_t blockOffset = getBlockOffset(blockIndex);
@@ -269,7 +366,7 @@ class SpmcRingBuffer {
   // Walk through entries starting from currentIndex until we find one at or past targetIndex.
   // This properly handles multi-block entries by advancing by blocksNeeded instead of 1.
   [[nodiscard]] uint32_t skipToValidEntry(uint32_t currentIndex, uint32_t targetIndex) const {
-    uint32_t writeIndex = loadWriteIndex();
+    uint32_t writeIndex = getProducerWriteIndex();
 
     while (currentIndex < writeIndex && currentIndex < targetIndex) {
       uint32_t blockIndex = currentIndex % static_cast<uint32_t>(blockCount_);
@@ -334,11 +431,12 @@ class SpmcRingBufferIterator {
       // Found a valid entry
       int32_t blocksNeeded = ringBuffer->getBlocksNeeded(static_cast<int32_t>(dataSize));
 
-      // Create MemoryAccessor for the data
+      // Create MemoryAccessor for the data, clamped in case the header was overwritten mid-read
       int32_t dataOffset = blockOffset + SpmcRingBuffer::BLOCK_HEADER_SIZE;
       int32_t maxDataSpace =
           (blocksNeeded * ringBuffer->blockSize_) - SpmcRingBuffer::BLOCK_HEADER_SIZE;
-      MemoryAccessor dataAccessor = ringBuffer->poolAccessor_.slice(dataOffset, maxDataSpace);
+      MemoryAccessor dataAccessor = ringBuffer->poolAccessor_.slice(
+          dataOffset, std::min(static_cast<int32_t>(dataSize), maxDataSpace));
 
       callback(dataAccessor);
 
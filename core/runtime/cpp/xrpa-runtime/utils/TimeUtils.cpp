@@ -15,6 +15,8 @@
  */
 
 #include "TimeUtils.h"
+#include <xrpa-runtime/utils/AtomicUtils.h>
+#include <atomic>
 #include <thread>
 
 #ifdef _WIN32
@@ -23,32 +25,103 @@
 #pragma comment(lib, "Winmm.lib")
 #endif // _WIN32
 
-using namespace std::chrono_literals;
+#ifdef __linux__
+#include <time.h>
+#include <cerrno>
+#endif
 
 namespace Xrpa {
 
+namespace {
+
+struct ClockTickSample {
+  int32_t depth = 0;
+  uint64_t clockTimeUs = 0;
+  std::chrono::steady_clock::time_point steadyTime;
+};
+
+thread_local ClockTickSample tickSample;
+
+// latest timestamp handed out by this process, to hold the clock still across a backwards step
+std::atomic<uint64_t> lastClockTimeUs{0};
+
+uint64_t readClockTimeMicroseconds() {
+  auto duration = std::chrono::system_clock::now().time_since_epoch();
+  uint64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+
+  auto lastUs = lastClockTimeUs.load(std::memory_order_relaxed);
+  while (nowUs > lastUs) {
+    if (lastClockTimeUs.compare_exchange_weak(lastUs, nowUs, std::memory_order_relaxed)) {
+      return nowUs;
+    }
+  }
+  return lastUs;
+}
+
+} // namespace
+
+uint64_t getCurrentClockTimeMicroseconds() {
+  if (tickSample.depth > 0) {
+    return tickSample.clockTimeUs;
+  }
+  return readClockTimeMicroseconds();
+}
+
+std::chrono::steady_clock::time_point getCurrentSteadyTime() {
+  if (tickSample.depth > 0) {
+    return tickSample.steadyTime;
+  }
+  return std::chrono::steady_clock::now();
+}
+
+ClockTickScope::ClockTickScope() {
+  if (tickSample.depth++ == 0) {
+    tickSample.clockTimeUs = readClockTimeMicroseconds();
+    tickSample.steadyTime = std::chrono::steady_clock::now();
+  }
+}
+
+ClockTickScope::~ClockTickScope() {
+  --tickSample.depth;
+}
+
 void sleepFor(std::chrono::microseconds duration) {
-  // Sleep for a bit less than the requested duration to account for inaccuracies
-  constexpr std::chrono::microseconds kSleepInaccuracyMargin = 1500us;
-  auto desiredEndTime = std::chrono::high_resolution_clock::now() + duration;
-  auto desiredSleepEndTime = desiredEndTime - kSleepInaccuracyMargin;
+  sleepUntil(std::chrono::steady_clock::now() + duration);
+}
+
+void sleepUntil(
+    std::chrono::steady_clock::time_point deadline,
+    std::chrono::microseconds spinThreshold) {
+  auto sleepEndTime = deadline - spinThreshold;
 
-  if (std::chrono::high_resolution_clock::now() < desiredSleepEndTime) {
+  if (std::chrono::steady_clock::now() < sleepEndTime) {
+#if defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC on Linux, so its time points can be used directly as an
+    // absolute deadline, which does not drift when the sleep is interrupted and restarted
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        sleepEndTime.time_since_epoch());
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(sinceEpoch.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(sinceEpoch.count() % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#else
 #ifdef _WIN32
     constexpr const UINT kWinTimerPeriod = 1;
     timeBeginPeriod(kWinTimerPeriod);
 #endif
 
-    std::this_thread::sleep_until(desiredSleepEndTime);
+    std::this_thread::sleep_until(sleepEndTime);
 
 #ifdef _WIN32
     timeEndPeriod(kWinTimerPeriod);
+#endif
 #endif
   }
 
   // Busy wait for the remaining time
-  while (std::chrono::high_resolution_clock::now() < desiredEndTime) {
-    // this space intentionally left blank
+  while (std::chrono::steady_clock::now() < deadline) {
+    cpuRelax();
   }
 }
 
@@ -17,19 +17,48 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 
 namespace Xrpa {
 
-inline uint64_t getCurrentClockTimeMicroseconds() {
-  auto duration = std::chrono::system_clock::now().time_since_epoch();
-  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
-}
+// Clock used for all runtime timestamps: system-clock microseconds, so that timestamps compare
+// across processes and language runtimes, but clamped so that they never go backwards within this
+// process. Inside a ClockTickScope this returns the time sampled when the scope was entered.
+uint64_t getCurrentClockTimeMicroseconds();
+
+// Steady-clock counterpart, for pacing rather than timestamps; also sampled per ClockTickScope.
+std::chrono::steady_clock::time_point getCurrentSteadyTime();
+
+// Samples the clocks once for the duration of a transaction or tick, so that writing thousands of
+// change events does not read the clock thousands of times. Scopes nest, with inner scopes
+// keeping the outermost sample; the sample is per thread.
+class ClockTickScope {
+ public:
+  ClockTickScope();
+  ~ClockTickScope();
+
+  ClockTickScope(const ClockTickScope&) = delete;
+  ClockTickScope& operator=(const ClockTickScope&) = delete;
+};
 
 inline uint64_t getCurrentClockTimeNanoseconds() {
   auto duration = std::chrono::system_clock::now().time_since_epoch();
   return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
 }
 
+// Sleeping is only accurate to within the OS timer resolution, so the last part of a sleep is
+// spent spinning. Linux absolute-deadline sleeps are accurate enough to spin for much less.
+#if defined(__linux__)
+constexpr std::chrono::microseconds kDefaultSleepSpinThreshold{100};
+#else
+constexpr std::chrono::microseconds kDefaultSleepSpinThreshold{1500};
+#endif
+
 void sleepFor(std::chrono::microseconds duration);
 
+// Sleeps until the absolute deadline, spinning for the final spinThreshold of the wait.
+void sleepUntil(
+    std::chrono::steady_clock::time_point deadline,
+    std::chrono::microseconds spinThreshold = kDefaultSleepSpinThreshold);
+
 } // namespace Xrpa
@@ -16,9 +16,12 @@
 
 #pragma once
 
+#include <xrpa-runtime/utils/DeadlineScheduler.h>
 #include <xrpa-runtime/utils/TimeUtils.h>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <string>
 
 namespace Xrpa {
 
@@ -33,35 +36,54 @@ class XrpaModule {
     return isRunning_.load();
   }
 
+  // ticks all inputs, the callback and all outputs at the target rate, alongside any tasks added
+  // with addScheduledTask()
   template <typename F>
   void run(int targetFramesPerSecond, F processCallback) {
-    auto targetUpdateMS = std::chrono::milliseconds(int(1000.f / targetFramesPerSecond));
-
-    startTime_ = std::chrono::high_resolution_clock::now();
-    auto lastFrameStartTime = startTime_;
-
-    while (isRunning()) {
-      auto frameStartTime = std::chrono::high_resolution_clock::now();
+    auto lastFrameStartTime = std::chrono::steady_clock::now();
+    scheduler_.addTaskAtRate(kFrameTaskName, targetFramesPerSecond, [&]() {
+      auto frameStartTime = std::chrono::steady_clock::now();
       frameTime_ = std::chrono::duration_cast<std::chrono::microseconds>(
-          lastFrameStartTime - frameStartTime);
+          frameStartTime - lastFrameStartTime);
       lastFrameStartTime = frameStartTime;
 
       tickInputs();
       processCallback();
       tickOutputs();
 
-      auto frameEndTime = std::chrono::high_resolution_clock::now();
-      auto deltaTime =
-          std::chrono::duration_cast<std::chrono::milliseconds>(frameEndTime - frameStartTime);
+      // anything that could not get its transport lock gets one more try before the sleep
+      retryPendingTransactions();
+    });
+
+    run();
 
-      if (deltaTime < targetUpdateMS) {
-        sleepFor(targetUpdateMS - deltaTime);
-      }
-    }
+    // the task references this stack frame
+    scheduler_.removeTask(kFrameTaskName);
+  }
+
+  // runs only the tasks added with addScheduledTask(), each at its own rate; a task will typically
+  // tick one data store's inbound changes, process them, then tick its outbound changes
+  void run() {
+    startTime_ = std::chrono::high_resolution_clock::now();
+    scheduler_.run([this]() { return isRunning(); });
 
     shutdown();
   }
 
+  // deadline is relative to each release time and defaults to the period; see DeadlineScheduler
+  void addScheduledTask(
+      const std::string& name,
+      std::chrono::nanoseconds period,
+      std::function<void()> callback,
+      std::chrono::nanoseconds deadline = std::chrono::nanoseconds{0}) {
+    scheduler_.addTask(name, period, std::move(callback), deadline);
+  }
+
+  // for configuring the spin threshold and reading overrun/jitter statistics
+  DeadlineScheduler& getScheduler() {
+    return scheduler_;
+  }
+
   // safe to call stop() from a different thread, just make sure to join the thread afterwards
   void stop() {
     isRunning_.store(false);
@@ -74,6 +96,10 @@ class XrpaModule {
     tickOutputs();
   }
 
+  // retries data store ticks that timed out waiting on a transport lock earlier in the frame;
+  // tasks added with addScheduledTask() should call this after ticking their data stores
+  virtual void retryPendingTransactions() {}
+
   void checkForUpdates() {
     tickInputs();
   }
@@ -92,9 +118,12 @@ class XrpaModule {
   virtual void tickOutputs() = 0;
 
  private:
+  static constexpr const char* kFrameTaskName = "frame";
+
   std::atomic<bool> isRunning_;
   std::chrono::high_resolution_clock::time_point startTime_;
   std::chrono::microseconds frameTime_{};
+  DeadlineScheduler scheduler_;
 };
 
 } // namespace Xrpa
@@ -50,6 +50,10 @@ class ObjectAccessorInterface {
     return memAccessor_.isNull();
   }
 
+  void checkRecordExtent(int32_t byteCount) const {
+    memAccessor_.checkRecordExtent(byteCount);
+  }
+
  protected:
   MemoryAccessor memAccessor_;
 };
@@ -92,9 +96,73 @@ struct HashValue {
   }
 };
 
+// bits of TransportConfig::mappingFlags
+enum TransportMappingFlags : uint32_t {
+  // back the transport memory with huge pages (transparent huge pages on Linux), cutting the TLB
+  // misses of walking a large changelog
+  MappingHugePages = 1 << 0,
+  // fault the whole transport memory in when the stream is created, rather than on first touch
+  MappingPrefault = 1 << 1,
+  // pin the transport memory in RAM, so a host under memory pressure cannot page it out
+  MappingLockInMemory = 1 << 2,
+};
+
 struct TransportConfig {
   HashValue schemaHash;
   int changelogByteCount{};
+
+  // Single-writer streams only: the changelog is a lock-free SpmcRingBuffer, so neither the writer
+  // nor the readers take the interprocess mutex. The first stream to write claims the changelog and
+  // writes from any other stream fail until it lets go. Not interoperable with the C# and Python
+  // runtimes.
+  bool lockFree = false;
+
+  // Size of each of the two buffers of the writer-maintained snapshot region, 0 to disable it.
+  // When enabled, the writer periodically serializes its full state next to the changelog, and
+  // readers that fall behind the changelog resync from it instead of requesting a full update.
+  // Only kept while a single writer writes to the stream. Locking streams only. Not interoperable
+  // with the C# and Python runtimes.
+  int32_t snapshotByteCount = 0;
+
+  // Name of the TransportLockDomain whose lock the stream uses in place of its own, empty for a
+  // per-stream lock. Every process attached to the stream must configure the same domain. Locking
+  // streams only. Not interoperable with the C# and Python runtimes.
+  std::string lockDomain;
+
+  // Size the changelog may grow to at runtime, 0 for a fixed-size changelog. The whole range is
+  // reserved in the transport memory up front, but pages past the current changelog are not
+  // touched until it grows into them. Each time a reader falls behind and misses entries, the
+  // changelog doubles, up to this size. Locking streams only. Not interoperable with the C# and
+  // Python runtimes.
+  int32_t maxChangelogByteCount = 0;
+
+  // Number of reader cursor slots for lossless backpressure, 0 to disable it. Readers register a
+  // cursor with their read position, and the writer refuses change events that would evict
+  // entries a registered reader has not read yet, instead of silently dropping them from the
+  // changelog. Readers beyond the number of slots read as usual, losing entries if they fall
+  // behind. A reader that stops ticking for the transport expiry time is evicted from its slot.
+  // Locking streams only. Not interoperable with the C# and Python runtimes.
+  int32_t losslessReaderCount = 0;
+
+  // Number of most recent changelog entries indexed by ID, 0 to disable the index. Repositioning
+  // a reader at an indexed entry, as snapshot resyncs and socket streams do, takes constant time
+  // instead of a walk from the oldest entry. Sized at a few times the entries of a typical
+  // transaction, it covers nearly every lookup for 4 bytes per slot. Locking streams only. Not
+  // interoperable with the C# and Python runtimes.
+  int32_t changelogIndexCapacity = 0;
+
+  // Maps the changelog a second time right after itself, so that change events run on past its
+  // end into the mirror rather than wrapping, and no space is skipped at the end of the changelog.
+  // The changelog is rounded up to whole memory pages and cannot grow (maxChangelogByteCount is
+  // ignored). The mirror is only mapped on Linux; elsewhere, or when the process creating the
+  // memory cannot map it, the mirror is plain memory, doubling the memory taken by the changelog.
+  // Locking streams only. Not interoperable with the C# and Python runtimes.
+  bool mirroredChangelog = false;
+
+  // TransportMappingFlags hints for the memory of SharedMemoryTransportStream and
+  // HeapMemoryTransportStream. Whatever the platform cannot honor is skipped; the metrics report
+  // which flags took effect.
+  uint32_t mappingFlags = 0;
 };
 
 struct ObjectUuid {
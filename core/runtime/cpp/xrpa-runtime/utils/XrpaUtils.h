@@ -31,6 +31,31 @@ inline void xrpaDebugBoundsAssert(int accessStart, int accessSize, int minRange,
   }
 }
 
+// Bounds checking policy for MemoryAccessor, selected at build time by defining
+// XRPA_BOUNDS_CHECK_MODE to one of:
+// - XRPA_BOUNDS_CHECK_CHECKED (default): every field read and write is checked
+// - XRPA_BOUNDS_CHECK_CHECKED_ONCE: each record's fixed-size extent is validated once (see
+//   MemoryAccessor::checkRecordExtent()) instead of per field; variable-length data, and any
+//   fields following it in the record, are still checked individually
+// - XRPA_BOUNDS_CHECK_UNCHECKED: no MemoryAccessor checks at all
+// Ring buffer bookkeeping always uses xrpaDebugBoundsAssert() regardless of the mode.
+#define XRPA_BOUNDS_CHECK_UNCHECKED 0
+#define XRPA_BOUNDS_CHECK_CHECKED_ONCE 1
+#define XRPA_BOUNDS_CHECK_CHECKED 2
+
+#ifndef XRPA_BOUNDS_CHECK_MODE
+#define XRPA_BOUNDS_CHECK_MODE XRPA_BOUNDS_CHECK_CHECKED
+#endif
+
+enum class BoundsCheckMode {
+  Unchecked = XRPA_BOUNDS_CHECK_UNCHECKED,
+  CheckedOnce = XRPA_BOUNDS_CHECK_CHECKED_ONCE,
+  Checked = XRPA_BOUNDS_CHECK_CHECKED,
+};
+
+static constexpr BoundsCheckMode kBoundsCheckMode =
+    static_cast<BoundsCheckMode>(XRPA_BOUNDS_CHECK_MODE);
+
 inline void xrpaDebugAssert(bool condition, const char* msg = "Assertion failed") {
   if (!condition) {
     throw std::runtime_error(msg);
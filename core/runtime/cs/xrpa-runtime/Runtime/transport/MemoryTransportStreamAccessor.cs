@@ -22,7 +22,7 @@ namespace Xrpa
     {
         public static readonly int DS_SIZE = 56;
 
-        public const int TRANSPORT_VERSION = 9; // conorwdickinson: heartbeat and expiration
+        public const int TRANSPORT_VERSION = 10; // microsecond change event timestamps
 
         private MemoryAccessor _memSource;
         private MemoryAccessor _memAccessor;
@@ -20,7 +20,9 @@ namespace Xrpa
 
     public class ChangeEventAccessor : ObjectAccessorInterface
     {
-        public static readonly int DS_SIZE = 8;
+        // int32 change type, then the event timestamp as a uint64 microsecond offset from the
+        // transport's baseTimestamp
+        public static readonly int DS_SIZE = 12;
 
         public ChangeEventAccessor() { }
 
@@ -46,13 +48,13 @@ namespace Xrpa
 
         public ulong GetTimestamp(ulong baseTimestampUs)
         {
-            ulong timestampOffsetMs = (ulong)(_memAccessor.ReadInt(new MemoryOffset(4)));
-            return baseTimestampUs + (timestampOffsetMs * 1000);
+            return unchecked(baseTimestampUs + _memAccessor.ReadUlong(new MemoryOffset(4)));
         }
 
         public void SetTimestamp(ulong timestampUs, ulong baseTimestampUs)
         {
-            _memAccessor.WriteInt((int)((timestampUs - baseTimestampUs) / 1000), new MemoryOffset(4));
+            // unsigned wraparound keeps timestamps older than the base exact
+            _memAccessor.WriteUlong(unchecked(timestampUs - baseTimestampUs), new MemoryOffset(4));
         }
     }
 
@@ -21,7 +21,7 @@ from xrpa_runtime.utils.xrpa_types import HashValue, TransportConfig
 
 class MemoryTransportStreamAccessor:
     DS_SIZE = 56
-    TRANSPORT_VERSION = 9  # conorwdickinson: heartbeat and expiration
+    TRANSPORT_VERSION = 10  # microsecond change event timestamps
 
     def __init__(self, source: MemoryAccessor):
         self._mem_source = source
@@ -22,7 +22,9 @@ from xrpa_runtime.utils.xrpa_types import ObjectAccessorInterface
 
 
 class ChangeEventAccessor(ObjectAccessorInterface):
-    DS_SIZE = 8
+    # int32 change type, then the event timestamp as a uint64 microsecond offset from the
+    # transport's base_timestamp
+    DS_SIZE = 12
 
     def __init__(self, mem_accessor: MemoryAccessor = None):
         ObjectAccessorInterface.__init__(self, mem_accessor)
@@ -34,12 +36,13 @@ class ChangeEventAccessor(ObjectAccessorInterface):
         self._mem_accessor.write_int(change_type, MemoryOffset(0))
 
     def get_timestamp(self, base_timestamp_us: int) -> int:
-        timestamp_offset_ms = self._mem_accessor.read_int(MemoryOffset(4))
-        return base_timestamp_us + (timestamp_offset_ms * 1000)
+        timestamp_offset_us = self._mem_accessor.read_ulong(MemoryOffset(4))
+        return (base_timestamp_us + timestamp_offset_us) & 0xFFFFFFFFFFFFFFFF
 
     def set_timestamp(self, timestamp_us: int, base_timestamp_us: int):
-        self._mem_accessor.write_int(
-            (timestamp_us - base_timestamp_us) // 1000, MemoryOffset(4)
+        # unsigned wraparound keeps timestamps older than the base exact
+        self._mem_accessor.write_ulong(
+            (timestamp_us - base_timestamp_us) & 0xFFFFFFFFFFFFFFFF, MemoryOffset(4)
         )
 
 
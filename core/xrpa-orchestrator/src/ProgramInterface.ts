@@ -53,6 +53,7 @@ import { isDataflowStringEmbedding } from "./shared/DataflowProgramDefinition";
 
 
 const DIRECTIONALITY = InheritedProperty("xrpa.directionality");
+const TRANSPORT_LOCK_DOMAIN = "xrpa.transportLockDomain";
 
 export interface XrpaProgramParam<T extends XrpaDataType = XrpaDataType> {
   __isXrpaProgramParam: true;
@@ -189,6 +190,18 @@ export function ProgramOutput(name: string, val: XrpaDataType | XrpaDataflowConn
   return ret;
 }
 
+// The transport streams of all program interfaces in the same lock domain share a single
+// interprocess lock, so a module can tick all of their data stores with one lock acquisition, and
+// changes that must land together are seen together. Only supported by the C++ runtime.
+export function TransportLockDomain(name: string) {
+  const ctx = getProgramInterfaceContext();
+  ctx.properties[TRANSPORT_LOCK_DOMAIN] = name;
+}
+
+export function getTransportLockDomain(programInterface: ProgramInterfaceContext): string | undefined {
+  return programInterface.properties[TRANSPORT_LOCK_DOMAIN] as string | undefined;
+}
+
 export function UppercaseCompanyName(programInterface: ProgramInterface): ProgramInterface {
   return updateImmutable(programInterface, ["companyName"], programInterface.companyName.toUpperCase());
 }
@@ -38,7 +38,7 @@ import {
   isReferenceDataType,
   isStructDataType,
 } from "./InterfaceTypes";
-import { ProgramInterface, getDirectionality, propagatePropertiesToInterface, reverseProgramDirectionality } from "./ProgramInterface";
+import { ProgramInterface, getDirectionality, getTransportLockDomain, propagatePropertiesToInterface, reverseProgramDirectionality } from "./ProgramInterface";
 import { RuntimeEnvironmentContext, getInterfaceTypeMap } from "./RuntimeEnvironment";
 import { evalProperty, isNamedDataType, XrpaDataType } from "./XrpaLanguage";
 
@@ -216,6 +216,7 @@ export function bindProgramInterfaceToModule(
     dataset: programInterface.interfaceName,
     isModuleProgramInterface: !isExternalInterface,
     typeMap: getInterfaceTypeMap(ctx, programInterface),
+    lockDomain: getTransportLockDomain(programInterface),
     datamodel: datamodel => convertProgramInterfaceToDataModel(programInterface, datamodel),
   });
 
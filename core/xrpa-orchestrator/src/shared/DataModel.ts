@@ -44,10 +44,10 @@ function verify<T>(val: T | undefined): T {
 }
 
 // largest is sizeof(CollectionUpdateChangeEventAccessor)
-const CHANGE_EVENT_HEADER_SIZE = 36;
+const CHANGE_EVENT_HEADER_SIZE = 40;
 
 // sizeof(CollectionMessageChangeEventAccessor)
-const MESSAGE_EVENT_HEADER_SIZE = 36;
+const MESSAGE_EVENT_HEADER_SIZE = 40;
 
 // sizeof(SignalPacket)
 const SIGNAL_PACKET_HEADER_SIZE = 16;
@@ -231,6 +231,8 @@ export class DataStoreDefinition {
     readonly isModuleProgramInterface: boolean,
     readonly typeMap: TypeMap,
     apiname?: string,
+    // name of the transport lock domain shared with other data stores, if any
+    readonly lockDomain?: string,
   ) {
     this.apiname = apiname ?? dataset;
     this.datamodel = new DataModelDefinition(moduleDef, this);
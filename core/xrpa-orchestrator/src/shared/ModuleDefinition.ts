@@ -87,9 +87,10 @@ export abstract class ModuleDefinition implements CodeGen {
       isModuleProgramInterface: boolean;
       typeMap?: TypeMap;
       apiname?: string;
+      lockDomain?: string;
       datamodel?: (datamodel: DataModelDefinition) => void;
     }) {
-    const datastore = new DataStoreDefinition(this, params.dataset, params.isModuleProgramInterface, params.typeMap ?? {}, params.apiname);
+    const datastore = new DataStoreDefinition(this, params.dataset, params.isModuleProgramInterface, params.typeMap ?? {}, params.apiname, params.lockDomain);
     this.datastores.push(datastore);
     if (params.datamodel) {
       params.datamodel(datastore.datamodel);
@@ -190,6 +190,16 @@ export const TransportStream: TypeDefinition = new PrimitiveType(
   new EmptyValue(CodeGen, CodeGen.nsJoin(XRPA_NAMESPACE, "TransportStream"), ""),
 );
 
+export const TransportLockDomain: TypeDefinition = new PrimitiveType(
+  CodeGen,
+  "TransportLockDomain",
+  { typename: CodeGen.nsJoin(XRPA_NAMESPACE, "TransportLockDomain"), headerFile: "<xrpa-runtime/transport/TransportLockDomain.h>" },
+  { typename: CodeGen.nsJoin(XRPA_NAMESPACE, "TransportLockDomain"), headerFile: "<xrpa-runtime/transport/TransportLockDomain.h>" },
+  0,
+  true,
+  new EmptyValue(CodeGen, CodeGen.nsJoin(XRPA_NAMESPACE, "TransportLockDomain"), ""),
+);
+
 export const HeapMemoryTransportStream: TypeDefinition = new PrimitiveType(
   CodeGen,
   "HeapMemoryTransportStream",
@@ -210,6 +220,26 @@ export const SharedMemoryTransportStream: TypeDefinition = new PrimitiveType(
   new EmptyValue(CodeGen, CodeGen.nsJoin(XRPA_NAMESPACE, "SharedMemoryTransportStream"), ""),
 );
 
+export const SharedMemorySegment: TypeDefinition = new PrimitiveType(
+  CodeGen,
+  "SharedMemorySegment",
+  { typename: CodeGen.nsJoin(XRPA_NAMESPACE, "SharedMemorySegment"), headerFile: "<xrpa-runtime/transport/SharedMemorySegment.h>" },
+  { typename: CodeGen.nsJoin(XRPA_NAMESPACE, "SharedMemorySegment"), headerFile: "<xrpa-runtime/transport/SharedMemorySegment.h>" },
+  0,
+  true,
+  new EmptyValue(CodeGen, CodeGen.nsJoin(XRPA_NAMESPACE, "SharedMemorySegment"), ""),
+);
+
+export const SharedMemorySegmentTransportStream: TypeDefinition = new PrimitiveType(
+  CodeGen,
+  "SharedMemorySegmentTransportStream",
+  { typename: CodeGen.nsJoin(XRPA_NAMESPACE, "SharedMemorySegmentTransportStream"), headerFile: "<xrpa-runtime/transport/SharedMemorySegmentTransportStream.h>" },
+  { typename: CodeGen.nsJoin(XRPA_NAMESPACE, "SharedMemorySegmentTransportStream"), headerFile: "<xrpa-runtime/transport/SharedMemorySegmentTransportStream.h>" },
+  0,
+  true,
+  new EmptyValue(CodeGen, CodeGen.nsJoin(XRPA_NAMESPACE, "SharedMemorySegmentTransportStream"), ""),
+);
+
 ///////////////////////////////////////////////////////////////////////////////
 // Signals:
 
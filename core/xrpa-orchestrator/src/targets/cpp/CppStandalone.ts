@@ -20,11 +20,12 @@ import path from "path";
 
 import { CodeGen } from "../../shared/CodeGen";
 import { CppModuleDefinition } from "./CppModuleDefinition";
-import { genStandaloneBuck, genStandaloneCpp } from "./GenStandaloneCpp";
+import { genStandaloneBuck, genStandaloneCpp, TransportSegmentConfig } from "./GenStandaloneCpp";
 
 export class CppStandalone implements CodeGen {
   private resourceFilenames: string[] = [];
   private codeGenDeps: CodeGen[] = [];
+  private transportSegment?: TransportSegmentConfig;
 
   constructor(
     readonly moduleDef: CppModuleDefinition,
@@ -39,7 +40,7 @@ export class CppStandalone implements CodeGen {
     }
 
     // generate standalone wrapper files
-    genStandaloneCpp(fileWriter, this.standaloneDir, this.moduleDef);
+    genStandaloneCpp(fileWriter, this.standaloneDir, this.moduleDef, this.transportSegment);
 
     if (this.moduleDef.buckDef) {
       // generate buck file
@@ -57,6 +58,12 @@ export class CppStandalone implements CodeGen {
     this.resourceFilenames.push(filename);
   }
 
+  // multiplexes the transport streams of all data stores into one shared memory segment; see
+  // TransportSegmentConfig
+  public useTransportSegment(name: string, byteCount: number): void {
+    this.transportSegment = { name, byteCount };
+  }
+
   public async getStandaloneTarget(): Promise<string> {
     const buckRoot = await buckRootDir();
     const standaloneRelPath = path.relative(buckRoot, this.standaloneDir);
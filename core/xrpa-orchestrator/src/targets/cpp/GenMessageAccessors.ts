@@ -40,7 +40,7 @@ function genMessageParamInitializer(
   return lines;
 }
 
-function genMessageSize(namespace: string, includes: IncludeAggregator | null, msgType: MessageDataTypeDefinition): string {
+function genMessageSize(namespace: string, includes: IncludeAggregator | null, msgType: MessageDataTypeDefinition): [string, boolean] {
   const dynFieldSizes: string[] = [];
   let staticSize = 0;
 
@@ -54,8 +54,9 @@ function genMessageSize(namespace: string, includes: IncludeAggregator | null, m
     }
   }
 
+  const hasDynamicSize = dynFieldSizes.length > 0;
   dynFieldSizes.push(staticSize.toString());
-  return dynFieldSizes.join(" + ");
+  return [dynFieldSizes.join(" + "), hasDynamicSize];
 }
 
 function genSendMessageBody(params: {
@@ -75,13 +76,24 @@ function genSendMessageBody(params: {
     const messageType = params.typeDef.getFieldIndex(params.fieldName);
     if (params.fieldType.hasFields()) {
       const msgWriteAccessor = params.fieldType.getWriteAccessorType(params.namespace, params.includes);
-      lines.push(
+      const [msgSize, hasDynamicSize] = genMessageSize(params.namespace, params.includes, params.fieldType);
+      const sendLines = [
         `auto message = ${msgWriteAccessor}(collection_->sendMessage(`,
         `    getXrpaId(),`,
         `    ${messageType},`,
-        `    ${genMessageSize(params.namespace, params.includes, params.fieldType)}));`,
+        `    ${msgSize}));`,
         ...genMessageParamInitializer(params.fieldType),
-      );
+      ];
+      if (hasDynamicSize) {
+        // variable-size payloads may be serialized straight into the transport, if the data store opts in
+        lines.push(
+          `collection_->sendDirectMessages([&]() {`,
+          ...indent(1, sendLines),
+          `});`,
+        );
+      } else {
+        lines.push(...sendLines);
+      }
     } else {
       lines.push(
         `collection_->sendMessage(`,
@@ -132,6 +144,7 @@ function genMessageDispatchBody(params: {
     const msgType = typeDef.getFieldIndex(fieldName);
     lines.push(
       `if (messageType == ${msgType}) {`,
+      ...(fieldType.hasFields() ? [`  messageData.checkRecordExtent(${fieldType.getTypeSize().staticSize});`] : []),
       ...indent(1, genMessageDispatch({
         namespace: params.namespace,
         includes: params.includes,
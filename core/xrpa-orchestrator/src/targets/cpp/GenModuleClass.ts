@@ -23,7 +23,7 @@ import { DataStoreDefinition } from "../../shared/DataStore";
 import { IncludeAggregator } from "../../shared/Helpers";
 import { ModuleDefinition } from "../../shared/ModuleDefinition";
 import { CppIncludeAggregator, getDataStoreClass, getDataStoreName, HEADER } from "./CppCodeGenImpl";
-import { TransportStream, XrpaModule } from "./CppDatasetLibraryTypes";
+import { TransportLockDomain, TransportStream, XrpaModule } from "./CppDatasetLibraryTypes";
 
 export function getModuleHeaderName(moduleDef: ModuleDefinition): string {
   return `${moduleDef.name}Module.h`;
@@ -94,6 +94,32 @@ function genModuleSettings(namespace: string, includes: IncludeAggregator, modul
   );
 }
 
+// Data stores sharing a transport lock domain are ticked together inside a single domain
+// transaction, so each direction takes the domain lock once per frame rather than once per store.
+function genDataStoreTicks(moduleDef: ModuleDefinition, namespace: string, includes: IncludeAggregator, tickFunc: string): string[] {
+  const lines: string[] = [];
+  const domainStores: Record<string, DataStoreDefinition[]> = {};
+  for (const storeDef of moduleDef.getDataStores()) {
+    if (storeDef.lockDomain) {
+      if (!domainStores[storeDef.lockDomain]) {
+        domainStores[storeDef.lockDomain] = [];
+      }
+      domainStores[storeDef.lockDomain].push(storeDef);
+    } else {
+      lines.push(`${lowerFirst(getDataStoreName(storeDef.apiname))}->${tickFunc}();`);
+    }
+  }
+
+  for (const lockDomain in domainStores) {
+    lines.push(
+      `${TransportLockDomain.getLocalType(namespace, includes)}::get("${lockDomain}")->transact([&]() {`,
+      ...indent(1, domainStores[lockDomain].map(storeDef => `${lowerFirst(getDataStoreName(storeDef.apiname))}->${tickFunc}();`)),
+      `});`,
+    );
+  }
+  return lines;
+}
+
 export function genModuleClass(fileWriter: FileWriter, libDir: string, moduleDef: ModuleDefinition) {
   const namespace = "";
 
@@ -125,13 +151,17 @@ export function genModuleClass(fileWriter: FileWriter, libDir: string, moduleDef
     ...indent(2, moduleDef.getDataStores().map(storeDef => `${lowerFirst(getDataStoreName(storeDef.apiname))}->shutdown();`)),
     `  }`,
     ``,
+    `  virtual void retryPendingTransactions() override {`,
+    ...indent(2, genDataStoreTicks(moduleDef, namespace, includes, "retryPendingTransactions")),
+    `  }`,
+    ``,
     ` protected:`,
     `  virtual void tickInputs() override {`,
-    ...indent(2, moduleDef.getDataStores().map(storeDef => `${lowerFirst(getDataStoreName(storeDef.apiname))}->tickInbound();`)),
+    ...indent(2, genDataStoreTicks(moduleDef, namespace, includes, "tickInbound")),
     `  }`,
     ``,
     `  virtual void tickOutputs() override {`,
-    ...indent(2, moduleDef.getDataStores().map(storeDef => `${lowerFirst(getDataStoreName(storeDef.apiname))}->tickOutbound();`)),
+    ...indent(2, genDataStoreTicks(moduleDef, namespace, includes, "tickOutbound")),
     `  }`,
     `};`,
     ``,
@@ -37,6 +37,7 @@ export function genProcessUpdateFunctionBody(
   reconcilerDef: InputReconcilerDefinition | OutputReconcilerDefinition,
 ): string[] {
   const lines: string[] = [];
+  const extentTerms: string[] = [];
 
   const typeFields = typeDef.getStateFields();
   for (const fieldName in typeFields) {
@@ -46,6 +47,8 @@ export function genProcessUpdateFunctionBody(
     }
     const checkName = `check${upperFirst(fieldName)}Changed`;
     const funcName = fieldGetterFuncName(CppCodeGenImpl, typeFields, fieldName);
+    const fieldSize = typeDef.getStateField(fieldName).getRuntimeByteCount(defaultFieldToMemberVar(fieldName), ctx.namespace, includes);
+    extentTerms.push(`(value.${checkName}(fieldsChanged) ? ${fieldSize[0]} : 0)`);
     lines.push(
       `if (value.${checkName}(fieldsChanged)) {`,
       `  ${defaultFieldToMemberVar(fieldName)} = value.${funcName}();`,
@@ -57,6 +60,11 @@ export function genProcessUpdateFunctionBody(
     `handleXrpaFieldsChanged(fieldsChanged);`,
   );
 
+  if (extentTerms.length > 0) {
+    // validates the whole change event up front when bounds checks are in checked-once mode
+    lines.unshift(`value.checkRecordExtent(${extentTerms.join(" + ")});`);
+  }
+
   return lines;
 }
 
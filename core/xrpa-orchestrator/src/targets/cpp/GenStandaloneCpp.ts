@@ -23,7 +23,7 @@ import { DataStoreDefinition } from "../../shared/DataStore";
 import { IncludeAggregator } from "../../shared/Helpers";
 import { ModuleDefinition } from "../../shared/ModuleDefinition";
 import { BUCK_HEADER, CppIncludeAggregator, getTypesHeaderName, getTypesHeaderNamespace, HEADER } from "./CppCodeGenImpl";
-import { SharedMemoryTransportStream } from "./CppDatasetLibraryTypes";
+import { SharedMemorySegment, SharedMemorySegmentTransportStream, SharedMemoryTransportStream } from "./CppDatasetLibraryTypes";
 import { ModuleBuckConfig } from "./CppModuleDefinition";
 import { genTransportDeclarations, getInboundTransportVarName, getModuleHeaderName, getOutboundTransportVarName } from "./GenModuleClass";
 
@@ -71,18 +71,36 @@ function genStandaloneHeader(fileWriter: FileWriter, outdir: string) {
   fileWriter.writeFile(path.join(outdir, "Standalone.h"), lines);
 }
 
-export function genTransportInitializer(storeDef: DataStoreDefinition, namespace: string, includes: IncludeAggregator): string[] {
+// Places the transport streams of all of a module's data stores in one shared memory segment,
+// rather than a mapping per stream. Every module that talks to the same data stores must use the
+// same segment name and byte count.
+export interface TransportSegmentConfig {
+  name: string;
+  byteCount: number;
+}
+
+const TRANSPORT_SEGMENT_VAR = "transportSegment";
+
+export function genTransportSegmentInitializer(segmentConfig: TransportSegmentConfig, namespace: string, includes: IncludeAggregator): string[] {
+  return [
+    `auto ${TRANSPORT_SEGMENT_VAR} = std::make_shared<${SharedMemorySegment.getLocalType(namespace, includes)}>("${segmentConfig.name}", ${segmentConfig.byteCount});`,
+  ];
+}
+
+export function genTransportInitializer(storeDef: DataStoreDefinition, namespace: string, includes: IncludeAggregator, segmentConfig?: TransportSegmentConfig): string[] {
   includes.addFile({ filename: getTypesHeaderName(storeDef.apiname) });
   const inboundTransportVar = getInboundTransportVarName(storeDef);
   const outboundTransportVar = getOutboundTransportVarName(storeDef);
   const inboundMemMarker = storeDef.isModuleProgramInterface ? "Input" : "Output";
   const outboundMemMarker = storeDef.isModuleProgramInterface ? "Output" : "Input";
+  const transportType = segmentConfig ? SharedMemorySegmentTransportStream : SharedMemoryTransportStream;
+  const segmentArg = segmentConfig ? `${TRANSPORT_SEGMENT_VAR}, ` : "";
   return [
     `{`,
-    `  auto local${inboundTransportVar} = std::make_shared<${SharedMemoryTransportStream.getLocalType(namespace, includes)}>("${storeDef.dataset}${inboundMemMarker}", ${getTypesHeaderNamespace(storeDef.apiname)}::GenTransportConfig());`,
+    `  auto local${inboundTransportVar} = std::make_shared<${transportType.getLocalType(namespace, includes)}>(${segmentArg}"${storeDef.dataset}${inboundMemMarker}", ${getTypesHeaderNamespace(storeDef.apiname)}::GenTransportConfig());`,
     `  ${inboundTransportVar} = local${inboundTransportVar};`,
     ``,
-    `  auto local${outboundTransportVar} = std::make_shared<${SharedMemoryTransportStream.getLocalType(namespace, includes)}>("${storeDef.dataset}${outboundMemMarker}", ${getTypesHeaderNamespace(storeDef.apiname)}::GenTransportConfig());`,
+    `  auto local${outboundTransportVar} = std::make_shared<${transportType.getLocalType(namespace, includes)}>(${segmentArg}"${storeDef.dataset}${outboundMemMarker}", ${getTypesHeaderNamespace(storeDef.apiname)}::GenTransportConfig());`,
     `  ${outboundTransportVar} = local${outboundTransportVar};`,
     `}`,
   ];
@@ -116,7 +134,8 @@ function genSettingsParsing(moduleDef: ModuleDefinition): string[] {
 function genStandaloneWrapper(
   fileWriter: FileWriter,
   outdir: string,
-  moduleDef: ModuleDefinition
+  moduleDef: ModuleDefinition,
+  segmentConfig?: TransportSegmentConfig,
 ) {
   const moduleClassName = `${moduleDef.name}Module`;
   const namespace = "";
@@ -148,7 +167,8 @@ function genStandaloneWrapper(
     ``,
     `int RunStandalone(int argc, char** argv) {`,
     ...indent(1, genTransportDeclarations(moduleDef, namespace, includes, true)),
-    ...indent(1, moduleDef.getDataStores().map(storeDef => genTransportInitializer(storeDef, namespace, includes))),
+    ...indent(1, segmentConfig ? genTransportSegmentInitializer(segmentConfig, namespace, includes) : []),
+    ...indent(1, moduleDef.getDataStores().map(storeDef => genTransportInitializer(storeDef, namespace, includes, segmentConfig))),
     `  auto moduleData = std::make_unique<${moduleClassName}>(${transportVars.join(", ")});`,
     ...indent(1, genSettingsParsing(moduleDef)),
     ``,
@@ -175,11 +195,12 @@ function genStandaloneWrapper(
 export function genStandaloneCpp(
   fileWriter: FileWriter,
   outdir: string,
-  moduleDef: ModuleDefinition
+  moduleDef: ModuleDefinition,
+  segmentConfig?: TransportSegmentConfig,
 ) {
   genMainStandalone(fileWriter, outdir);
   genStandaloneHeader(fileWriter, outdir);
-  genStandaloneWrapper(fileWriter, outdir, moduleDef);
+  genStandaloneWrapper(fileWriter, outdir, moduleDef, segmentConfig);
 }
 
 export function genStandaloneBuck(
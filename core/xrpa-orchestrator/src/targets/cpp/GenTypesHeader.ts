@@ -31,12 +31,14 @@ function genTransportConfig(
   namespace: string,
   includes: IncludeAggregator,
   hashInit: string,
+  lockDomain: string | undefined,
 ): string[] {
   return [
     `static inline ${TransportConfig.getLocalType(namespace, includes)} GenTransportConfig() {`,
     `  ${TransportConfig.getLocalType(namespace, includes)} config;`,
     `  config.schemaHash = ${HashValue.getLocalType(namespace, includes)}(${hashInit});`,
     `  config.changelogByteCount = ${datamodel.calcChangelogSize()};`,
+    ...(lockDomain ? [`  config.lockDomain = "${lockDomain}";`] : []),
     `  return config;`,
     `}`,
   ]
@@ -108,7 +110,7 @@ export function genTypesHeader(
   const lines = [
     `namespace ${namespace} {`,
     ``,
-    ...genTransportConfig(def.apiname, def.datamodel, namespace, includes, hashInit),
+    ...genTransportConfig(def.apiname, def.datamodel, namespace, includes, hashInit, def.lockDomain),
     ``,
     ...genTypeDefinitions(namespace, def.datamodel, includes),
     `} // namespace ${namespace}`,
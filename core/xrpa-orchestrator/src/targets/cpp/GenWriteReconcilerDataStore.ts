@@ -232,7 +232,6 @@ export function genWriteFunctionBody(params: {
       `  changeBits_ = ${params.reconcilerDef.getOutboundChangeBits()};`,
       `  changeByteCount_ = ${outboundChangeBytes};`,
       `  objAccessor = ${writeAccessor}::create(accessor, getCollectionId(), getXrpaId(), changeByteCount_, createTimestamp_);`,
-      `  createWritten_ = true;`,
       `} else if (changeBits_ != 0) {`,
       `  objAccessor = ${writeAccessor}::update(accessor, getCollectionId(), getXrpaId(), changeBits_, changeByteCount_);`,
       `}`,
@@ -245,6 +244,10 @@ export function genWriteFunctionBody(params: {
     `if (objAccessor.isNull()) {`,
     `  return;`,
     `}`,
+    // only once the create event is in, so that a refused create is written again
+    ...(params.canCreate ? [
+      `createWritten_ = true;`,
+    ] : []),
     ...fieldUpdateLines,
     `changeBits_ = 0;`,
     `changeByteCount_ = 0;`,